@@ -0,0 +1,96 @@
+#include "active.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+bool initActiveRegions(ActiveRegions * const regions, const Board * const board) {
+    regions->nchunkRows = (board->nrows + ACTIVE_CHUNK_ROWS - 1) / ACTIVE_CHUNK_ROWS;
+    regions->nchunkCols = board->wordsPerRow;
+    const size_t nchunks = (size_t) regions->nchunkRows * regions->nchunkCols;
+    regions->changed = (uint8_t *) malloc(nchunks + 1);
+    regions->active = (uint8_t *) malloc(nchunks + 1);
+    // Worst case, every other chunk of a row is active and none are adjacent.
+    regions->runs = (ChunkRun *) malloc((nchunks / 2 + regions->nchunkRows + 1) * sizeof(ChunkRun));
+    regions->nruns = 0;
+    if (regions->changed == NULL || regions->active == NULL || regions->runs == NULL) {
+        destroyActiveRegions(regions);
+        return false;
+    }
+    markAllChunksChanged(regions);
+    return true;
+}
+
+void destroyActiveRegions(ActiveRegions * const regions) {
+    free(regions->changed);
+    free(regions->active);
+    free(regions->runs);
+    regions->changed = NULL;
+    regions->active = NULL;
+    regions->runs = NULL;
+    regions->nruns = 0;
+    regions->nchunkRows = 0;
+    regions->nchunkCols = 0;
+}
+
+void markAllChunksChanged(ActiveRegions * const regions) {
+    memset(regions->changed, 1, (size_t) regions->nchunkRows * regions->nchunkCols);
+}
+
+// Marks the chunks around a changed one at the far side of a torus, which the
+// clamped dilation misses.
+static void markWrappedNeighbours(ActiveRegions * const regions, const unsigned int r, const unsigned int c) {
+    const unsigned int nrows = regions->nchunkRows;
+    const unsigned int ncols = regions->nchunkCols;
+    for (int dr = -1; dr <= 1; ++dr) {
+        for (int dc = -1; dc <= 1; ++dc) {
+            const unsigned int ar = (r + nrows + dr) % nrows;
+            const unsigned int ac = (c + ncols + dc) % ncols;
+            regions->active[(size_t) ar * ncols + ac] = 1;
+        }
+    }
+}
+
+void buildChunkRuns(ActiveRegions * const regions, const bool wrap) {
+    const unsigned int nrows = regions->nchunkRows;
+    const unsigned int ncols = regions->nchunkCols;
+    memset(regions->active, 0, (size_t) nrows * ncols);
+
+    // Dilate the changed chunks by one chunk in every direction.
+    for (unsigned int r = 0; r < nrows; ++r) {
+        const uint8_t * const changed = regions->changed + (size_t) r * ncols;
+        for (unsigned int c = 0; c < ncols; ++c) {
+            if (!changed[c]) {
+                continue;
+            }
+            const unsigned int rowBegin = r > 0 ? r - 1 : 0;
+            const unsigned int rowEnd = r + 1 < nrows ? r + 2 : nrows;
+            const unsigned int colBegin = c > 0 ? c - 1 : 0;
+            const unsigned int colEnd = c + 1 < ncols ? c + 2 : ncols;
+            for (unsigned int ar = rowBegin; ar < rowEnd; ++ar) {
+                memset(regions->active + (size_t) ar * ncols + colBegin, 1, colEnd - colBegin);
+            }
+            if (wrap && (r == 0 || r + 1 == nrows || c == 0 || c + 1 == ncols)) {
+                markWrappedNeighbours(regions, r, c);
+            }
+        }
+    }
+
+    regions->nruns = 0;
+    for (unsigned int r = 0; r < nrows; ++r) {
+        const uint8_t * const active = regions->active + (size_t) r * ncols;
+        unsigned int c = 0;
+        while (c < ncols) {
+            if (!active[c]) {
+                ++c;
+                continue;
+            }
+            ChunkRun * const run = &regions->runs[regions->nruns++];
+            run->chunkRow = r;
+            run->chunkColBegin = c;
+            while (c < ncols && active[c]) {
+                ++c;
+            }
+            run->chunkColEnd = c;
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef CONWAY_ACTIVE_H
+#define CONWAY_ACTIVE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board.h"
+
+// Chunks are ACTIVE_CHUNK_ROWS rows by one board word.
+#define ACTIVE_CHUNK_ROWS BOARD_WORD_BITS
+
+// A horizontal run of adjacent chunks to recompute, in chunk coordinates.
+typedef struct ChunkRun {
+    unsigned int chunkRow;
+    unsigned int chunkColBegin;
+    unsigned int chunkColEnd;
+} ChunkRun;
+
+// Tracks which chunks of a board changed in the last generation, so that a
+// tick need only recompute those and their neighbours.  A chunk whose whole
+// neighbourhood was unchanged can't change either, and since the two boards a
+// simulation alternates between already agree on it, skipping it leaves both
+// correct.
+typedef struct ActiveRegions {
+    unsigned int nchunkRows;
+    unsigned int nchunkCols;
+    // Per chunk, non-zero if it may differ between the current generation and
+    // the one before, including through edits to the board.
+    uint8_t *changed;
+    // Scratch space for buildChunkRuns().
+    uint8_t *active;
+    ChunkRun *runs;
+    size_t nruns;
+} ActiveRegions;
+
+// Sizes the regions for board with every chunk marked changed.  Returns false
+// if allocation fails.
+bool initActiveRegions(ActiveRegions * const regions, const Board * const board);
+
+void destroyActiveRegions(ActiveRegions * const regions);
+
+// Forces every chunk to be recomputed on the next tick, for when the board
+// has been modified wholesale.
+void markAllChunksChanged(ActiveRegions * const regions);
+
+// Forces the chunk holding a tile to be recomputed, along with its neighbours,
+// after the tile was edited directly.
+static inline void markTileChanged(ActiveRegions * const regions, const unsigned int row, const unsigned int col) {
+    regions->changed[(size_t) (row / ACTIVE_CHUNK_ROWS) * regions->nchunkCols + col / BOARD_WORD_BITS] = 1;
+}
+
+// Fills runs with every chunk that changed or neighbours one that did.  With
+// wrap set, chunks on opposite edges of the board neighbour each other, as on
+// a torus.
+void buildChunkRuns(ActiveRegions * const regions, const bool wrap);
+
+#endif
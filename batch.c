@@ -0,0 +1,215 @@
+#include "batch.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "threadpool.h"
+
+// The runs a worker has yet to start, tasks [next, end).  The owner takes
+// them from the front, and thieves take the back half at once, so that a
+// steal is rare and the owner never contends with a thief for the same run.
+typedef struct WorkQueue {
+    pthread_mutex_t mutex;
+    size_t next;
+    size_t end;
+} WorkQueue;
+
+typedef struct BatchWorker {
+    WorkQueue queue;
+    // Reused for every run of the worker.
+    Simulation sim;
+} BatchWorker;
+
+typedef struct Batch {
+    const BatchConfig *config;
+    const BatchTask *tasks;
+    BatchWorker *workers;
+    unsigned int nworkers;
+    BatchResultCallback onResult;
+    void *context;
+    pthread_mutex_t resultMutex;
+} Batch;
+
+static uint64_t splitMix64(uint64_t * const state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// A word of tiles of a soup.  A tile is alive when its random number is below
+// threshold, which is density of the way through the range.
+static BoardWord soupWord(uint64_t * const state, const double density) {
+    if (density >= 1) {
+        return ~(BoardWord) 0;
+    }
+    const uint64_t threshold = (uint64_t) (density * 18446744073709551616.0);
+    BoardWord word = 0;
+    for (unsigned int bit = 0; bit < BOARD_WORD_BITS; ++bit) {
+        word |= (BoardWord) (splitMix64(state) < threshold) << bit;
+    }
+    return word;
+}
+
+void fillSoup(Board * const board, const uint64_t seed, const double density) {
+    clearBoard(board);
+    if (density <= 0) {
+        return;
+    }
+    uint64_t state = seed;
+    const BoardWord mask = lastWordMask(board);
+    for (unsigned int row = 0; row < board->nrows; ++row) {
+        BoardWord * const words = getBoardRow(board, row);
+        for (unsigned int w = 0; w < board->wordsPerRow; ++w) {
+            const BoardWord word = soupWord(&state, density);
+            words[w] = w == board->wordsPerRow - 1 ? word & mask : word;
+            board->nalive += popcountWord(words[w]);
+        }
+    }
+}
+
+void fillSoupRect(Board * const board, const uint64_t seed, const double density, const unsigned int rowBegin,
+                  const unsigned int rowEnd, const unsigned int colBegin, const unsigned int colEnd) {
+    fillBoardRect(board, DEAD, rowBegin, rowEnd, colBegin, colEnd);
+    if (density <= 0 || rowBegin >= rowEnd || colBegin >= colEnd) {
+        return;
+    }
+    uint64_t state = seed;
+    const unsigned int wordBegin = colBegin / BOARD_WORD_BITS;
+    const unsigned int wordEnd = (colEnd - 1) / BOARD_WORD_BITS + 1;
+    for (unsigned int row = rowBegin; row < rowEnd; ++row) {
+        BoardWord * const words = getBoardRow(board, row);
+        for (unsigned int w = wordBegin; w < wordEnd; ++w) {
+            const BoardWord word = soupWord(&state, density) & columnsMask(w, colBegin, colEnd);
+            words[w] |= word;
+            board->nalive += popcountWord(word);
+        }
+    }
+}
+
+static bool takeTask(WorkQueue * const queue, size_t * const task) {
+    pthread_mutex_lock(&queue->mutex);
+    const bool found = queue->next < queue->end;
+    if (found) {
+        *task = queue->next++;
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    return found;
+}
+
+// Moves the back half of the first other worker's queue that isn't empty to
+// thief's own, which is empty.  Returns false if every queue was empty, in
+// which case there is nothing left to start.
+static bool stealTasks(Batch * const batch, const unsigned int thief) {
+    for (unsigned int i = 1; i < batch->nworkers; ++i) {
+        WorkQueue * const victim = &batch->workers[(thief + i) % batch->nworkers].queue;
+        pthread_mutex_lock(&victim->mutex);
+        const size_t remaining = victim->end - victim->next;
+        const size_t end = victim->end;
+        victim->end -= (remaining + 1) / 2;
+        const size_t begin = victim->end;
+        pthread_mutex_unlock(&victim->mutex);
+        if (remaining == 0) {
+            continue;
+        }
+
+        WorkQueue * const own = &batch->workers[thief].queue;
+        pthread_mutex_lock(&own->mutex);
+        own->next = begin;
+        own->end = end;
+        pthread_mutex_unlock(&own->mutex);
+        return true;
+    }
+    return false;
+}
+
+static void runTask(Batch * const batch, Simulation * const sim, const BatchTask * const task) {
+    const BatchConfig * const config = batch->config;
+    fillSoup(&sim->logicalBoard, task->seed, task->density);
+    restartSimulation(sim);
+    BatchResult result = {*task, 0, 0, 0};
+    while (sim->tick < config->maxGenerations) {
+        if (!stepSimulationUpTo(sim, config->maxGenerations - sim->tick)) {
+            result.period = 1;
+            break;
+        }
+        if (sim->cyclePeriod != 0) {
+            result.period = sim->cyclePeriod;
+            break;
+        }
+    }
+    result.generations = sim->tick;
+    result.population = sim->logicalBoard.nalive;
+
+    pthread_mutex_lock(&batch->resultMutex);
+    batch->onResult(batch->context, &result);
+    pthread_mutex_unlock(&batch->resultMutex);
+}
+
+static void runWorker(void *context, const unsigned int worker, const unsigned int nworkers) {
+    (void) nworkers;
+    Batch * const batch = (Batch *) context;
+    BatchWorker * const self = &batch->workers[worker];
+    while (true) {
+        size_t task;
+        if (takeTask(&self->queue, &task)) {
+            runTask(batch, &self->sim, &batch->tasks[task]);
+        } else if (!stealTasks(batch, worker)) {
+            return;
+        }
+    }
+}
+
+static bool initBatchWorker(BatchWorker * const worker, const BatchConfig * const config) {
+    Board board;
+    if (!initBoard(&board, config->nrows, config->ncols)) {
+        return false;
+    }
+    Simulation * const sim = &worker->sim;
+    bool ok = initSimulation(sim, board);
+    sim->engine = config->engine;
+    sim->recordChanges = false;
+    sim->trackActiveRegions = config->trackActiveRegions;
+    setSimulationTopology(sim, config->topology);
+    ok = ok && setSimulationRule(sim, config->rule) && setSimulationCycleLimit(sim, config->maxPeriod);
+    if (!ok) {
+        destroySimulation(sim);
+        return false;
+    }
+    pthread_mutex_init(&worker->queue.mutex, NULL);
+    return true;
+}
+
+bool runBatch(const BatchConfig * const config, const BatchTask * const tasks, const size_t ntasks,
+              BatchResultCallback onResult, void *context) {
+    unsigned int nworkers = config->jobs == 0 ? availableProcessors() : config->jobs;
+    if (nworkers > ntasks) {
+        nworkers = ntasks == 0 ? 1 : (unsigned int) ntasks;
+    }
+    Batch batch = {config, tasks, NULL, 0, onResult, context, PTHREAD_MUTEX_INITIALIZER};
+    batch.workers = (BatchWorker *) calloc(nworkers, sizeof(BatchWorker));
+    ThreadPool * const pool = batch.workers != NULL ? createThreadPool(nworkers) : NULL;
+    bool ok = pool != NULL;
+    for (; ok && batch.nworkers < nworkers; ++batch.nworkers) {
+        BatchWorker * const worker = &batch.workers[batch.nworkers];
+        if (!initBatchWorker(worker, config)) {
+            ok = false;
+            break;
+        }
+        // Each worker starts with an equal share of the tasks, in order.
+        worker->queue.next = ntasks * batch.nworkers / nworkers;
+        worker->queue.end = ntasks * (batch.nworkers + 1) / nworkers;
+    }
+
+    if (ok) {
+        runOnThreadPool(pool, runWorker, &batch);
+    }
+    destroyThreadPool(pool);
+    for (unsigned int i = 0; i < batch.nworkers; ++i) {
+        destroySimulation(&batch.workers[i].sim);
+        pthread_mutex_destroy(&batch.workers[i].queue.mutex);
+    }
+    free(batch.workers);
+    pthread_mutex_destroy(&batch.resultMutex);
+    return ok;
+}
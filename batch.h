@@ -0,0 +1,70 @@
+#ifndef CONWAY_BATCH_H
+#define CONWAY_BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board.h"
+#include "rule.h"
+#include "simulation.h"
+
+// Batches of independent headless runs of random soups, for parameter
+// sweeps.  Runs are spread over a pool of workers that each own one
+// simulation, reused for every run they do, and that steal runs from each
+// other once their own share is done, so a few long-lived soups don't leave
+// the rest of the pool idle.
+
+// One soup to run.
+typedef struct BatchTask {
+    uint64_t seed;
+    // Fraction of tiles alive at the start, in [0, 1].
+    double density;
+} BatchTask;
+
+// What every run of a batch has in common.
+typedef struct BatchConfig {
+    unsigned int nrows;
+    unsigned int ncols;
+    StepEngine engine;
+    LifeRule rule;
+    Topology topology;
+    bool trackActiveRegions;
+    // Runs that haven't stabilised after this many generations are stopped.
+    uint64_t maxGenerations;
+    // Longest period of oscillation recognised as stable.
+    unsigned int maxPeriod;
+    // Workers, including the calling thread, 0 for one per processor.
+    unsigned int jobs;
+} BatchConfig;
+
+typedef struct BatchResult {
+    BatchTask task;
+    // Generations run: until the board first repeated an earlier state, or
+    // maxGenerations if it never did.
+    uint64_t generations;
+    unsigned int population;
+    // Period the board settled into, 1 for a still life, or 0 if it didn't
+    // within maxGenerations.
+    unsigned int period;
+} BatchResult;
+
+// Called once per run, in whatever order the runs finish, never by two
+// workers at once.
+typedef void (*BatchResultCallback)(void *context, const BatchResult * const result);
+
+// Fills board with a random soup of the given density, the same for the same
+// seed on every host.
+void fillSoup(Board * const board, const uint64_t seed, const double density);
+
+// As fillSoup(), over rows [rowBegin, rowEnd) and columns [colBegin, colEnd)
+// only, leaving the rest of the board as it was.
+void fillSoupRect(Board * const board, const uint64_t seed, const double density, const unsigned int rowBegin,
+                  const unsigned int rowEnd, const unsigned int colBegin, const unsigned int colEnd);
+
+// Runs every task and returns once they are all done.  Returns false, having
+// run none of them, if the workers or their simulations can't be created.
+bool runBatch(const BatchConfig * const config, const BatchTask * const tasks, const size_t ntasks,
+              BatchResultCallback onResult, void *context);
+
+#endif
@@ -0,0 +1,405 @@
+// conway-bench: runs every stepping engine over a fixed set of workloads and
+// prints the timings as JSON, so that runs can be compared across releases.
+// Each case runs in a child process of its own, so that its peak resident set
+// size is its own.
+
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "gpu.h"
+#include "packed.h"
+#include "scheduler.h"
+#include "simulation.h"
+#include "threadpool.h"
+
+// A starting board and how long to run it for.
+typedef struct Workload {
+    const char *name;
+    unsigned int nrows;
+    unsigned int ncols;
+    uint64_t generations;
+    // Percentage of live tiles in a random soup, or 0 for a pattern.
+    unsigned int density;
+    // Rows of a pattern in plaintext, NULL terminated, placed copies times
+    // over a grid of the board.
+    const char * const *pattern;
+    unsigned int copies;
+    // Too big for the engines that step a tile at a time to finish in
+    // reasonable time, so they are left out.
+    bool large;
+} Workload;
+
+static const char * const gosperGun[] = {
+    "........................O",
+    "......................O.O",
+    "............OO......OO............OO",
+    "...........O...O....OO............OO",
+    "OO........O.....O...OO",
+    "OO........O...O.OO....O.O",
+    "..........O.....O.......O",
+    "...........O...O",
+    "............OO",
+    NULL
+};
+
+static const char * const rPentomino[] = {
+    ".OO",
+    "OO.",
+    ".O.",
+    NULL
+};
+
+static const char * const acorn[] = {
+    ".O.....",
+    "...O...",
+    "OO..OOO",
+    NULL
+};
+
+static const Workload workloads[] = {
+    {"soup-10", 1024, 1024, 200, 10, NULL, 0, false},
+    {"soup-25", 1024, 1024, 200, 25, NULL, 0, false},
+    {"soup-50", 1024, 1024, 200, 50, NULL, 0, false},
+    {"gosper-gun", 512, 512, 1000, 0, gosperGun, 1, false},
+    {"r-pentomino", 1024, 1024, 500, 0, rPentomino, 1, false},
+    {"acorn", 1024, 1024, 500, 0, acorn, 1, false},
+    {"sparse-acorns", 8192, 8192, 500, 0, acorn, 16, true},
+};
+
+#define NUM_WORKLOADS (sizeof(workloads) / sizeof(workloads[0]))
+
+// An engine as configured for a case.
+typedef struct BenchEngine {
+    const char *name;
+    StepEngine engine;
+    bool trackActiveRegions;
+    // 0 for one thread per processor.
+    unsigned int threads;
+    bool tileAtATime;
+    // Steps with temporal blocking, at the depth that runs fastest on the
+    // workload.
+    bool temporal;
+} BenchEngine;
+
+static const BenchEngine engines[] = {
+    {"reference", ENGINE_REFERENCE, false, 1, true, false},
+    {"scalar", ENGINE_SCALAR, false, 1, true, false},
+    {"packed-full-sweep", ENGINE_PACKED, false, 1, false, false},
+    {"packed", ENGINE_PACKED, true, 1, false, false},
+    {"packed-threaded", ENGINE_PACKED, true, 0, false, false},
+    {"packed-temporal", ENGINE_PACKED, false, 1, false, true},
+    {"packed-temporal-threaded", ENGINE_PACKED, false, 0, false, true},
+    {"hashlife", ENGINE_HASHLIFE, false, 1, false, false},
+    {"sparse", ENGINE_SPARSE, false, 1, false, false},
+    {"gpu", ENGINE_GPU, false, 1, false, false},
+};
+
+#define NUM_ENGINES (sizeof(engines) / sizeof(engines[0]))
+
+// The temporal depths tried for the temporal engines, each for
+// TUNING_GENERATIONS generations, or the run's if it is shorter, before the
+// run proper.
+static const unsigned int temporalDepths[] = {2, 4, 8, 16, 32, 64};
+#define NUM_TEMPORAL_DEPTHS (sizeof(temporalDepths) / sizeof(temporalDepths[0]))
+#define TUNING_GENERATIONS 128
+
+typedef struct BenchResult {
+    bool ok;
+    unsigned int threads;
+    // Chosen by tuning, for the temporal engines.
+    unsigned int temporalDepth;
+    uint64_t generations;
+    uint64_t nanos;
+    unsigned int population;
+    long peakRssKb;
+} BenchResult;
+
+static uint64_t nextRandom(uint64_t * const state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void placePattern(Board * const board, const char * const * const pattern, const unsigned int row,
+                         const unsigned int col) {
+    for (unsigned int r = 0; pattern[r] != NULL; ++r) {
+        for (unsigned int c = 0; pattern[r][c] != '\0'; ++c) {
+            if (pattern[r][c] == 'O' && row + r < board->nrows && col + c < board->ncols) {
+                setTileState(board, ALIVE, row + r, col + c);
+            }
+        }
+    }
+}
+
+static bool buildBoard(const Workload * const workload, Board * const board) {
+    if (!initBoard(board, workload->nrows, workload->ncols)) {
+        return false;
+    }
+    if (workload->density != 0) {
+        uint64_t state = 0x9e3779b97f4a7c15u;
+        for (unsigned int row = 0; row < board->nrows; ++row) {
+            for (unsigned int col = 0; col < board->ncols; ++col) {
+                if (nextRandom(&state) % 100 < workload->density) {
+                    setTileState(board, ALIVE, row, col);
+                }
+            }
+        }
+        return true;
+    }
+    // Copies are spread over the smallest square grid that holds them, each
+    // in the middle of its cell.
+    unsigned int side = 1;
+    while (side * side < workload->copies) {
+        ++side;
+    }
+    for (unsigned int i = 0; i < workload->copies; ++i) {
+        const unsigned int row = (i / side) * (board->nrows / side) + board->nrows / side / 2;
+        const unsigned int col = (i % side) * (board->ncols / side) + board->ncols / side / 2;
+        placePattern(board, workload->pattern, row, col);
+    }
+    return true;
+}
+
+// Builds the workload's board into a simulation configured for engine.
+static bool startCase(const Workload * const workload, const BenchEngine * const engine,
+                      const unsigned int temporalDepth, Simulation * const sim) {
+    Board board;
+    if (!buildBoard(workload, &board)) {
+        return false;
+    }
+    if (!initSimulation(sim, board)) {
+        destroySimulation(sim);
+        return false;
+    }
+    sim->engine = engine->engine;
+    sim->recordChanges = false;
+    sim->trackActiveRegions = engine->trackActiveRegions;
+    sim->temporalDepth = temporalDepth;
+    if (!setSimulationThreads(sim, engine->threads == 0 ? availableProcessors() : engine->threads)) {
+        destroySimulation(sim);
+        return false;
+    }
+    return true;
+}
+
+// Steps sim until generations, or a still life, and returns how long it took.
+static uint64_t stepCase(Simulation * const sim, const uint64_t generations) {
+    const uint64_t start = monotonicNanos();
+    while (sim->tick < generations && stepSimulationUpTo(sim, generations - sim->tick)) {}
+    return monotonicNanos() - start;
+}
+
+// Tries each temporal depth on the start of the workload and returns the
+// fastest, or 0 if no simulation could be started.
+static unsigned int tuneTemporalDepth(const Workload * const workload, const BenchEngine * const engine,
+                                      const uint64_t generations) {
+    const uint64_t tuning = generations < TUNING_GENERATIONS ? generations : TUNING_GENERATIONS;
+    unsigned int best = 0;
+    uint64_t bestNanos = UINT64_MAX;
+    for (size_t i = 0; i < NUM_TEMPORAL_DEPTHS; ++i) {
+        Simulation sim;
+        if (!startCase(workload, engine, temporalDepths[i], &sim)) {
+            return 0;
+        }
+        const uint64_t nanos = stepCase(&sim, tuning);
+        destroySimulation(&sim);
+        if (nanos < bestNanos) {
+            best = temporalDepths[i];
+            bestNanos = nanos;
+        }
+    }
+    return best;
+}
+
+static BenchResult runCase(const Workload * const workload, const BenchEngine * const engine,
+                           const uint64_t generations) {
+    BenchResult result = {0};
+    if (engine->temporal && (result.temporalDepth = tuneTemporalDepth(workload, engine, generations)) == 0) {
+        return result;
+    }
+    Simulation sim;
+    if (!startCase(workload, engine, result.temporalDepth, &sim)) {
+        return result;
+    }
+    result.nanos = stepCase(&sim, generations);
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    result.ok = true;
+    result.threads = simulationThreads(&sim);
+    // A still life ends a run early.
+    result.generations = sim.tick;
+    result.population = sim.logicalBoard.nalive;
+    result.peakRssKb = usage.ru_maxrss;
+    destroySimulation(&sim);
+    return result;
+}
+
+// Runs a case in a child process and reads back its result.
+static BenchResult runCaseIsolated(const Workload * const workload, const BenchEngine * const engine,
+                                   const uint64_t generations) {
+    BenchResult result = {0};
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return result;
+    }
+    fflush(stdout);
+    const pid_t pid = fork();
+    if (pid == -1) {
+        close(fds[0]);
+        close(fds[1]);
+        return result;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        result = runCase(workload, engine, generations);
+        const bool written = write(fds[1], &result, sizeof(result)) == (ssize_t) sizeof(result);
+        _exit(written ? 0 : 1);
+    }
+    close(fds[1]);
+    ssize_t got;
+    while ((got = read(fds[0], &result, sizeof(result))) == -1 && errno == EINTR) {}
+    close(fds[0]);
+    int status;
+    waitpid(pid, &status, 0);
+    if (got != (ssize_t) sizeof(result) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        result = (BenchResult) {0};
+    }
+    return result;
+}
+
+static void printResult(const Workload * const workload, const BenchEngine * const engine,
+                        const BenchResult * const result, const bool first) {
+    const double seconds = (double) result->nanos / NANOS_PER_SEC;
+    const double cells = (double) workload->nrows * workload->ncols * (double) result->generations;
+    printf("%s    {\"workload\": \"%s\", \"engine\": \"%s\", \"rows\": %u, \"cols\": %u, ", first ? "" : ",\n",
+           workload->name, engine->name, workload->nrows, workload->ncols);
+    if (!result->ok) {
+        printf("\"error\": \"failed to run\"}");
+        return;
+    }
+    printf("\"threads\": %u, ", result->threads);
+    if (engine->temporal) {
+        printf("\"temporal_depth\": %u, ", result->temporalDepth);
+    }
+    printf("\"generations\": %" PRIu64 ", \"seconds\": %.6f, ", result->generations, seconds);
+    printf("\"ns_per_generation\": %.1f, \"cell_updates_per_sec\": %.4g, ",
+           result->generations == 0 ? 0.0 : (double) result->nanos / (double) result->generations,
+           seconds == 0 ? 0.0 : cells / seconds);
+    printf("\"population\": %u, \"peak_rss_kb\": %ld}", result->population, result->peakRssKb);
+}
+
+static void printUsage(FILE * const out) {
+    fprintf(out,
+            "usage: conway-bench [options]\n"
+            "  --workload NAME     run only this workload\n"
+            "  --engine NAME       run only this engine\n"
+            "  --generations N     override every workload's generation count\n"
+            "  --kernel NAME       packed kernel: auto (default), scalar, avx2, avx512 or neon\n"
+            "  --list              list the workloads and engines\n"
+            "  --help              show this message\n");
+}
+
+static void listCases(void) {
+    printf("workloads:\n");
+    for (size_t i = 0; i < NUM_WORKLOADS; ++i) {
+        printf("  %-16s %ux%u, %" PRIu64 " generations\n", workloads[i].name, workloads[i].nrows,
+               workloads[i].ncols, workloads[i].generations);
+    }
+    printf("engines:\n");
+    for (size_t i = 0; i < NUM_ENGINES; ++i) {
+        printf("  %s\n", engines[i].name);
+    }
+}
+
+int main(const int argc, char * const argv[]) {
+    enum { OPT_WORKLOAD = 256, OPT_ENGINE, OPT_GENERATIONS, OPT_KERNEL, OPT_LIST, OPT_HELP };
+    static const struct option longOptions[] = {
+        {"workload", required_argument, NULL, OPT_WORKLOAD},
+        {"engine", required_argument, NULL, OPT_ENGINE},
+        {"generations", required_argument, NULL, OPT_GENERATIONS},
+        {"kernel", required_argument, NULL, OPT_KERNEL},
+        {"list", no_argument, NULL, OPT_LIST},
+        {"help", no_argument, NULL, OPT_HELP},
+        {NULL, 0, NULL, 0}
+    };
+
+    const char *workloadName = NULL;
+    const char *engineName = NULL;
+    uint64_t generations = 0;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", longOptions, NULL)) != -1) {
+        switch (opt) {
+        case OPT_WORKLOAD:
+            workloadName = optarg;
+            break;
+        case OPT_ENGINE:
+            engineName = optarg;
+            break;
+        case OPT_GENERATIONS: {
+            char *end;
+            errno = 0;
+            generations = strtoull(optarg, &end, 10);
+            if (errno != 0 || end == optarg || *end != '\0' || generations == 0) {
+                fprintf(stderr, "conway-bench: invalid generation count '%s'\n", optarg);
+                return 2;
+            }
+            break;
+        }
+        case OPT_KERNEL:
+            if (!selectPackedKernel(optarg)) {
+                fprintf(stderr, "conway-bench: kernel '%s' is unknown or unsupported by this CPU\n", optarg);
+                return 2;
+            }
+            break;
+        case OPT_LIST:
+            listCases();
+            return 0;
+        case OPT_HELP:
+            printUsage(stdout);
+            return 0;
+        default:
+            printUsage(stderr);
+            return 2;
+        }
+    }
+    if (optind != argc) {
+        printUsage(stderr);
+        return 2;
+    }
+
+    printf("{\n  \"kernel\": \"%s\",\n  \"processors\": %u,\n  \"results\": [\n", packedKernelName(),
+           availableProcessors());
+    bool first = true;
+    bool anyFailed = false;
+    const bool gpuAvailable = findGpuDevice(NULL, 0);
+    for (size_t w = 0; w < NUM_WORKLOADS; ++w) {
+        if (workloadName != NULL && strcmp(workloadName, workloads[w].name) != 0) {
+            continue;
+        }
+        for (size_t e = 0; e < NUM_ENGINES; ++e) {
+            if ((engineName != NULL && strcmp(engineName, engines[e].name) != 0)
+                    || (workloads[w].large && engines[e].tileAtATime)
+                    || (engines[e].engine == ENGINE_GPU && !gpuAvailable)) {
+                continue;
+            }
+            const uint64_t n = generations != 0 ? generations : workloads[w].generations;
+            const BenchResult result = runCaseIsolated(&workloads[w], &engines[e], n);
+            printResult(&workloads[w], &engines[e], &result, first);
+            fflush(stdout);
+            anyFailed |= !result.ok;
+            first = false;
+        }
+    }
+    printf("%s  ]\n}\n", first ? "" : "\n");
+    return anyFailed ? 1 : 0;
+}
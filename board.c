@@ -0,0 +1,266 @@
+#include "board.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+// Maps bytes, rounded up to whole huge pages, aligned to a huge page so that
+// transparent huge pages can back all of it.  Returns NULL where there is no
+// anonymous mmap() or it fails, leaving the heap to allocate the board.
+static BoardWord *mapStorage(const size_t bytes, size_t * const mappedBytes) {
+#ifdef MAP_ANONYMOUS
+    const size_t length = (bytes + BOARD_MAPPING_BYTES - 1) / BOARD_MAPPING_BYTES * BOARD_MAPPING_BYTES;
+#ifdef MAP_HUGETLB
+    // Only succeeds if huge pages have been reserved for the taking.
+    void *mapping = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (mapping != MAP_FAILED) {
+        *mappedBytes = length;
+        return (BoardWord *) mapping;
+    }
+#endif
+    // Over-map by a huge page, and trim the ends off to align it.
+    char * const base = (char *) mmap(NULL, length + BOARD_MAPPING_BYTES, PROT_READ | PROT_WRITE,
+                                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == (char *) MAP_FAILED) {
+        return NULL;
+    }
+    const size_t skip = (BOARD_MAPPING_BYTES - (uintptr_t) base % BOARD_MAPPING_BYTES) % BOARD_MAPPING_BYTES;
+    if (skip != 0) {
+        munmap(base, skip);
+    }
+    munmap(base + skip + length, BOARD_MAPPING_BYTES - skip);
+#ifdef MADV_HUGEPAGE
+    madvise(base + skip, length, MADV_HUGEPAGE);
+#endif
+    *mappedBytes = length;
+    return (BoardWord *) (base + skip);
+#else
+    (void) bytes;
+    (void) mappedBytes;
+    return NULL;
+#endif
+}
+
+bool boardStorageWords(const unsigned int nrows, const unsigned int ncols, size_t * const nwords) {
+    const size_t rowStride = ((size_t) ncols + BOARD_WORD_BITS - 1) / BOARD_WORD_BITS + 2;
+    const size_t rows = (size_t) nrows + 2;
+    if (rows > SIZE_MAX / sizeof(BoardWord) / rowStride) {
+        return false;
+    }
+    *nwords = rows * rowStride;
+    return true;
+}
+
+bool initBoard(Board * const board, const unsigned int nrows, const unsigned int ncols) {
+    board->nrows = nrows;
+    board->ncols = ncols;
+    board->wordsPerRow = (unsigned int) (((size_t) ncols + BOARD_WORD_BITS - 1) / BOARD_WORD_BITS);
+    board->rowStride = board->wordsPerRow + 2;
+    board->nalive = 0;
+    size_t nwords = 0;
+    const bool sized = boardStorageWords(nrows, ncols, &nwords);
+    board->mappedBytes = 0;
+    board->storage = NULL;
+    if (sized && nwords * sizeof(BoardWord) >= BOARD_MAPPING_BYTES) {
+        board->storage = mapStorage(nwords * sizeof(BoardWord), &board->mappedBytes);
+    }
+    if (sized && board->storage == NULL) {
+        board->storage = (BoardWord *) calloc(nwords, sizeof(BoardWord));
+    }
+    if (board->storage == NULL) {
+        board->words = NULL;
+        board->nrows = 0;
+        board->ncols = 0;
+        board->wordsPerRow = 0;
+        board->rowStride = 0;
+        return false;
+    }
+    board->words = board->storage + board->rowStride + 1;
+    return true;
+}
+
+void destroyBoard(Board * const board) {
+    if (board->mappedBytes != 0) {
+        munmap(board->storage, board->mappedBytes);
+    } else {
+        free(board->storage);
+    }
+    board->storage = NULL;
+    board->mappedBytes = 0;
+    board->words = NULL;
+    board->nrows = 0;
+    board->ncols = 0;
+    board->wordsPerRow = 0;
+    board->rowStride = 0;
+    board->nalive = 0;
+}
+
+void clearBoard(Board * const board) {
+    for (unsigned int row = 0; row < board->nrows; ++row) {
+        memset(getBoardRow(board, row), 0, board->wordsPerRow * sizeof(BoardWord));
+    }
+    board->nalive = 0;
+}
+
+void copyBoardRows(Board * const dst, const Board * const src, const unsigned int rowBegin,
+                   const unsigned int rowEnd) {
+    if (rowBegin >= rowEnd) {
+        return;
+    }
+    // Rows of storage, counting the halo row above the board as row 0.
+    const size_t first = rowBegin == 0 ? 0 : (size_t) rowBegin + 1;
+    const size_t last = rowEnd == src->nrows ? (size_t) rowEnd + 2 : (size_t) rowEnd + 1;
+    memcpy(dst->storage + first * src->rowStride, src->storage + first * src->rowStride,
+           (last - first) * src->rowStride * sizeof(BoardWord));
+}
+
+bool copyBoard(Board * const dst, const Board * const src) {
+    if (dst->storage == NULL || dst->nrows != src->nrows || dst->ncols != src->ncols) {
+        destroyBoard(dst);
+        if (!initBoard(dst, src->nrows, src->ncols)) {
+            return false;
+        }
+    }
+    memcpy(dst->storage, src->storage, (size_t) (src->nrows + 2) * src->rowStride * sizeof(BoardWord));
+    dst->nalive = src->nalive;
+    return true;
+}
+
+void fillBoardHalo(Board * const board, const Topology topology) {
+    const unsigned int nwords = board->wordsPerRow;
+    if (board->nrows == 0 || nwords == 0) {
+        return;
+    }
+    BoardWord * const top = getBoardRow(board, 0) - board->rowStride;
+    BoardWord * const bottom = getBoardRow(board, board->nrows);
+    if (topology == TOPOLOGY_BOUNDED) {
+        for (unsigned int row = 0; row < board->nrows; ++row) {
+            BoardWord * const words = getBoardRow(board, row);
+            words[-1] = 0;
+            words[nwords] = 0;
+        }
+        memset(top - 1, 0, board->rowStride * sizeof(BoardWord));
+        memset(bottom - 1, 0, board->rowStride * sizeof(BoardWord));
+        return;
+    }
+
+    // Columns first, so that the corners come along with the rows.
+    const unsigned int lastCol = board->ncols - 1;
+    const unsigned int rem = board->ncols % BOARD_WORD_BITS;
+    for (unsigned int row = 0; row < board->nrows; ++row) {
+        BoardWord * const words = getBoardRow(board, row);
+        const BoardWord first = words[0] & 1;
+        const BoardWord last = (words[lastCol / BOARD_WORD_BITS] >> (lastCol % BOARD_WORD_BITS)) & 1;
+        words[-1] = last << (BOARD_WORD_BITS - 1);
+        if (rem == 0) {
+            words[nwords] = first;
+        } else {
+            words[nwords - 1] = (words[nwords - 1] & lastWordMask(board)) | first << rem;
+        }
+    }
+    memcpy(top - 1, getBoardRow(board, board->nrows - 1) - 1, board->rowStride * sizeof(BoardWord));
+    memcpy(bottom - 1, getBoardRow(board, 0) - 1, board->rowStride * sizeof(BoardWord));
+}
+
+void clearBoardPadding(Board * const board) {
+    if (board->ncols % BOARD_WORD_BITS == 0) {
+        return;
+    }
+    const BoardWord mask = lastWordMask(board);
+    for (unsigned int row = 0; row < board->nrows; ++row) {
+        getBoardRow(board, row)[board->wordsPerRow - 1] &= mask;
+    }
+}
+
+static const char * const topologyNames[] = {
+    [TOPOLOGY_BOUNDED] = "bounded",
+    [TOPOLOGY_TORUS] = "torus",
+};
+
+bool parseTopology(const char * const name, Topology * const topology) {
+    for (size_t i = 0; i < sizeof(topologyNames) / sizeof(topologyNames[0]); ++i) {
+        if (strcmp(name, topologyNames[i]) == 0) {
+            *topology = (Topology) i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *topologyName(const Topology topology) {
+    return topologyNames[topology];
+}
+
+// Works a source word at a time: each lands in at most two destination words.
+void blitBoard(Board * const dst, const Board * const src, const unsigned int row, const unsigned int col) {
+    if (col >= dst->ncols) {
+        return;
+    }
+    const unsigned int width = src->ncols < dst->ncols - col ? src->ncols : dst->ncols - col;
+    const unsigned int shift = col % BOARD_WORD_BITS;
+    for (unsigned int r = 0; r < src->nrows && row + r < dst->nrows; ++r) {
+        const BoardWord * const from = getBoardRow(src, r);
+        BoardWord * const to = getBoardRow(dst, row + r);
+        for (unsigned int c = 0; c < width; c += BOARD_WORD_BITS) {
+            const unsigned int n = width - c < BOARD_WORD_BITS ? width - c : BOARD_WORD_BITS;
+            const BoardWord mask = n == BOARD_WORD_BITS ? ~(BoardWord) 0 : ((BoardWord) 1 << n) - 1;
+            const BoardWord tiles = from[c / BOARD_WORD_BITS] & mask;
+            const unsigned int w = (col + c) / BOARD_WORD_BITS;
+            dst->nalive -= popcountWord(to[w] & (mask << shift));
+            to[w] = (to[w] & ~(mask << shift)) | tiles << shift;
+            dst->nalive += popcountWord(tiles << shift);
+            if (shift != 0 && (mask >> (BOARD_WORD_BITS - shift)) != 0) {
+                const BoardWord high = mask >> (BOARD_WORD_BITS - shift);
+                dst->nalive -= popcountWord(to[w + 1] & high);
+                to[w + 1] = (to[w + 1] & ~high) | tiles >> (BOARD_WORD_BITS - shift);
+                dst->nalive += popcountWord(tiles >> (BOARD_WORD_BITS - shift));
+            }
+        }
+    }
+}
+
+void fillBoardRect(Board * const board, const TileState state, const unsigned int rowBegin,
+                   const unsigned int rowEnd, const unsigned int colBegin, const unsigned int colEnd) {
+    if (rowBegin >= rowEnd || colBegin >= colEnd) {
+        return;
+    }
+    const unsigned int wordBegin = colBegin / BOARD_WORD_BITS;
+    const unsigned int wordEnd = (colEnd - 1) / BOARD_WORD_BITS + 1;
+    for (unsigned int row = rowBegin; row < rowEnd; ++row) {
+        BoardWord * const words = getBoardRow(board, row);
+        for (unsigned int w = wordBegin; w < wordEnd; ++w) {
+            const BoardWord mask = columnsMask(w, colBegin, colEnd);
+            board->nalive -= popcountWord(words[w] & mask);
+            if (state == ALIVE) {
+                words[w] |= mask;
+                board->nalive += popcountWord(mask);
+            } else {
+                words[w] &= ~mask;
+            }
+        }
+    }
+}
+
+bool cropBoard(Board * const dst, const Board * const src, const unsigned int row, const unsigned int col,
+               const unsigned int nrows, const unsigned int ncols) {
+    if (!initBoard(dst, nrows, ncols)) {
+        return false;
+    }
+    const unsigned int shift = col % BOARD_WORD_BITS;
+    const BoardWord mask = lastWordMask(dst);
+    for (unsigned int r = 0; r < nrows; ++r) {
+        // The word after the last of a row is its halo word, so can always be
+        // read, and what it holds lies past ncols.
+        const BoardWord * const from = getBoardRow(src, row + r) + col / BOARD_WORD_BITS;
+        BoardWord * const to = getBoardRow(dst, r);
+        for (unsigned int w = 0; w < dst->wordsPerRow; ++w) {
+            BoardWord word = from[w] >> shift;
+            if (shift != 0) {
+                word |= from[w + 1] << (BOARD_WORD_BITS - shift);
+            }
+            to[w] = w == dst->wordsPerRow - 1 ? word & mask : word;
+            dst->nalive += popcountWord(to[w]);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,174 @@
+#ifndef CONWAY_BOARD_H
+#define CONWAY_BOARD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum TileState {
+    DEAD = 0, ALIVE = 1
+} TileState;
+
+// Boards are bit-packed, one bit per tile.  Bit i of word w of a row holds the
+// tile in column w * BOARD_WORD_BITS + i, so shifting a word left moves every
+// tile one column east.
+typedef uint64_t BoardWord;
+#define BOARD_WORD_BITS 64
+
+// How the tiles at the edges of a board are connected.
+typedef enum Topology {
+    // Everything beyond the edges is dead.
+    TOPOLOGY_BOUNDED,
+    // Opposite edges are neighbours.
+    TOPOLOGY_TORUS
+} Topology;
+
+// Logical board representation, storing rows of packed TileStates.  Bits past
+// ncols in the last word of each row are zero between generations.
+//
+// The rows are surrounded by a halo one tile deep: a row above the first and
+// below the last, and a word before the first and after the last of every
+// row, so that steppers can read every neighbour of every tile without
+// checking for the edges.  fillBoardHalo() sets it up for a topology.
+typedef struct Board {
+    unsigned int nrows;
+    unsigned int ncols;
+    unsigned int wordsPerRow;
+    // Distance between rows, wordsPerRow plus the halo words.
+    unsigned int rowStride;
+    // Word 0 of row 0, inside the halo.
+    BoardWord *words;
+    BoardWord *storage;
+    // Bytes of storage mapped by initBoard(), or 0 if it came from the heap.
+    size_t mappedBytes;
+    unsigned int nalive;
+} Board;
+
+typedef struct Point {
+    unsigned int row;
+    unsigned int col;
+} Point;
+
+// Allocates an all-dead board of the given dimensions.  Returns false if the
+// allocation fails, in which case the board is left empty.
+//
+// Boards of BOARD_MAPPING_BYTES or more are mapped straight from the kernel,
+// on 2 MB huge pages if any are reserved and otherwise asking for transparent
+// ones, so that the TLB covers far more of them.  None of their pages is
+// placed until it is first written, when it goes to the NUMA node of the
+// thread writing it; see copyBoardRows().
+bool initBoard(Board * const board, const unsigned int nrows, const unsigned int ncols);
+
+#define BOARD_MAPPING_BYTES ((size_t) 2 * 1024 * 1024)
+
+// Sets *nwords to the words of storage, halo included, of a board of nrows by
+// ncols tiles.  Returns false if its bytes wouldn't fit in a size_t.
+bool boardStorageWords(const unsigned int nrows, const unsigned int ncols, size_t * const nwords);
+
+void destroyBoard(Board * const board);
+
+static inline BoardWord *getBoardRow(const Board * const board, const unsigned int row) {
+    return board->words + (size_t) row * board->rowStride;
+}
+
+// Kills every tile.
+void clearBoard(Board * const board);
+
+// Copies rows [rowBegin, rowEnd) of src into dst, which must be the same size,
+// along with their halo words, and the halo rows above and below if the range
+// reaches the edge.  Copying a board into a fresh one by bands, each band on
+// the thread that will go on to use it, places each band's pages on that
+// thread's NUMA node.
+void copyBoardRows(Board * const dst, const Board * const src, const unsigned int rowBegin,
+                   const unsigned int rowEnd);
+
+// Makes dst an exact copy of src, reallocating it only if their dimensions
+// differ.  Returns false, leaving dst empty, if that allocation fails.
+bool copyBoard(Board * const dst, const Board * const src);
+
+// Makes the halo hold what lies beyond each edge under topology: nothing for
+// TOPOLOGY_BOUNDED, or the tiles of the opposite edge for TOPOLOGY_TORUS.  The
+// tile east of the last column of a torus is the first tile past ncols, so
+// with a partial last word this sets that padding bit until
+// clearBoardPadding() is called.
+void fillBoardHalo(Board * const board, const Topology topology);
+
+// Restores the zero bits past ncols after fillBoardHalo().
+void clearBoardPadding(Board * const board);
+
+static inline unsigned int popcountWord(const BoardWord word) {
+    return (unsigned int) __builtin_popcountll(word);
+}
+
+// Index of the lowest set bit of a non-zero word.
+static inline unsigned int lowestBitIndex(const BoardWord word) {
+    return (unsigned int) __builtin_ctzll(word);
+}
+
+// Index of the highest set bit of a non-zero word.
+static inline unsigned int highestBitIndex(const BoardWord word) {
+    return BOARD_WORD_BITS - 1 - (unsigned int) __builtin_clzll(word);
+}
+
+// Mask of the bits of a row's last word that hold tiles.
+static inline BoardWord lastWordMask(const Board * const board) {
+    const unsigned int rem = board->ncols % BOARD_WORD_BITS;
+    return rem == 0 ? ~(BoardWord) 0 : ((BoardWord) 1 << rem) - 1;
+}
+
+static inline TileState getTileState(const Board * const board, const unsigned int row, const unsigned int col) {
+    return (TileState) ((getBoardRow(board, row)[col / BOARD_WORD_BITS] >> (col % BOARD_WORD_BITS)) & 1);
+}
+
+// As getTileState(), but also reaches into the halo: row may be -1 or nrows,
+// and col -1 or ncols.
+static inline TileState getHaloTileState(const Board * const board, const int row, const int col) {
+    const BoardWord * const words = board->words + (ptrdiff_t) row * board->rowStride;
+    const int x = col + BOARD_WORD_BITS;
+    return (TileState) ((words[x / BOARD_WORD_BITS - 1] >> (x % BOARD_WORD_BITS)) & 1);
+}
+
+static inline void setTileState(Board * const board, TileState val, const unsigned int row, const unsigned int col) {
+    BoardWord * const word = &getBoardRow(board, row)[col / BOARD_WORD_BITS];
+    const BoardWord bit = (BoardWord) 1 << (col % BOARD_WORD_BITS);
+    const bool prevAlive = (*word & bit) != 0;
+    if (val == ALIVE) {
+        *word |= bit;
+        board->nalive += !prevAlive;
+    } else {
+        *word &= ~bit;
+        board->nalive -= prevAlive;
+    }
+}
+
+// Looks up a topology by its command line name, "bounded" or "torus".
+// Returns false if there is no such topology.
+bool parseTopology(const char * const name, Topology * const topology);
+
+const char *topologyName(const Topology topology);
+
+// Copies the tiles of src into dst with src's top left corner placed at
+// (row, col).  Tiles falling outside of dst are clipped.
+void blitBoard(Board * const dst, const Board * const src, const unsigned int row, const unsigned int col);
+
+// Mask of the bits of word w of a row that hold columns [colBegin, colEnd).
+static inline BoardWord columnsMask(const unsigned int w, const unsigned int colBegin, const unsigned int colEnd) {
+    const unsigned int first = w * BOARD_WORD_BITS;
+    const unsigned int begin = colBegin > first ? colBegin - first : 0;
+    const unsigned int end = colEnd - first < BOARD_WORD_BITS ? colEnd - first : BOARD_WORD_BITS;
+    const BoardWord below = end == BOARD_WORD_BITS ? ~(BoardWord) 0 : ((BoardWord) 1 << end) - 1;
+    return below & ~(((BoardWord) 1 << begin) - 1);
+}
+
+// Sets the tiles of rows [rowBegin, rowEnd) and columns [colBegin, colEnd) to
+// state, a word of tiles at a time.  The rectangle must lie within the board.
+void fillBoardRect(Board * const board, const TileState state, const unsigned int rowBegin,
+                   const unsigned int rowEnd, const unsigned int colBegin, const unsigned int colEnd);
+
+// Makes dst a copy of the nrows by ncols tiles of src from (row, col), which
+// must lie within src, shifting whole words into place.  Returns false,
+// leaving dst empty, if it can't be allocated.
+bool cropBoard(Board * const dst, const Board * const src, const unsigned int row, const unsigned int col,
+               const unsigned int nrows, const unsigned int ncols);
+
+#endif
@@ -0,0 +1,234 @@
+#include "census.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Sum of the indices of the set bits of a word: bit k of each index is
+// counted by the popcount of the bits whose index has bit k set.
+static inline unsigned int bitIndexSum(const BoardWord word) {
+    static const BoardWord indexBits[] = {
+        0xaaaaaaaaaaaaaaaau, 0xccccccccccccccccu, 0xf0f0f0f0f0f0f0f0u,
+        0xff00ff00ff00ff00u, 0xffff0000ffff0000u, 0xffffffff00000000u
+    };
+    unsigned int sum = 0;
+    for (unsigned int k = 0; k < sizeof(indexBits) / sizeof(indexBits[0]); ++k) {
+        sum += popcountWord(word & indexBits[k]) << k;
+    }
+    return sum;
+}
+
+static unsigned int halve(const unsigned int n) {
+    return (n + 1) / 2;
+}
+
+bool initBoardCensus(BoardCensus * const census, const Board * const board) {
+    memset(census, 0, sizeof(*census));
+    census->nchunkRows = (board->nrows + ACTIVE_CHUNK_ROWS - 1) / ACTIVE_CHUNK_ROWS;
+    census->nchunkCols = board->wordsPerRow;
+    const size_t nchunks = (size_t) census->nchunkRows * census->nchunkCols;
+    census->nlevels = 1;
+    for (unsigned int rows = census->nchunkRows, cols = census->nchunkCols; rows > 1 || cols > 1;
+         rows = halve(rows), cols = halve(cols)) {
+        ++census->nlevels;
+    }
+    census->rowSums = (uint64_t *) calloc(nchunks, sizeof(uint64_t));
+    census->colSums = (uint64_t *) calloc(nchunks, sizeof(uint64_t));
+    census->chunkRowPopulation = (uint64_t *) calloc(census->nchunkRows, sizeof(uint64_t));
+    census->chunkColPopulation = (uint64_t *) calloc(census->nchunkCols, sizeof(uint64_t));
+    census->levels = (uint64_t **) calloc(census->nlevels, sizeof(uint64_t *));
+    census->levelRows = (unsigned int *) calloc(census->nlevels, sizeof(unsigned int));
+    census->levelCols = (unsigned int *) calloc(census->nlevels, sizeof(unsigned int));
+    census->dirty = (uint8_t *) calloc(nchunks, sizeof(uint8_t));
+    census->dirtyChunks = (size_t *) malloc(nchunks * sizeof(size_t));
+    bool ok = census->rowSums != NULL && census->colSums != NULL && census->chunkRowPopulation != NULL
+            && census->chunkColPopulation != NULL && census->levels != NULL && census->levelRows != NULL
+            && census->levelCols != NULL && census->dirty != NULL && census->dirtyChunks != NULL;
+    unsigned int rows = census->nchunkRows;
+    unsigned int cols = census->nchunkCols;
+    for (unsigned int level = 0; ok && level < census->nlevels; ++level) {
+        census->levelRows[level] = rows;
+        census->levelCols[level] = cols;
+        census->levels[level] = (uint64_t *) calloc((size_t) rows * cols, sizeof(uint64_t));
+        ok = census->levels[level] != NULL || (size_t) rows * cols == 0;
+        rows = halve(rows);
+        cols = halve(cols);
+    }
+    if (!ok) {
+        destroyBoardCensus(census);
+        return false;
+    }
+    censusBoardChanged(census);
+    updateBoardCensus(census, board);
+    return true;
+}
+
+void destroyBoardCensus(BoardCensus * const census) {
+    for (unsigned int level = 0; census->levels != NULL && level < census->nlevels; ++level) {
+        free(census->levels[level]);
+    }
+    free(census->levels);
+    free(census->levelRows);
+    free(census->levelCols);
+    free(census->rowSums);
+    free(census->colSums);
+    free(census->chunkRowPopulation);
+    free(census->chunkColPopulation);
+    free(census->dirty);
+    free(census->dirtyChunks);
+    memset(census, 0, sizeof(*census));
+}
+
+void censusChunkChanged(BoardCensus * const census, const size_t chunk) {
+    if (!census->allDirty && !census->dirty[chunk]) {
+        census->dirty[chunk] = 1;
+        census->dirtyChunks[census->ndirty++] = chunk;
+    }
+}
+
+void censusTileChanged(BoardCensus * const census, const unsigned int row, const unsigned int col) {
+    censusChunkChanged(census, (size_t) (row / ACTIVE_CHUNK_ROWS) * census->nchunkCols + col / BOARD_WORD_BITS);
+}
+
+void censusBoardChanged(BoardCensus * const census) {
+    census->allDirty = true;
+}
+
+// Rows [rowBegin, rowEnd) of a chunk row of board.
+static void chunkRows(const Board * const board, const unsigned int chunkRow, unsigned int * const rowBegin,
+                      unsigned int * const rowEnd) {
+    *rowBegin = chunkRow * ACTIVE_CHUNK_ROWS;
+    *rowEnd = *rowBegin + ACTIVE_CHUNK_ROWS < board->nrows ? *rowBegin + ACTIVE_CHUNK_ROWS : board->nrows;
+}
+
+// A word of board, without the padding past ncols.
+static inline BoardWord liveWord(const Board * const board, const unsigned int row, const unsigned int w) {
+    const BoardWord word = getBoardRow(board, row)[w];
+    return w == board->wordsPerRow - 1 ? word & lastWordMask(board) : word;
+}
+
+// Counts a chunk afresh and rolls the change in its tallies up.
+static void recountChunk(BoardCensus * const census, const Board * const board, const size_t chunk) {
+    const unsigned int chunkRow = (unsigned int) (chunk / census->nchunkCols);
+    const unsigned int chunkCol = (unsigned int) (chunk % census->nchunkCols);
+    unsigned int rowBegin, rowEnd;
+    chunkRows(board, chunkRow, &rowBegin, &rowEnd);
+    uint64_t population = 0;
+    uint64_t rowSum = 0;
+    uint64_t colSum = 0;
+    for (unsigned int row = rowBegin; row < rowEnd; ++row) {
+        const BoardWord word = liveWord(board, row, chunkCol);
+        if (word == 0) {
+            continue;
+        }
+        const unsigned int count = popcountWord(word);
+        population += count;
+        rowSum += (uint64_t) row * count;
+        colSum += (uint64_t) chunkCol * BOARD_WORD_BITS * count + bitIndexSum(word);
+    }
+
+    const uint64_t delta = population - census->levels[0][chunk];
+    census->population += delta;
+    census->chunkRowPopulation[chunkRow] += delta;
+    census->chunkColPopulation[chunkCol] += delta;
+    for (unsigned int level = 0; level < census->nlevels; ++level) {
+        const size_t region = (size_t) (chunkRow >> level) * census->levelCols[level] + (chunkCol >> level);
+        census->levels[level][region] += delta;
+    }
+    census->rowSum += rowSum - census->rowSums[chunk];
+    census->colSum += colSum - census->colSums[chunk];
+    census->rowSums[chunk] = rowSum;
+    census->colSums[chunk] = colSum;
+}
+
+// The tallies are unsigned, so changes wrap around and come out right.
+void updateBoardCensus(BoardCensus * const census, const Board * const board) {
+    if (census->allDirty) {
+        const size_t nchunks = (size_t) census->nchunkRows * census->nchunkCols;
+        for (size_t chunk = 0; chunk < nchunks; ++chunk) {
+            recountChunk(census, board, chunk);
+        }
+    } else {
+        for (size_t i = 0; i < census->ndirty; ++i) {
+            recountChunk(census, board, census->dirtyChunks[i]);
+        }
+    }
+    for (size_t i = 0; i < census->ndirty; ++i) {
+        census->dirty[census->dirtyChunks[i]] = 0;
+    }
+    census->ndirty = 0;
+    census->allDirty = false;
+}
+
+static unsigned int firstNonZero(const uint64_t * const values) {
+    unsigned int i = 0;
+    while (values[i] == 0) {
+        ++i;
+    }
+    return i;
+}
+
+static unsigned int lastNonZero(const uint64_t * const values, const unsigned int n) {
+    unsigned int i = n - 1;
+    while (values[i] == 0) {
+        --i;
+    }
+    return i;
+}
+
+// Whether chunk (chunkRow, chunkCol) has any live tiles.
+static inline bool chunkLive(const BoardCensus * const census, const unsigned int chunkRow,
+                             const unsigned int chunkCol) {
+    return census->levels[0][(size_t) chunkRow * census->nchunkCols + chunkCol] != 0;
+}
+
+CensusSummary censusSummary(const BoardCensus * const census, const Board * const board) {
+    CensusSummary summary = {census->population, 0, 0, 0, 0, 0.0, 0.0};
+    if (census->population == 0) {
+        return summary;
+    }
+    summary.centroidRow = (double) census->rowSum / (double) census->population;
+    summary.centroidCol = (double) census->colSum / (double) census->population;
+
+    const unsigned int topChunk = firstNonZero(census->chunkRowPopulation);
+    const unsigned int bottomChunk = lastNonZero(census->chunkRowPopulation, census->nchunkRows);
+    const unsigned int leftChunk = firstNonZero(census->chunkColPopulation);
+    const unsigned int rightChunk = lastNonZero(census->chunkColPopulation, census->nchunkCols);
+    summary.top = board->nrows;
+    summary.left = board->ncols;
+    for (unsigned int chunkCol = 0; chunkCol < census->nchunkCols; ++chunkCol) {
+        unsigned int rowBegin, rowEnd;
+        if (chunkLive(census, topChunk, chunkCol)) {
+            chunkRows(board, topChunk, &rowBegin, &rowEnd);
+            for (unsigned int row = rowBegin; row < rowEnd && row < summary.top; ++row) {
+                if (liveWord(board, row, chunkCol) != 0) {
+                    summary.top = row;
+                }
+            }
+        }
+        if (chunkLive(census, bottomChunk, chunkCol)) {
+            chunkRows(board, bottomChunk, &rowBegin, &rowEnd);
+            for (unsigned int row = rowEnd; row > rowBegin && row > summary.bottom + 1; --row) {
+                if (liveWord(board, row - 1, chunkCol) != 0) {
+                    summary.bottom = row - 1;
+                }
+            }
+        }
+    }
+    for (unsigned int chunkRow = 0; chunkRow < census->nchunkRows; ++chunkRow) {
+        const bool leftLive = chunkLive(census, chunkRow, leftChunk);
+        const bool rightLive = chunkLive(census, chunkRow, rightChunk);
+        unsigned int rowBegin, rowEnd;
+        chunkRows(board, chunkRow, &rowBegin, &rowEnd);
+        for (unsigned int row = rowBegin; (leftLive || rightLive) && row < rowEnd; ++row) {
+            const BoardWord left = liveWord(board, row, leftChunk);
+            const BoardWord right = liveWord(board, row, rightChunk);
+            if (leftLive && left != 0 && leftChunk * BOARD_WORD_BITS + lowestBitIndex(left) < summary.left) {
+                summary.left = leftChunk * BOARD_WORD_BITS + lowestBitIndex(left);
+            }
+            if (rightLive && right != 0 && rightChunk * BOARD_WORD_BITS + highestBitIndex(right) > summary.right) {
+                summary.right = rightChunk * BOARD_WORD_BITS + highestBitIndex(right);
+            }
+        }
+    }
+    return summary;
+}
@@ -0,0 +1,95 @@
+#ifndef CONWAY_CENSUS_H
+#define CONWAY_CENSUS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "active.h"
+#include "board.h"
+
+// Population statistics of a board kept up to date from the chunks that
+// change rather than by rescanning it.  The board is cut into the same chunks
+// as ActiveRegions, each of which keeps its population and the sums of the
+// rows and columns of its live tiles, counted a word at a time with popcounts.
+// A recounted chunk adds the change in its tallies to every total it rolls up
+// into: its chunk row and column, each level of a pyramid of ever larger
+// square regions, and the whole board.  Chunks are only recounted once marked
+// dirty, and then not until the census is next read.
+typedef struct BoardCensus {
+    unsigned int nchunkRows;
+    unsigned int nchunkCols;
+    // Per chunk, the sums of the rows and columns of its live tiles.
+    uint64_t *rowSums;
+    uint64_t *colSums;
+    // Population of every chunk row and every chunk column.
+    uint64_t *chunkRowPopulation;
+    uint64_t *chunkColPopulation;
+    // Level k holds the population of each square region of 2^k by 2^k
+    // chunks, row major, so level 0 has the population of each chunk and the
+    // last level that of the whole board.
+    unsigned int nlevels;
+    uint64_t **levels;
+    unsigned int *levelRows;
+    unsigned int *levelCols;
+    uint64_t population;
+    uint64_t rowSum;
+    uint64_t colSum;
+    // Chunks to recount, listed once each, or all of them.
+    uint8_t *dirty;
+    size_t *dirtyChunks;
+    size_t ndirty;
+    bool allDirty;
+} BoardCensus;
+
+// The census of a board at a moment, from censusSummary().
+typedef struct CensusSummary {
+    uint64_t population;
+    // Smallest rectangle holding every live tile, rows [top, bottom] and
+    // columns [left, right], if population isn't 0.
+    unsigned int top;
+    unsigned int left;
+    unsigned int bottom;
+    unsigned int right;
+    // Mean row and column of the live tiles, if population isn't 0.
+    double centroidRow;
+    double centroidCol;
+} CensusSummary;
+
+// Sizes the census for board and counts all of it.  Returns false if
+// allocation fails, leaving the census empty.
+bool initBoardCensus(BoardCensus * const census, const Board * const board);
+
+void destroyBoardCensus(BoardCensus * const census);
+
+// Marks the chunk holding a tile to be recounted, after the tile changed.
+void censusTileChanged(BoardCensus * const census, const unsigned int row, const unsigned int col);
+
+// As censusTileChanged(), for a chunk by its index in row major order.
+void censusChunkChanged(BoardCensus * const census, const size_t chunk);
+
+// Marks every chunk to be recounted, for when any part of the board may
+// have changed.
+void censusBoardChanged(BoardCensus * const census);
+
+// Recounts the dirty chunks of board, which must be the board the census was
+// sized for.  Costs a few popcounts per word of each dirty chunk.
+void updateBoardCensus(BoardCensus * const census, const Board * const board);
+
+// The population, bounding box and centroid of board, as of the last
+// updateBoardCensus().  The bounding box is found from the chunk row and
+// column totals and then by scanning only the live chunks on its edges.
+CensusSummary censusSummary(const BoardCensus * const census, const Board * const board);
+
+// The populations of the regions of level, each of (ACTIVE_CHUNK_ROWS << level)
+// rows by (BOARD_WORD_BITS << level) columns of the board (less along its
+// bottom and right edges), in a grid of nrows by ncols, as of the last
+// updateBoardCensus().  level must be less than nlevels.
+static inline const uint64_t *censusRegions(const BoardCensus * const census, const unsigned int level,
+                                            unsigned int * const nrows, unsigned int * const ncols) {
+    *nrows = census->levelRows[level];
+    *ncols = census->levelCols[level];
+    return census->levels[level];
+}
+
+#endif
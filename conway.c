@@ -1,80 +1,145 @@
 #include <stdlib.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <locale.h>
+#include <stdio.h>
+#include <string.h>
 #include <curses.h>
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
 
-typedef enum TileState {
-    DEAD = 0, ALIVE = 1
-} TileState;
+#include "batch.h"
+#include "board.h"
+#include "census.h"
+#include "framering.h"
+#include "gpu.h"
+#include "hashlife.h"
+#include "packed.h"
+#include "pattern.h"
+#include "rule.h"
+#include "scheduler.h"
+#include "simulation.h"
+#include "snapshot.h"
+#include "sparse.h"
+#include "stats.h"
+#include "stream.h"
+#include "temporal.h"
+#include "threadpool.h"
+#include "zoom.h"
 
-// Logical board representation, storing an array of TileStates
-typedef struct Board {
+// Command line configuration.  Zero values mean "not given".
+typedef struct Options {
+    bool headless;
+    // Batch mode runs a random soup for every pair of seed and density.
+    bool batch;
+    const char *seeds;
+    const char *densities;
+    // Batch workers, 0 for one per processor.
+    unsigned int jobs;
+    uint64_t generations;
+    const char *inputPath;
+    const char *restorePath;
+    const char *checkpointPath;
+    uint64_t checkpointEvery;
     unsigned int nrows;
     unsigned int ncols;
-    TileState *tiles;
-    unsigned int nalive;
-} Board;
-
-typedef struct Point {
-    unsigned int row;
-    unsigned int col;
-} Point;
-
-// TileChanges are stored in the simulation pass of each tick.
-// This allows for only the single linear pass, and then only the changes
-// made where necessary.
-typedef struct TileChange {
-    Point point;
-    TileState newState;
-} TileChange;
-
-// Node for TileChangeStack.  Would be declared in a different implementation
-// file if this were a multi-file project, because it's an implementation detail of
-// TileChangeStack.
-typedef struct TileChangeNode {
-    TileChange change;
-    struct TileChangeNode *next;
-} TileChangeNode;
-
-// Data structure for storing TileChanges during a tick.  In a multi-file project
-// this would be forward declared in a header and defined in a different
-// implementation file to enforce modularity, as its definition is an implementation
-// detail.
-typedef struct TileChangeStack {
-    TileChangeNode *top;
-} TileChangeStack;
-
-void pushTileChange(TileChangeStack *stack, TileChange change) {
-    TileChangeNode *newNode = (TileChangeNode *) malloc(sizeof(TileChangeNode));
-    newNode->change = change;
-    newNode->next = stack->top;
-    stack->top = newNode;
-}
-
-bool tileChangeStackIsEmpty(TileChangeStack *stack) {
-    return stack->top == NULL;
-}
-
-TileChange popTileChange(TileChangeStack *stack) {
-    TileChangeNode *prevTop = stack->top;
-    stack->top = prevTop->next;
-    TileChange result = prevTop->change;
-    free(prevTop);
-    return result;
-}
-
-// State of the entire game, including both model and view.  This isn't an
-// ideal design, as it prevents some const qualifications.
+    StepEngine engine;
+    bool engineGiven;
+    unsigned int threads;
+    bool fullSweep;
+    unsigned int stepLog2;
+    unsigned int temporalDepth;
+    size_t hashlifeMemoryLimit;
+    LifeRule rule;
+    bool ruleGiven;
+    Topology topology;
+    bool topologyGiven;
+    unsigned int framesPerSec;
+    Zoom zoom;
+    // Headless tick stats go here, "-" being stdout.
+    const char *statsPath;
+    uint64_t statsEvery;
+    StatsFormat statsFormat;
+    // Headless stats records and the summary include the census.
+    bool census;
+    // Headless frames of every streamEvery'th generation go here; see
+    // createFrameStream().
+    const char *streamPath;
+    uint64_t streamEvery;
+    StreamFormat streamFormat;
+    // Runs stop once the board cycles with at most this period, unless 0.
+    unsigned int maxPeriod;
+} Options;
+
+// A rectangle of tiles, rows [rowBegin, rowEnd) and columns [colBegin,
+// colEnd).
+typedef struct TileRect {
+    unsigned int rowBegin;
+    unsigned int rowEnd;
+    unsigned int colBegin;
+    unsigned int colEnd;
+} TileRect;
+
+// State of the interactive game.  The model lives entirely in simulation, so
+// that it can be run without any of the curses view below.
 typedef struct GameState {
-    Board logicalBoard;
-    // Where the physical curser points on the logical/physical board
+    Simulation simulation;
+    // Where the physical curser points on the physical board, in characters
     Point logicalCur;
-    // This window has an identical coordinate system to the logicalBoard
+    // While selecting, the selection is the rectangle of characters between
+    // selectionAnchor and logicalCur.
+    bool selecting;
+    Point selectionAnchor;
+    // Tiles copied from a selection or loaded from a pattern file, to paste.
+    Board clipboard;
+    // Percentage of live tiles in random fills.
+    unsigned int fillPercent;
+    // Each character of this window shows a zoom.blockRows by zoom.blockCols
+    // block of the logicalBoard
     WINDOW *physicalBoard;
     WINDOW *promptWin;
+    Zoom zoom;
+    unsigned int screenRows;
+    unsigned int screenCols;
+    // Glyph codes of what physicalBoard currently shows, so that frames only
+    // draw the characters that differ from the logical board.
+    uint8_t *screenCodes;
+    // Scratch space for one row of codes.
+    uint8_t *rowCodes;
+    // 0 runs the simulation as fast as it will go.
     unsigned int ticksPerSec;
-    unsigned int tick;
-    TileChangeStack pendingChanges;
+    // Upper bound on screen updates while the simulation runs.
+    unsigned int framesPerSec;
+    TickScheduler scheduler;
+    // Set with space while running, by the render thread, to pause and edit.
+    atomic_bool pauseRequested;
+    // Toggled with 's' while running, by the render thread.  The overlay
+    // shows stats summed over the ticks since the last frame, which are only
+    // measured while it is on.
+    atomic_bool showStats;
+    TickStats frameStats;
+    uint64_t sleepNanos;
+    // While the simulation runs the terminal belongs to the render thread,
+    // which draws the frames the simulation publishes to renderFrames and
+    // reads the keyboard.  A byte written to renderWake[1] wakes it.
+    FrameRing renderFrames;
+    pthread_t renderThread;
+    int renderWake[2];
+    atomic_bool stopRendering;
+    // Of the render thread: how long the last frame took to draw, and how
+    // many frames it skipped over for being behind.
+    uint64_t renderNanos;
+    uint64_t droppedFrames;
+    // Only present when checkpointing.
+    SnapshotWriter *checkpoints;
+    uint64_t checkpointEvery;
+    uint64_t nextCheckpoint;
 } GameState;
 
 void showCursor(const GameState * const gameState) {
@@ -82,81 +147,306 @@ void showCursor(const GameState * const gameState) {
     wrefresh(gameState->physicalBoard);
 }
 
-TileState getTileState(const Board * const board, const unsigned int row, const unsigned int col) {
-    return board->tiles[row * board->ncols + col];
+void drawGlyph(const GameState * const gameState, const unsigned int row, const unsigned int col,
+               const uint8_t code) {
+    const unsigned int glyph = zoomGlyph(gameState->zoom, code);
+#ifdef CONWAY_WIDE_CURSES
+    if (glyph > 0x7f) {
+        const wchar_t wide = (wchar_t) glyph;
+        mvwaddnwstr(gameState->physicalBoard, row, col, &wide, 1);
+        return;
+    }
+#endif
+    mvwaddch(gameState->physicalBoard, row, col, glyph);
+}
+
+// Draws the characters of a row whose glyph codes differ from what is on
+// screen.
+void drawCodeRow(GameState * const gameState, const unsigned int row, const uint8_t * const codes) {
+    uint8_t * const shown = gameState->screenCodes + (size_t) row * gameState->screenCols;
+    for (unsigned int col = 0; col < gameState->screenCols; ++col) {
+        if (codes[col] != shown[col]) {
+            drawGlyph(gameState, row, col, codes[col]);
+            shown[col] = codes[col];
+        }
+    }
+}
+
+// Draws the characters of rows [rowBegin, rowEnd) whose block of the logical
+// board differs from what is on screen, however many ticks ago it changed.
+// Each row of characters is downsampled from the packed board a word of tiles
+// at a time.
+void drawBoardRows(GameState * const gameState, const unsigned int rowBegin, const unsigned int rowEnd) {
+    const Board * const board = &gameState->simulation.logicalBoard;
+    for (unsigned int row = rowBegin; row < rowEnd && row < gameState->screenRows; ++row) {
+        downsampleRow(board, gameState->zoom, row, gameState->rowCodes, gameState->screenCols);
+        drawCodeRow(gameState, row, gameState->rowCodes);
+    }
+}
+
+void drawBoardChanges(GameState * const gameState) {
+    drawBoardRows(gameState, 0, gameState->screenRows);
+}
+
+// Redraws the whole board, used after loading a pattern or moving the view.
+void drawBoard(GameState * const gameState) {
+    werase(gameState->physicalBoard);
+    memset(gameState->screenCodes, 0, (size_t) gameState->screenRows * gameState->screenCols);
+    drawBoardChanges(gameState);
+    wmove(gameState->physicalBoard, 0, 0);
+    wrefresh(gameState->physicalBoard);
+}
+
+// The tiles under the characters of the rectangle with corners a and b, both
+// included, clipped to the board.
+TileRect charRectTiles(const GameState * const gameState, const Point a, const Point b) {
+    const Board * const board = &gameState->simulation.logicalBoard;
+    const Zoom zoom = gameState->zoom;
+    const unsigned int rowEnd = ((a.row > b.row ? a.row : b.row) + 1) * zoom.blockRows;
+    const unsigned int colEnd = ((a.col > b.col ? a.col : b.col) + 1) * zoom.blockCols;
+    return (TileRect) {
+        (a.row < b.row ? a.row : b.row) * zoom.blockRows, rowEnd < board->nrows ? rowEnd : board->nrows,
+        (a.col < b.col ? a.col : b.col) * zoom.blockCols, colEnd < board->ncols ? colEnd : board->ncols
+    };
 }
 
-void setTileState(Board * const board, TileState val, const unsigned int row, const unsigned int col) {
-    TileState prev = board->tiles[row * board->ncols + col];
-    board->tiles[row * board->ncols + col] = val;
-    if (prev == ALIVE && val == DEAD) {
-        board->nalive--;
-    } else if (prev == DEAD && val == ALIVE) {
-        board->nalive++;
+// What the bulk edits apply to: the selection, or the whole board without one.
+TileRect editedTiles(const GameState * const gameState) {
+    if (gameState->selecting) {
+        return charRectTiles(gameState, gameState->selectionAnchor, gameState->logicalCur);
     }
+    const Board * const board = &gameState->simulation.logicalBoard;
+    return (TileRect) {0, board->nrows, 0, board->ncols};
 }
 
+// Shows the selection in reverse video, or in normal video again with
+// attrs A_NORMAL.  Only the characters' attributes change, not their glyphs.
+void drawSelection(const GameState * const gameState, const attr_t attrs) {
+    if (!gameState->selecting) {
+        return;
+    }
+    const Point a = gameState->selectionAnchor;
+    const Point b = gameState->logicalCur;
+    const unsigned int col = a.col < b.col ? a.col : b.col;
+    const unsigned int width = (a.col > b.col ? a.col - b.col : b.col - a.col) + 1;
+    for (unsigned int row = a.row < b.row ? a.row : b.row; row <= (a.row > b.row ? a.row : b.row); ++row) {
+        mvwchgat(gameState->physicalBoard, row, col, width, attrs, 0, NULL);
+    }
+}
+
+void showCursorAndSelection(const GameState * const gameState) {
+    drawSelection(gameState, A_REVERSE);
+    showCursor(gameState);
+}
+
+// Tells the simulation about a bulk edit of rect and brings the characters
+// over it up to date, in a single update of the terminal.
+void finishEdit(GameState * const gameState, const TileRect rect) {
+    if (rect.rowBegin >= rect.rowEnd || rect.colBegin >= rect.colEnd) {
+        showCursorAndSelection(gameState);
+        return;
+    }
+    simulationRectEdited(&gameState->simulation, rect.rowBegin, rect.rowEnd, rect.colBegin, rect.colEnd);
+    drawBoardRows(gameState, rect.rowBegin / gameState->zoom.blockRows,
+                  (rect.rowEnd - 1) / gameState->zoom.blockRows + 1);
+    showCursorAndSelection(gameState);
+}
+
+// Toggles the block of tiles under the cursor: a block with any live tiles is
+// cleared, and an empty one filled.
 void toggleTileState(GameState * const gameState) {
-    TileState current = getTileState(&gameState->logicalBoard, gameState->logicalCur.row, gameState->logicalCur.col);
-    switch (current) {
-    case DEAD:
-        setTileState(&gameState->logicalBoard, ALIVE, gameState->logicalCur.row, gameState->logicalCur.col);
-        waddch(gameState->physicalBoard, 'X');
-        break;
-    case ALIVE:
-        setTileState(&gameState->logicalBoard, DEAD, gameState->logicalCur.row, gameState->logicalCur.col);
-        waddch(gameState->physicalBoard, ' ');
-        break;
-    default:
-        exit(1);
+    const Board * const board = &gameState->simulation.logicalBoard;
+    const TileRect block = charRectTiles(gameState, gameState->logicalCur, gameState->logicalCur);
+    bool anyAlive = false;
+    for (unsigned int row = block.rowBegin; row < block.rowEnd && !anyAlive; ++row) {
+        for (unsigned int col = block.colBegin; col < block.colEnd && !anyAlive; ++col) {
+            anyAlive = getTileState(board, row, col) == ALIVE;
+        }
     }
-    wmove(gameState->physicalBoard, gameState->logicalCur.row, gameState->logicalCur.col);
+    fillBoardRect(&gameState->simulation.logicalBoard, anyAlive ? DEAD : ALIVE, block.rowBegin, block.rowEnd,
+                  block.colBegin, block.colEnd);
+    finishEdit(gameState, block);
+}
+
+// Fills the edited tiles with a random soup of fillPercent live tiles.
+void randomizeTiles(GameState * const gameState) {
+    const TileRect rect = editedTiles(gameState);
+    fillSoupRect(&gameState->simulation.logicalBoard, monotonicNanos(), gameState->fillPercent / 100.0,
+                 rect.rowBegin, rect.rowEnd, rect.colBegin, rect.colEnd);
+    finishEdit(gameState, rect);
 }
 
-// This function provides the interactive session where the user places tiles
-// on the board before the simulation.  Returns true if program should continue
-// to the next stage.
-bool setUpBoard(GameState * const gameState) {
-    wprintw(gameState->promptWin, "Use arrow keys and spacebar to set tiles. Then press enter to continue.");
+// Copies the selection's tiles to the clipboard, replacing what it held.
+void copySelection(GameState * const gameState) {
+    if (!gameState->selecting) {
+        return;
+    }
+    const TileRect rect = editedTiles(gameState);
+    Board copied;
+    if (!cropBoard(&copied, &gameState->simulation.logicalBoard, rect.rowBegin, rect.colBegin,
+                   rect.rowEnd - rect.rowBegin, rect.colEnd - rect.colBegin)) {
+        return;
+    }
+    destroyBoard(&gameState->clipboard);
+    gameState->clipboard = copied;
+}
+
+// Overwrites the tiles from the cursor on with the clipboard's, clipped to the
+// board.
+void pasteClipboard(GameState * const gameState) {
+    Board * const board = &gameState->simulation.logicalBoard;
+    const Board * const clipboard = &gameState->clipboard;
+    const TileRect origin = charRectTiles(gameState, gameState->logicalCur, gameState->logicalCur);
+    if (clipboard->nrows == 0 || origin.rowBegin >= board->nrows || origin.colBegin >= board->ncols) {
+        return;
+    }
+    blitBoard(board, clipboard, origin.rowBegin, origin.colBegin);
+    const unsigned int rowEnd = origin.rowBegin + clipboard->nrows;
+    const unsigned int colEnd = origin.colBegin + clipboard->ncols;
+    finishEdit(gameState, (TileRect) {
+        origin.rowBegin, rowEnd < board->nrows ? rowEnd : board->nrows,
+        origin.colBegin, colEnd < board->ncols ? colEnd : board->ncols
+    });
+}
+
+// Scrolls the window onto an unbounded universe by the given number of
+// characters.  Bounded boards don't scroll.  The selection is dropped, since
+// its corner would scroll off.
+void panView(GameState * const gameState, const int rows, const int cols) {
+    Simulation * const sim = &gameState->simulation;
+    if (!simulationIsUnbounded(sim)) {
+        return;
+    }
+    drawSelection(gameState, A_NORMAL);
+    gameState->selecting = false;
+    setSimulationView(sim, sim->viewRow + (int64_t) rows * gameState->zoom.blockRows,
+                      sim->viewCol + (int64_t) cols * gameState->zoom.blockCols);
+    drawBoard(gameState);
+    showCursor(gameState);
+}
+
+// Moves the cursor a character, scrolling instead past the edge of an
+// unbounded universe's window.
+void moveCursor(GameState * const gameState, const int rows, const int cols) {
+    Point * const cur = &gameState->logicalCur;
+    if ((rows < 0 && cur->row == 0) || (rows > 0 && cur->row == gameState->screenRows - 1)
+            || (cols < 0 && cur->col == 0) || (cols > 0 && cur->col == gameState->screenCols - 1)) {
+        panView(gameState, rows, cols);
+        return;
+    }
+    drawSelection(gameState, A_NORMAL);
+    cur->row += rows;
+    cur->col += cols;
+    showCursorAndSelection(gameState);
+}
+
+// Reads a line typed into the prompt after message.  Returns false if
+// nothing could be read.
+bool promptLine(GameState * const gameState, const char * const message, char * const buf, const int size) {
+    werase(gameState->promptWin);
+    mvwprintw(gameState->promptWin, 0, 0, "%s", message);
+    wrefresh(gameState->promptWin);
+    echo();
+    const bool ok = wgetnstr(gameState->promptWin, buf, size - 1) != ERR;
+    noecho();
+    return ok;
+}
+
+void printEditHelp(GameState * const gameState, const char * const action) {
+    werase(gameState->promptWin);
+    // Most important first, for narrow terminals.
+    mvwprintw(gameState->promptWin, 0, 0, "Enter: %s  q: quit  space: toggle  v: select  f/c/r: fill/clear/random  "
+              "y/p: copy/paste  o: open", action);
     wrefresh(gameState->promptWin);
+    showCursorAndSelection(gameState);
+}
+
+// Asks for the density of the next random fills, in percent.
+void promptFillPercent(GameState * const gameState) {
+    char buf[16];
+    if (!promptLine(gameState, "Live tiles in random fills, in percent: ", buf, sizeof(buf))) {
+        return;
+    }
+    char *end;
+    const unsigned long percent = strtoul(buf, &end, 10);
+    if (end != buf && *end == '\0' && percent <= 100) {
+        gameState->fillPercent = (unsigned int) percent;
+    }
+}
+
+// Asks for a pattern file and loads it into the clipboard, to be pasted.
+void promptClipboardPattern(GameState * const gameState) {
+    char path[1024];
+    Board pattern;
+    if (promptLine(gameState, "Pattern to paste: ", path, sizeof(path)) && path[0] != '\0'
+            && loadPattern(path, &pattern, NULL)) {
+        destroyBoard(&gameState->clipboard);
+        gameState->clipboard = pattern;
+    }
+}
+
+// This function provides the interactive session where the user edits the
+// board, before the simulation and whenever it is paused.  Bulk edits apply
+// to the selection, or to the whole board without one, and each redraws only
+// the characters it changed.  Moving the cursor past the edge of an unbounded
+// universe's window scrolls it.  Returns true if program should continue to
+// the next stage, and action names that stage.
+bool editBoard(GameState * const gameState, const char * const action) {
+    syncSimulationBoard(&gameState->simulation);
+    curs_set(1);
+    printEditHelp(gameState, action);
 
     while (true) {
+        Board * const board = &gameState->simulation.logicalBoard;
         int c = getch();
         switch (c) {
-        // Toggling tiles
         case KEY_RIGHT:
-            if (gameState->logicalCur.col == gameState->logicalBoard.ncols - 1) {
-                break;
-            }
-            gameState->logicalCur.col += 1;
-            showCursor(gameState);
+            moveCursor(gameState, 0, 1);
             break;
         case KEY_LEFT:
-            if (gameState->logicalCur.col == 0) {
-                break;
-            }
-            gameState->logicalCur.col -= 1;
-            showCursor(gameState);
+            moveCursor(gameState, 0, -1);
             break;
         case KEY_DOWN:
-            if (gameState->logicalCur.row == gameState->logicalBoard.nrows - 1) {
-                break;
-            }
-            gameState->logicalCur.row += 1;
-            showCursor(gameState);
+            moveCursor(gameState, 1, 0);
             break;
         case KEY_UP:
-            if (gameState->logicalCur.row == 0) {
-                break;
-            }
-            gameState->logicalCur.row -= 1;
-            showCursor(gameState);
+            moveCursor(gameState, -1, 0);
             break;
+        // Toggling tiles
         case ' ':
             toggleTileState(gameState);
-            wrefresh(gameState->physicalBoard);
+            break;
+        case 'v':
+            drawSelection(gameState, A_NORMAL);
+            gameState->selecting = !gameState->selecting;
+            gameState->selectionAnchor = gameState->logicalCur;
+            showCursorAndSelection(gameState);
+            break;
+        case 'f': case 'c': {
+            const TileRect rect = editedTiles(gameState);
+            fillBoardRect(board, c == 'f' ? ALIVE : DEAD, rect.rowBegin, rect.rowEnd, rect.colBegin, rect.colEnd);
+            finishEdit(gameState, rect);
+            break;
+        }
+        case 'r':
+            promptFillPercent(gameState);
+            printEditHelp(gameState, action);
+            randomizeTiles(gameState);
+            break;
+        case 'y':
+            copySelection(gameState);
+            break;
+        case 'o':
+            promptClipboardPattern(gameState);
+            printEditHelp(gameState, action);
+            break;
+        case 'p':
+            pasteClipboard(gameState);
             break;
         case KEY_ENTER: case '\n':
+            drawSelection(gameState, A_NORMAL);
+            gameState->selecting = false;
+            wrefresh(gameState->physicalBoard);
             return true;
         case 'q':
             return false;
@@ -169,7 +459,7 @@ bool setUpBoard(GameState * const gameState) {
 // Routine for prompting the user and getting a ticks/second value.
 bool getTicksPerSecond(GameState * const gameState) {
     wclear(gameState->promptWin);
-    mvwprintw(gameState->promptWin, 0, 0, "Now type the desired ticks/sec and press enter to confirm: ");
+    mvwprintw(gameState->promptWin, 0, 0, "Now type the desired ticks/sec (0 for flat out) and press enter to confirm: ");
     wrefresh(gameState->promptWin);
     echo();
 
@@ -193,88 +483,636 @@ bool getTicksPerSecond(GameState * const gameState) {
     }
 }
 
-// Determines whether a tile should flip, and if it should, pushes to
-// the pendingChanges field of the gameState parameter.
-void handleTile(GameState * const gameState, const unsigned int row, const unsigned int col) {
-    TileState currentState = getTileState(&gameState->logicalBoard, row, col);
-    unsigned int numAliveNeighbors = 0;
-    const int offsets[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
-    for (unsigned int i = 0; i < 8; ++i) {
-        int r = row + offsets[i][0];
-        int c = col + offsets[i][1];
-        if (r < 0 || r > gameState->logicalBoard.nrows - 1 || c < 0 || c > gameState->logicalBoard.ncols - 1) {
+// Appends the achieved tick rate, and how it compares with the target, to the
+// prompt.
+void printTickRate(const GameState * const gameState, const double tickRate, const double jitter) {
+    wprintw(gameState->promptWin, ", %.1f ticks/sec", tickRate);
+    if (gameState->ticksPerSec != 0) {
+        wprintw(gameState->promptWin, " (target %u, jitter %.3f ms)", gameState->ticksPerSec, jitter * 1e3);
+    }
+}
+
+// A snapshot of the simulation for the render thread: the figures for the
+// prompt, followed in the same slot of renderFrames by screenRows rows of
+// screenCols glyph codes.
+typedef struct Frame {
+    uint64_t tick;
+    unsigned int population;
+    double tickRate;
+    double jitter;
+    bool showStats;
+    // Summed over the ticks since the last frame, if showStats is set.
+    TickStats stats;
+    uint64_t sleepNanos;
+} Frame;
+
+static inline uint8_t *frameCodes(Frame * const frame) {
+    return (uint8_t *) (frame + 1);
+}
+
+// Shows the stats of the ticks since the last frame in the prompt, per tick
+// except for rendering, which happens once a frame.
+void printStatsOverlay(const GameState * const gameState, const Frame * const frame) {
+    const TickStats * const stats = &frame->stats;
+    const double ticks = stats->ticks != 0 ? (double) stats->ticks : 1;
+    wprintw(gameState->promptWin, "Tick %" PRIu64 " pop %u  +%.0f -%.0f/tick  ms/tick: compute %.3f commit %.3f"
+            " sleep %.3f  render %.3f ms  %" PRIu64 " frames dropped", frame->tick, frame->population,
+            stats->births / ticks, stats->deaths / ticks, stats->computeNanos / ticks / 1e6,
+            stats->commitNanos / ticks / 1e6, frame->sleepNanos / ticks / 1e6, gameState->renderNanos / 1e6,
+            gameState->droppedFrames);
+}
+
+// Brings the screen up to date with a frame, in a single update of the
+// terminal.
+void drawFrame(GameState * const gameState, Frame * const frame) {
+    const uint64_t start = frame->showStats ? monotonicNanos() : 0;
+    werase(gameState->promptWin);
+    wmove(gameState->promptWin, 0, 0);
+    if (frame->showStats) {
+        printStatsOverlay(gameState, frame);
+    } else {
+        wprintw(gameState->promptWin, "On tick %" PRIu64, frame->tick);
+        printTickRate(gameState, frame->tickRate, frame->jitter);
+        wprintw(gameState->promptWin, "  space: pause");
+    }
+    const uint8_t * const codes = frameCodes(frame);
+    for (unsigned int row = 0; row < gameState->screenRows; ++row) {
+        drawCodeRow(gameState, row, codes + (size_t) row * gameState->screenCols);
+    }
+    wnoutrefresh(gameState->promptWin);
+    wnoutrefresh(gameState->physicalBoard);
+    doupdate();
+    gameState->renderNanos = frame->showStats ? monotonicNanos() - start : 0;
+}
+
+// Draws the newest frame the simulation has published, if there is one
+// since the last.
+void drawLatestFrame(GameState * const gameState) {
+    Frame * const frame = (Frame *) frameRingLatest(&gameState->renderFrames, &gameState->droppedFrames);
+    if (frame != NULL) {
+        drawFrame(gameState, frame);
+        frameRingRelease(&gameState->renderFrames);
+    }
+}
+
+// Does nothing if there is no render thread.
+void wakeRenderThread(const GameState * const gameState) {
+    const char wake = 0;
+    // A full pipe already holds a wakeup.
+    if (gameState->renderWake[1] != -1 && write(gameState->renderWake[1], &wake, 1) < 0) {}
+}
+
+// Snapshots the simulation into the next frame of renderFrames and wakes the
+// render thread.  Returns false, leaving the frame for a later tick, if the
+// render thread hasn't finished with any of the frames yet.
+bool publishFrame(GameState * const gameState) {
+    Frame * const frame = (Frame *) frameRingAcquire(&gameState->renderFrames);
+    if (frame == NULL) {
+        return false;
+    }
+    const Simulation * const sim = &gameState->simulation;
+    frame->tick = sim->tick;
+    frame->population = sim->logicalBoard.nalive;
+    frame->tickRate = achievedTickRate(&gameState->scheduler);
+    frame->jitter = tickJitter(&gameState->scheduler);
+    frame->showStats = sim->collectStats;
+    frame->stats = gameState->frameStats;
+    frame->sleepNanos = gameState->sleepNanos;
+    uint8_t * const codes = frameCodes(frame);
+    for (unsigned int row = 0; row < gameState->screenRows; ++row) {
+        downsampleRow(&sim->logicalBoard, gameState->zoom, row, codes + (size_t) row * gameState->screenCols,
+                      gameState->screenCols);
+    }
+    frameRingPublish(&gameState->renderFrames);
+    wakeRenderThread(gameState);
+    gameState->frameStats = (TickStats) {0, 0, 0, 0, 0};
+    gameState->sleepNanos = 0;
+    return true;
+}
+
+// Reads any key pressed while the simulation runs, without waiting.
+void handleRunningKeys(GameState * const gameState) {
+    int c;
+    while ((c = wgetch(gameState->promptWin)) != ERR) {
+        if (c == 's') {
+            atomic_store(&gameState->showStats, !atomic_load(&gameState->showStats));
+        } else if (c == ' ') {
+            atomic_store(&gameState->pauseRequested, true);
+        }
+    }
+}
+
+// The render thread: sleeps until a key is pressed or a frame is published.
+void *renderMain(void *arg) {
+    GameState * const gameState = (GameState *) arg;
+    struct pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {gameState->renderWake[0], POLLIN, 0}};
+    while (!atomic_load(&gameState->stopRendering)) {
+        if (poll(fds, 2, -1) < 0) {
             continue;
         }
+        if (fds[0].revents & (POLLHUP | POLLERR)) {
+            // Nothing more will be typed, so stop watching for it.
+            fds[0].fd = -1;
+        } else if (fds[0].revents & POLLIN) {
+            handleRunningKeys(gameState);
+        }
+        if (fds[1].revents & POLLIN) {
+            char drained[64];
+            while (read(gameState->renderWake[0], drained, sizeof(drained)) > 0) {}
+            drawLatestFrame(gameState);
+        }
+    }
+    return NULL;
+}
+
+void closeRenderWake(GameState * const gameState) {
+    close(gameState->renderWake[0]);
+    close(gameState->renderWake[1]);
+    gameState->renderWake[0] = -1;
+    gameState->renderWake[1] = -1;
+}
+
+// Hands the terminal to a new render thread.  Returns false if it can't be
+// started, in which case the caller must draw and read keys itself.
+bool startRenderThread(GameState * const gameState) {
+    if (pipe(gameState->renderWake) != 0) {
+        return false;
+    }
+    fcntl(gameState->renderWake[0], F_SETFL, O_NONBLOCK);
+    fcntl(gameState->renderWake[1], F_SETFL, O_NONBLOCK);
+    atomic_store(&gameState->stopRendering, false);
+    if (pthread_create(&gameState->renderThread, NULL, renderMain, gameState) != 0) {
+        closeRenderWake(gameState);
+        return false;
+    }
+    return true;
+}
+
+// Takes the terminal back from the render thread.
+void stopRenderThread(GameState * const gameState) {
+    atomic_store(&gameState->stopRendering, true);
+    wakeRenderThread(gameState);
+    pthread_join(gameState->renderThread, NULL);
+    closeRenderWake(gameState);
+}
+
+// Hands the current generation to writer, unless it is still busy writing the
+// last one.  Returns false if it was busy.
+bool submitCheckpoint(SnapshotWriter * const writer, Simulation * const sim) {
+    syncSimulationBoard(sim);
+    const SnapshotInfo info = {sim->tick, sim->rule, sim->topology};
+    return submitSnapshot(writer, &sim->logicalBoard, &info);
+}
+
+// Submits a checkpoint if one is due.  One that can't be submitted yet is
+// retried on the following ticks.
+void checkpointIfDue(SnapshotWriter * const writer, Simulation * const sim, const uint64_t every,
+                     uint64_t * const next) {
+    if (writer != NULL && every != 0 && sim->tick >= *next && submitCheckpoint(writer, sim)) {
+        *next = sim->tick + every;
+    }
+}
+
+// Writes a checkpoint of the final generation and waits for it, and for any
+// still in flight.  Returns false if any checkpoint failed.
+bool finishCheckpoints(SnapshotWriter * const writer, Simulation * const sim) {
+    waitForSnapshots(writer);
+    submitCheckpoint(writer, sim);
+    return waitForSnapshots(writer);
+}
+
+// The census of sim's board for a stats record, or NULL without --census.
+const CensusSummary *readCensus(Simulation * const sim, CensusSummary * const summary) {
+    const BoardCensus * const census = simulationCensus(sim);
+    if (census == NULL) {
+        return NULL;
+    }
+    *summary = censusSummary(census, &sim->logicalBoard);
+    return summary;
+}
+
+// Runs ticks at ticksPerSec, and publishes at most framesPerSec frames to the
+// render thread, so that the simulation never waits on the terminal: each
+// frame covers every tick since the last, and frames the render thread is too
+// slow for are dropped.  Stops once the board stops changing or cycles, or
+// when space is pressed, in which case it returns true.
+bool runTicks(GameState * const gameState) {
+    Simulation * const sim = &gameState->simulation;
+    curs_set(0);
+    const uint64_t framePeriod = NANOS_PER_SEC / gameState->framesPerSec;
+
+    nodelay(gameState->promptWin, true);
+    startTickScheduler(&gameState->scheduler, gameState->ticksPerSec);
+    uint64_t nextFrame = gameState->scheduler.startNanos;
+    const bool rendering = startRenderThread(gameState);
+    sim->collectStats = atomic_load(&gameState->showStats);
+    bool paused;
+    while (!(paused = atomic_load(&gameState->pauseRequested)) && stepSimulation(sim) && sim->cyclePeriod == 0) {
+        if (sim->collectStats) {
+            addTickStats(&gameState->frameStats, &sim->lastTick);
+        }
+        checkpointIfDue(gameState->checkpoints, sim, gameState->checkpointEvery, &gameState->nextCheckpoint);
+        const uint64_t now = monotonicNanos();
+        if (now >= nextFrame && publishFrame(gameState)) {
+            nextFrame = now + framePeriod;
+            if (!rendering) {
+                handleRunningKeys(gameState);
+                drawLatestFrame(gameState);
+            }
+        }
+        sim->collectStats = atomic_load_explicit(&gameState->showStats, memory_order_relaxed);
+        if (sim->collectStats) {
+            const uint64_t sleepStart = monotonicNanos();
+            waitForNextTick(&gameState->scheduler);
+            gameState->sleepNanos += monotonicNanos() - sleepStart;
+        } else {
+            waitForNextTick(&gameState->scheduler);
+        }
+    }
+    if (rendering) {
+        stopRenderThread(gameState);
+    }
+    nodelay(gameState->promptWin, false);
+    // Anything the render thread left unread is older than the last tick.
+    if (frameRingLatest(&gameState->renderFrames, NULL) != NULL) {
+        frameRingRelease(&gameState->renderFrames);
+    }
+    publishFrame(gameState);
+    drawLatestFrame(gameState);
+    return paused;
+}
+
+// Runs the simulation until the board stops changing or cycles, or the user
+// quits while it is paused for editing.
+void simulationLoop(GameState * const gameState) {
+    while (runTicks(gameState)) {
+        atomic_store(&gameState->pauseRequested, false);
+        if (!editBoard(gameState, "resume")) {
+            return;
+        }
+    }
+}
 
-        TileState neighborState = getTileState(&gameState->logicalBoard, r, c);
-        if (neighborState == ALIVE) {
-            ++numAliveNeighbors;
+// Loads options->inputPath or options->restorePath, if either, into a board of
+// the requested size.  When no size was requested the board takes the size of
+// the pattern.  start is set to where to start from: generation 0 with the
+// options' rule and topology, except for those that a snapshot or the pattern
+// names and the command line doesn't.
+bool loadInitialBoard(const Options * const options, Board * const board, SnapshotInfo * const start) {
+    Board pattern = {0};
+    PatternInfo info = {0};
+    *start = (SnapshotInfo) {0, options->rule, options->topology};
+    if (options->restorePath != NULL) {
+        SnapshotInfo restored;
+        if (!loadSnapshot(options->restorePath, &pattern, &restored)) {
+            fprintf(stderr, "conway: could not read snapshot '%s'\n", options->restorePath);
+            return false;
         }
+        start->tick = restored.tick;
+        start->rule = options->ruleGiven ? options->rule : restored.rule;
+        start->topology = options->topologyGiven ? options->topology : restored.topology;
+    } else if (options->inputPath != NULL && !loadPattern(options->inputPath, &pattern, &info)) {
+        fprintf(stderr, "conway: could not read pattern '%s'\n", options->inputPath);
+        return false;
+    }
+    if (info.hasRule && !options->ruleGiven) {
+        start->rule = info.rule;
+    }
+    if (ruleHasDecay(start->rule) && options->checkpointPath != NULL) {
+        fprintf(stderr, "conway: snapshots can't hold the dying tiles of a Generations rule, so --checkpoint can't "
+                "be used with one\n");
+        destroyBoard(&pattern);
+        return false;
+    }
+
+    if (options->nrows == 0 || options->ncols == 0) {
+        *board = pattern;
+        return true;
     }
 
-    TileChange change;
-    change.point.row = row;
-    change.point.col = col;
+    bool ok = initBoard(board, options->nrows, options->ncols);
+    if (ok) {
+        blitBoard(board, &pattern, 0, 0);
+    } else {
+        fprintf(stderr, "conway: could not allocate a %ux%u board\n", options->nrows, options->ncols);
+    }
+    destroyBoard(&pattern);
+    return ok;
+}
 
-    if (currentState == ALIVE && numAliveNeighbors < 2) {
-        change.newState = DEAD;
-        pushTileChange(&gameState->pendingChanges, change);
-    } else if (currentState == ALIVE && (numAliveNeighbors == 2 || numAliveNeighbors == 3)) {
-    } else if (currentState == ALIVE && numAliveNeighbors > 3) {
-        change.newState = DEAD;
-        pushTileChange(&gameState->pendingChanges, change);
-    } else if (currentState == DEAD && numAliveNeighbors == 3) {
-        change.newState = ALIVE;
-        pushTileChange(&gameState->pendingChanges, change);
+// Explains why setSimulationRule() refused rule.
+void printRuleRefusal(const StepEngine engine, const LifeRule rule) {
+    if (ruleHasDecay(rule)) {
+        fprintf(stderr, "conway: only the packed engine can run Generations rules, not %s\n", stepEngineName(engine));
+    } else {
+        fprintf(stderr, "conway: the %s engine can't run rules with B0\n", stepEngineName(engine));
     }
 }
 
-// Performs the changes in the pendingChanges data structure.
-void doChanges(GameState * const gameState) {
-    while (!tileChangeStackIsEmpty(&gameState->pendingChanges)) {
-        TileChange change = popTileChange(&gameState->pendingChanges);
-        setTileState(&gameState->logicalBoard, change.newState, change.point.row, change.point.col);
-        if (change.newState == ALIVE) {
-            mvwaddch(gameState->physicalBoard, change.point.row, change.point.col, 'X');
-        } else if (change.newState == DEAD) {
-            mvwaddch(gameState->physicalBoard, change.point.row, change.point.col, ' ');
+double elapsedSeconds(const struct timespec * const start, const struct timespec * const end) {
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Runs the simulation with no curses calls at all, for batch jobs.  Stops
+// after options->generations ticks, or earlier if the board stops changing or
+// cycles.
+int runHeadless(const Options * const options) {
+    Board board;
+    SnapshotInfo start;
+    if (!loadInitialBoard(options, &board, &start)) {
+        return 1;
+    }
+    Simulation sim;
+    if (!initSimulation(&sim, board)) {
+        fprintf(stderr, "conway: out of memory\n");
+        destroySimulation(&sim);
+        return 1;
+    }
+    sim.tick = start.tick;
+    sim.engine = options->engine;
+    sim.recordChanges = false;
+    sim.trackActiveRegions = !options->fullSweep;
+    sim.stepLog2 = options->stepLog2;
+    sim.temporalDepth = options->temporalDepth;
+    sim.hashlifeMemoryLimit = options->hashlifeMemoryLimit;
+    setSimulationTopology(&sim, start.topology);
+    if (!setSimulationRule(&sim, start.rule)) {
+        printRuleRefusal(sim.engine, start.rule);
+        destroySimulation(&sim);
+        return 1;
+    }
+    if (!setSimulationThreads(&sim, options->threads)) {
+        fprintf(stderr, "conway: could not start %u threads\n", options->threads);
+        destroySimulation(&sim);
+        return 1;
+    }
+    if (!setSimulationCycleLimit(&sim, options->maxPeriod) || !setSimulationCensus(&sim, options->census)) {
+        fprintf(stderr, "conway: out of memory\n");
+        destroySimulation(&sim);
+        return 1;
+    }
+    SnapshotWriter *checkpoints = NULL;
+    if (options->checkpointPath != NULL && (checkpoints = createSnapshotWriter(options->checkpointPath)) == NULL) {
+        fprintf(stderr, "conway: could not start the checkpoint writer\n");
+        destroySimulation(&sim);
+        return 1;
+    }
+
+    FILE *statsOut = NULL;
+    if (options->statsPath != NULL) {
+        statsOut = strcmp(options->statsPath, "-") == 0 ? stdout : fopen(options->statsPath, "w");
+        if (statsOut == NULL) {
+            fprintf(stderr, "conway: could not open stats file '%s'\n", options->statsPath);
+            destroySnapshotWriter(checkpoints);
+            destroySimulation(&sim);
+            return 1;
+        }
+        sim.collectStats = true;
+        writeStatsHeader(statsOut, options->statsFormat, options->census);
+    }
+    FrameStream *stream = NULL;
+    if (options->streamPath != NULL) {
+        syncSimulationBoard(&sim);
+        stream = createFrameStream(options->streamPath, options->streamFormat, &sim.logicalBoard);
+        if (stream == NULL) {
+            if (statsOut != NULL && statsOut != stdout) {
+                fclose(statsOut);
+            }
+            destroySnapshotWriter(checkpoints);
+            destroySimulation(&sim);
+            return 1;
+        }
+        submitStreamFrame(stream, &sim.logicalBoard, sim.tick);
+    }
+
+    struct timespec startTime, endTime;
+    uint64_t nextCheckpoint = sim.tick + options->checkpointEvery;
+    uint64_t nextStats = sim.tick + options->statsEvery;
+    uint64_t nextStream = sim.tick + options->streamEvery;
+    TickStats intervalStats = {0, 0, 0, 0, 0};
+    CensusSummary census;
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    while (options->generations == 0 || sim.tick < options->generations) {
+        const uint64_t remaining = options->generations == 0 ? UINT64_MAX : options->generations - sim.tick;
+        const bool anyChanged = stepSimulationUpTo(&sim, remaining);
+        if (statsOut != NULL) {
+            addTickStats(&intervalStats, &sim.lastTick);
+            if (sim.tick >= nextStats || !anyChanged || sim.cyclePeriod != 0) {
+                writeStatsRecord(statsOut, options->statsFormat, sim.tick, sim.logicalBoard.nalive, &intervalStats,
+                                 readCensus(&sim, &census));
+                intervalStats = (TickStats) {0, 0, 0, 0, 0};
+                nextStats = sim.tick + options->statsEvery;
+            }
+        }
+        if (stream != NULL && sim.tick >= nextStream) {
+            syncSimulationBoard(&sim);
+            submitStreamFrame(stream, &sim.logicalBoard, sim.tick);
+            nextStream = sim.tick + options->streamEvery;
+        }
+        if (!anyChanged || sim.cyclePeriod != 0) {
+            break;
+        }
+        checkpointIfDue(checkpoints, &sim, options->checkpointEvery, &nextCheckpoint);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &endTime);
+    int status = 0;
+    if (statsOut != NULL) {
+        if (intervalStats.ticks != 0) {
+            writeStatsRecord(statsOut, options->statsFormat, sim.tick, sim.logicalBoard.nalive, &intervalStats,
+                             readCensus(&sim, &census));
         }
+        if (statsOut != stdout && fclose(statsOut) != 0) {
+            fprintf(stderr, "conway: could not write stats file '%s'\n", options->statsPath);
+            status = 1;
+        }
+    }
+    if (checkpoints != NULL) {
+        if (!finishCheckpoints(checkpoints, &sim)) {
+            fprintf(stderr, "conway: could not write checkpoint '%s'\n", options->checkpointPath);
+            status = 1;
+        }
+        destroySnapshotWriter(checkpoints);
+    }
+    uint64_t streamed = 0;
+    uint64_t dropped = 0;
+    if (stream != NULL) {
+        const bool flushed = flushFrameStream(stream);
+        frameStreamCounts(stream, &streamed, &dropped);
+        if (!destroyFrameStream(stream) || !flushed) {
+            fprintf(stderr, "conway: could not write stream '%s'\n", options->streamPath);
+            status = 1;
+        }
+    }
+
+    // Frames streamed to standard output leave it to them alone.
+    FILE * const report = options->streamPath != NULL && strcmp(options->streamPath, "-") == 0 ? stderr : stdout;
+    char deviceName[256];
+    if (sim.engine == ENGINE_PACKED && sim.temporalDepth > 1 && !ruleHasDecay(sim.rule)) {
+        fprintf(report, "engine: %s (%s, %u threads, temporal depth %u)\n", stepEngineName(sim.engine),
+                packedKernelName(), simulationThreads(&sim), sim.temporalDepth);
+    } else if (sim.engine == ENGINE_PACKED) {
+        fprintf(report, "engine: %s (%s, %u threads)\n", stepEngineName(sim.engine), packedKernelName(),
+                simulationThreads(&sim));
+    } else if (sim.engine == ENGINE_GPU && findGpuDevice(deviceName, sizeof(deviceName))) {
+        fprintf(report, "engine: %s (%s)\n", stepEngineName(sim.engine), deviceName);
+    } else {
+        fprintf(report, "engine: %s\n", stepEngineName(sim.engine));
+    }
+    char ruleText[32];
+    formatLifeRule(sim.rule, ruleText, sizeof(ruleText));
+    fprintf(report, "rule: %s\n", ruleText);
+    if (!simulationIsUnbounded(&sim)) {
+        fprintf(report, "topology: %s\n", topologyName(sim.topology));
+    }
+    fprintf(report, "generations: %" PRIu64 "\n", sim.tick);
+    fprintf(report, "population: %u\n", sim.logicalBoard.nalive);
+    if (readCensus(&sim, &census) != NULL && census.population != 0) {
+        fprintf(report, "bounding box: rows %u-%u, columns %u-%u\n", census.top, census.bottom, census.left,
+                census.right);
+        fprintf(report, "centroid: %.3f, %.3f\n", census.centroidRow, census.centroidCol);
+    }
+    if (sim.cyclePeriod != 0) {
+        fprintf(report, "period: %u\n", sim.cyclePeriod);
     }
+    if (sim.hashlife != NULL) {
+        fprintf(report, "universe population: %" PRIu64 "\n", hashlifePopulation(sim.hashlife));
+    }
+    if (sim.sparse != NULL) {
+        fprintf(report, "universe population: %" PRIu64 "\n", sparsePopulation(sim.sparse));
+    }
+    if (stream != NULL) {
+        fprintf(report, "streamed: %" PRIu64 " frames, %" PRIu64 " dropped\n", streamed, dropped);
+    }
+    fprintf(report, "wall time: %.6f s\n", elapsedSeconds(&startTime, &endTime));
+
+    destroySimulation(&sim);
+    return status;
 }
 
-// First scan each tile for needed changes, and then go back and perform
-// the necessary changes.
-bool doTick(GameState * const gameState) {
-    wclear(gameState->promptWin);
-    mvwprintw(gameState->promptWin, 0, 0, "On tick %u", gameState->tick++);
-    wrefresh(gameState->promptWin);
+// Runs in batch mode that haven't stabilised after this many generations are
+// stopped, unless --generations says otherwise.
+#define DEFAULT_BATCH_GENERATIONS 100000
+// Most runs a batch may hold.
+#define MAX_BATCH_TASKS ((size_t) 1 << 24)
 
-    for (unsigned int row = 0; row < gameState->logicalBoard.nrows; ++row) {
-        for (unsigned int col = 0; col < gameState->logicalBoard.ncols; ++col) {
-            handleTile(gameState, row, col);
+// Parses a comma separated list of seeds and inclusive ranges of them, such
+// as "1-1000,5000".  The seeds are stored in seeds unless it is NULL, and
+// their number in count.  Returns false if the list is invalid or too long.
+bool parseSeedList(const char * const text, uint64_t * const seeds, size_t * const count) {
+    size_t n = 0;
+    const char *item = text;
+    while (true) {
+        char *end;
+        if (!isdigit((unsigned char) item[0])) {
+            return false;
         }
+        errno = 0;
+        const unsigned long long first = strtoull(item, &end, 10);
+        unsigned long long last = first;
+        if (*end == '-') {
+            item = end + 1;
+            if (!isdigit((unsigned char) item[0])) {
+                return false;
+            }
+            last = strtoull(item, &end, 10);
+        }
+        if (errno != 0 || last < first || last - first >= MAX_BATCH_TASKS - n) {
+            return false;
+        }
+        for (size_t i = 0; seeds != NULL && i <= last - first; ++i) {
+            seeds[n + i] = (uint64_t) (first + i);
+        }
+        n += (size_t) (last - first + 1);
+        if (*end == '\0') {
+            break;
+        }
+        if (*end != ',') {
+            return false;
+        }
+        item = end + 1;
     }
-    bool anyChanged = !tileChangeStackIsEmpty(&gameState->pendingChanges);
-    if (anyChanged) {
-        doChanges(gameState);
-        wrefresh(gameState->physicalBoard);
+    *count = n;
+    return true;
+}
+
+// Parses a density as a percentage, or an inclusive range of them as
+// LOW:HIGH:STEP.  The densities, as fractions, are stored in densities unless
+// it is NULL, and their number in count.
+bool parseDensityRange(const char * const text, double * const densities, size_t * const count) {
+    double low, high, step;
+    char extra;
+    if (sscanf(text, "%lf:%lf:%lf%c", &low, &high, &step, &extra) != 3) {
+        if (sscanf(text, "%lf%c", &low, &extra) != 1) {
+            return false;
+        }
+        high = low;
+        step = 1;
+    }
+    if (!(low >= 0 && high <= 100 && low <= high && step > 0) || (high - low) / step >= MAX_BATCH_TASKS) {
+        return false;
+    }
+    // Allows for HIGH not being an exact number of steps after LOW in binary.
+    const size_t n = (size_t) ((high - low) / step + 1e-9) + 1;
+    for (size_t i = 0; densities != NULL && i < n; ++i) {
+        densities[i] = (low + (double) i * step) / 100;
     }
-    return anyChanged;
+    *count = n;
+    return true;
 }
 
-void simulationLoop(GameState * const gameState) {
-    curs_set(0);
-    const int period_us = 1000000 / gameState->ticksPerSec;
+void printBatchResult(void *context, const BatchResult * const result) {
+    FILE * const out = (FILE *) context;
+    fprintf(out, "%" PRIu64 ",%g,%" PRIu64 ",%u,%u\n", result->task.seed, result->task.density * 100,
+            result->generations, result->population, result->period);
+}
 
-    while (doTick(gameState)) {
-        // This is an innaccurate way of getting n ticks/sec.  pthreads would
-        // be a better cross-platform way of doing this.
-        usleep(period_us);
+// Runs a random soup for every seed at every density across a pool of
+// workers, printing a line for each as it finishes.
+int runBatchMode(const Options * const options) {
+    size_t nseeds, ndensities;
+    parseSeedList(options->seeds, NULL, &nseeds);
+    parseDensityRange(options->densities, NULL, &ndensities);
+    if (nseeds > MAX_BATCH_TASKS / ndensities) {
+        fprintf(stderr, "conway: a batch can hold at most %zu runs\n", MAX_BATCH_TASKS);
+        return 1;
     }
+    uint64_t * const seeds = (uint64_t *) malloc(nseeds * sizeof(uint64_t));
+    double * const densities = (double *) malloc(ndensities * sizeof(double));
+    BatchTask * const tasks = (BatchTask *) malloc(nseeds * ndensities * sizeof(BatchTask));
+    if (seeds == NULL || densities == NULL || tasks == NULL) {
+        fprintf(stderr, "conway: out of memory\n");
+        free(tasks);
+        free(densities);
+        free(seeds);
+        return 1;
+    }
+    parseSeedList(options->seeds, seeds, &nseeds);
+    parseDensityRange(options->densities, densities, &ndensities);
+    for (size_t i = 0; i < nseeds; ++i) {
+        for (size_t j = 0; j < ndensities; ++j) {
+            tasks[i * ndensities + j] = (BatchTask) {seeds[i], densities[j]};
+        }
+    }
+
+    const BatchConfig config = {
+        options->nrows, options->ncols, options->engine, options->rule, options->topology, !options->fullSweep,
+        options->generations != 0 ? options->generations : DEFAULT_BATCH_GENERATIONS, options->maxPeriod,
+        options->jobs
+    };
+    printf("seed,density,generations,population,period\n");
+    const bool ok = runBatch(&config, tasks, nseeds * ndensities, printBatchResult, stdout);
+    if (!ok) {
+        fprintf(stderr, "conway: could not start the batch workers\n");
+    }
+    free(tasks);
+    free(densities);
+    free(seeds);
+    return ok ? 0 : 1;
 }
 
-int main(const int argc, const char * const argv[]) {
-    // Init ncurses
+int runInteractive(const Options * const options) {
+    // Init ncurses, in the user's locale so that wide glyphs can be drawn
+    setlocale(LC_ALL, "");
     initscr();
     noecho();
     cbreak();
@@ -296,23 +1134,93 @@ int main(const int argc, const char * const argv[]) {
     box(boardWinBox, 0, 0);
     wrefresh(boardWinBox);
 
-    // Init game state
-    GameState gameState;
-    gameState.logicalBoard.ncols = maxX - 2;
-    gameState.logicalBoard.nrows = maxY - 3;
-    gameState.logicalBoard.tiles =
-            (TileState *) calloc(gameState.logicalBoard.ncols * gameState.logicalBoard.nrows, sizeof(TileState));
-    gameState.logicalBoard.nalive = 0;
+    // Init game state, with the board sized to the terminal at the zoom
+    Options sized = *options;
+    sized.nrows = (maxY - 3) * options->zoom.blockRows;
+    sized.ncols = (maxX - 2) * options->zoom.blockCols;
+    Board board;
+    SnapshotInfo start;
+    if (!loadInitialBoard(&sized, &board, &start)) {
+        endwin();
+        return 1;
+    }
+
+    GameState gameState = {0};
+    if (!initSimulation(&gameState.simulation, board)) {
+        endwin();
+        fprintf(stderr, "conway: out of memory\n");
+        destroySimulation(&gameState.simulation);
+        return 1;
+    }
+    gameState.simulation.tick = start.tick;
+    // A Generations rule named by the pattern needs the packed engine.
+    gameState.simulation.engine = !options->engineGiven && ruleHasDecay(start.rule) ? ENGINE_PACKED : options->engine;
+    // The view diffs the board itself rather than reading pendingChanges.
+    gameState.simulation.recordChanges = false;
+    gameState.simulation.trackActiveRegions = !options->fullSweep;
+    gameState.simulation.stepLog2 = options->stepLog2;
+    gameState.simulation.temporalDepth = options->temporalDepth;
+    gameState.simulation.hashlifeMemoryLimit = options->hashlifeMemoryLimit;
+    setSimulationTopology(&gameState.simulation, start.topology);
+    if (!setSimulationRule(&gameState.simulation, start.rule)) {
+        endwin();
+        printRuleRefusal(gameState.simulation.engine, start.rule);
+        destroySimulation(&gameState.simulation);
+        return 1;
+    }
+    if (!setSimulationThreads(&gameState.simulation, options->threads)) {
+        endwin();
+        fprintf(stderr, "conway: could not start %u threads\n", options->threads);
+        destroySimulation(&gameState.simulation);
+        return 1;
+    }
+    if (!setSimulationCycleLimit(&gameState.simulation, options->maxPeriod)) {
+        endwin();
+        fprintf(stderr, "conway: out of memory\n");
+        destroySimulation(&gameState.simulation);
+        return 1;
+    }
+    if (options->checkpointPath != NULL
+            && (gameState.checkpoints = createSnapshotWriter(options->checkpointPath)) == NULL) {
+        endwin();
+        fprintf(stderr, "conway: could not start the checkpoint writer\n");
+        destroySimulation(&gameState.simulation);
+        return 1;
+    }
+    gameState.zoom = options->zoom;
+    gameState.screenRows = maxY - 3;
+    gameState.screenCols = maxX - 2;
+    gameState.screenCodes = (uint8_t *) calloc((size_t) gameState.screenRows * gameState.screenCols, 1);
+    gameState.rowCodes = (uint8_t *) calloc(gameState.screenCols, 1);
+    // Three frames, so that one can be drawn and the next filled while the
+    // newest waits.
+    const bool framesAllocated = initFrameRing(&gameState.renderFrames, 3,
+                                               sizeof(Frame) + (size_t) gameState.screenRows * gameState.screenCols);
+    if (gameState.screenCodes == NULL || gameState.rowCodes == NULL || !framesAllocated) {
+        endwin();
+        fprintf(stderr, "conway: out of memory\n");
+        destroyFrameRing(&gameState.renderFrames);
+        destroySnapshotWriter(gameState.checkpoints);
+        free(gameState.rowCodes);
+        free(gameState.screenCodes);
+        destroySimulation(&gameState.simulation);
+        return 1;
+    }
+    gameState.checkpointEvery = options->checkpointEvery;
+    gameState.renderWake[0] = -1;
+    gameState.renderWake[1] = -1;
     gameState.physicalBoard = boardWin;
     gameState.logicalCur.row = 0;
     gameState.logicalCur.col = 0;
     gameState.ticksPerSec = 2;
+    gameState.fillPercent = 50;
+    gameState.framesPerSec = options->framesPerSec;
     gameState.promptWin = promptWin;
-    gameState.tick = 0;
-    gameState.pendingChanges.top = NULL;
+    drawBoard(&gameState);
 
     // Have user select their tiles for the simulation
-    bool shouldContinue = setUpBoard(&gameState);
+    bool checkpointed = true;
+    bool shouldContinue = editBoard(&gameState, "continue");
     if (!shouldContinue) {
         goto quit;
     }
@@ -323,18 +1231,458 @@ int main(const int argc, const char * const argv[]) {
         goto quit;
     }
 
-    // Perform the simulation until there are no changes in a tick.
+    // Perform the simulation until there are no changes in a tick, or the
+    // board cycles.
+    gameState.nextCheckpoint = gameState.simulation.tick + gameState.checkpointEvery;
     simulationLoop(&gameState);
+    if (gameState.checkpoints != NULL) {
+        checkpointed = finishCheckpoints(gameState.checkpoints, &gameState.simulation);
+    }
 
     // Exit
     wclear(gameState.promptWin);
-    mvwprintw(gameState.promptWin, 0, 0, "Terminated after %d ticks.  Press 'q' to quit", gameState.tick + 1);
+    mvwprintw(gameState.promptWin, 0, 0, "Terminated after %" PRIu64 " ticks", gameState.simulation.tick);
+    if (gameState.simulation.cyclePeriod > 1) {
+        wprintw(gameState.promptWin, " in a period %u cycle", gameState.simulation.cyclePeriod);
+    }
+    printTickRate(&gameState, achievedTickRate(&gameState.scheduler), tickJitter(&gameState.scheduler));
+    wprintw(gameState.promptWin, ".  Press 'q' to quit");
     wrefresh(gameState.promptWin);
 
     while (getch() != 'q') {}
 
 quit:
     endwin();
+    destroyFrameRing(&gameState.renderFrames);
+    destroySnapshotWriter(gameState.checkpoints);
+    destroyBoard(&gameState.clipboard);
+    free(gameState.rowCodes);
+    free(gameState.screenCodes);
+    destroySimulation(&gameState.simulation);
+    if (!checkpointed) {
+        fprintf(stderr, "conway: could not write checkpoint '%s'\n", options->checkpointPath);
+        return 1;
+    }
     return 0;
 }
 
+void printUsage(FILE * const out) {
+    fprintf(out,
+            "usage: conway [options]\n"
+            "  --load FILE         load a plaintext, RLE or Life 1.06 pattern before starting\n"
+            "  --input FILE        same as --load\n"
+            "  --restore FILE      start from a snapshot written by --checkpoint\n"
+            "  --checkpoint FILE   write a snapshot to FILE when the run ends\n"
+            "  --checkpoint-every N  also write one every N generations, in the background\n"
+            "  --headless          run without the curses interface\n"
+            "  --batch             run a random soup for every seed at every density, headless\n"
+            "  --seeds LIST        batch: seeds and ranges of them, e.g. 1-1000,5000\n"
+            "  --density D         batch: percentage alive, or a range LOW:HIGH:STEP (default 50)\n"
+            "  --jobs N            batch: runs at once, 0 for one per core (default)\n"
+            "  --generations N     stop after N generations (headless; batch default 100000)\n"
+            "  --zoom Z            tiles per character: 1 (default), half (1x2), braille (2x4)\n"
+            "                      or N for NxN blocks drawn by density\n"
+            "  --fps N             most screen updates per second while running (default 30)\n"
+            "  --size ROWSxCOLS    board size (headless; defaults to the pattern size, or 128x128\n"
+            "                      for a batch)\n"
+            "  --engine NAME       stepping engine: packed (headless default), sparse (interactive\n"
+            "                      default), scalar, reference, hashlife or gpu (if built with OpenCL)\n"
+            "  --rule RULE         Life-like rule, e.g. B36/S23 or highlife (default B3/S23), or\n"
+            "                      Generations rule, e.g. B2/S/C3 or briansbrain (packed only)\n"
+            "  --topology NAME     edges of the board: bounded (default) or torus\n"
+            "  --kernel NAME       packed kernel: auto (default), scalar, avx2, avx512 or neon\n"
+            "  --threads N         threads stepping the packed engine, 0 for one per core\n"
+            "  --full-sweep        recompute every tile each tick, not just those near changes\n"
+            "  --temporal-depth K  packed: advance K generations per tick, a cache sized tile at a\n"
+            "                      time (at most 64; cycles are not detected)\n"
+            "  --step-log2 K       hashlife: advance 2^K generations per tick\n"
+            "  --hashlife-memory MB  hashlife: node cache size before collection (default 1024)\n"
+            "  --max-period N      stop once the board repeats a state at most N generations old\n"
+            "                      (default 64, 0 never; not detected by hashlife or with\n"
+            "                      --temporal-depth)\n"
+            "  --stats FILE        headless: write per-tick timings and births/deaths to FILE (- for stdout)\n"
+            "  --stats-every N     headless: one stats record per N generations (default 100)\n"
+            "  --stats-format F    headless: csv (default) or json lines\n"
+            "  --census            headless: add the bounding box and centroid to stats and the summary\n"
+            "  --stream DEST       headless: write generations to DEST, a file, - for stdout or\n"
+            "                      unix:PATH for a Unix socket, dropping any the reader can't keep up with\n"
+            "  --stream-every N    headless: stream one generation in N (default 1)\n"
+            "  --stream-format F   headless: full (default) frames, or delta frames of the changed tiles\n"
+            "  --help              show this message\n");
+}
+
+// Parses an unsigned decimal option value, rejecting trailing garbage.
+bool parseUnsigned(const char * const text, unsigned int * const out) {
+    char *end;
+    errno = 0;
+    unsigned long value = strtoul(text, &end, 10);
+    if (errno != 0 || end == text || *end != '\0' || value > 0xffffffffUL) {
+        return false;
+    }
+    *out = (unsigned int) value;
+    return true;
+}
+
+bool parseUnsigned64(const char * const text, uint64_t * const out) {
+    char *end;
+    errno = 0;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (errno != 0 || end == text || *end != '\0' || text[0] == '-') {
+        return false;
+    }
+    *out = (uint64_t) value;
+    return true;
+}
+
+bool parseSize(const char * const text, unsigned int * const nrows, unsigned int * const ncols) {
+    return sscanf(text, "%ux%u", nrows, ncols) == 2 && *nrows > 0 && *ncols > 0;
+}
+
+// Returns false, after printing a message, if the command line is invalid.
+bool parseOptions(const int argc, char * const argv[], Options * const options) {
+    enum {
+        OPT_HEADLESS = 256,
+        OPT_GENERATIONS,
+        OPT_INPUT,
+        OPT_RESTORE,
+        OPT_CHECKPOINT,
+        OPT_CHECKPOINT_EVERY,
+        OPT_FPS,
+        OPT_ZOOM,
+        OPT_SIZE,
+        OPT_ENGINE,
+        OPT_RULE,
+        OPT_TOPOLOGY,
+        OPT_KERNEL,
+        OPT_THREADS,
+        OPT_FULL_SWEEP,
+        OPT_TEMPORAL_DEPTH,
+        OPT_STEP_LOG2,
+        OPT_HASHLIFE_MEMORY,
+        OPT_STATS,
+        OPT_STATS_EVERY,
+        OPT_STATS_FORMAT,
+        OPT_CENSUS,
+        OPT_STREAM,
+        OPT_STREAM_EVERY,
+        OPT_STREAM_FORMAT,
+        OPT_MAX_PERIOD,
+        OPT_BATCH,
+        OPT_SEEDS,
+        OPT_DENSITY,
+        OPT_JOBS,
+        OPT_HELP
+    };
+    static const struct option longOptions[] = {
+        {"headless", no_argument, NULL, OPT_HEADLESS},
+        {"generations", required_argument, NULL, OPT_GENERATIONS},
+        {"load", required_argument, NULL, OPT_INPUT},
+        {"input", required_argument, NULL, OPT_INPUT},
+        {"restore", required_argument, NULL, OPT_RESTORE},
+        {"checkpoint", required_argument, NULL, OPT_CHECKPOINT},
+        {"checkpoint-every", required_argument, NULL, OPT_CHECKPOINT_EVERY},
+        {"fps", required_argument, NULL, OPT_FPS},
+        {"zoom", required_argument, NULL, OPT_ZOOM},
+        {"size", required_argument, NULL, OPT_SIZE},
+        {"engine", required_argument, NULL, OPT_ENGINE},
+        {"rule", required_argument, NULL, OPT_RULE},
+        {"topology", required_argument, NULL, OPT_TOPOLOGY},
+        {"kernel", required_argument, NULL, OPT_KERNEL},
+        {"threads", required_argument, NULL, OPT_THREADS},
+        {"full-sweep", no_argument, NULL, OPT_FULL_SWEEP},
+        {"temporal-depth", required_argument, NULL, OPT_TEMPORAL_DEPTH},
+        {"step-log2", required_argument, NULL, OPT_STEP_LOG2},
+        {"hashlife-memory", required_argument, NULL, OPT_HASHLIFE_MEMORY},
+        {"stats", required_argument, NULL, OPT_STATS},
+        {"stats-every", required_argument, NULL, OPT_STATS_EVERY},
+        {"stats-format", required_argument, NULL, OPT_STATS_FORMAT},
+        {"census", no_argument, NULL, OPT_CENSUS},
+        {"stream", required_argument, NULL, OPT_STREAM},
+        {"stream-every", required_argument, NULL, OPT_STREAM_EVERY},
+        {"stream-format", required_argument, NULL, OPT_STREAM_FORMAT},
+        {"max-period", required_argument, NULL, OPT_MAX_PERIOD},
+        {"batch", no_argument, NULL, OPT_BATCH},
+        {"seeds", required_argument, NULL, OPT_SEEDS},
+        {"density", required_argument, NULL, OPT_DENSITY},
+        {"jobs", required_argument, NULL, OPT_JOBS},
+        {"help", no_argument, NULL, OPT_HELP},
+        {NULL, 0, NULL, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", longOptions, NULL)) != -1) {
+        switch (opt) {
+        case OPT_HEADLESS:
+            options->headless = true;
+            break;
+        case OPT_GENERATIONS:
+            if (!parseUnsigned64(optarg, &options->generations)) {
+                fprintf(stderr, "conway: invalid generation count '%s'\n", optarg);
+                return false;
+            }
+            break;
+        case OPT_INPUT:
+            options->inputPath = optarg;
+            break;
+        case OPT_RESTORE:
+            options->restorePath = optarg;
+            break;
+        case OPT_CHECKPOINT:
+            options->checkpointPath = optarg;
+            break;
+        case OPT_CHECKPOINT_EVERY:
+            if (!parseUnsigned64(optarg, &options->checkpointEvery) || options->checkpointEvery == 0) {
+                fprintf(stderr, "conway: invalid checkpoint interval '%s'\n", optarg);
+                return false;
+            }
+            break;
+        case OPT_FPS:
+            if (!parseUnsigned(optarg, &options->framesPerSec) || options->framesPerSec == 0) {
+                fprintf(stderr, "conway: invalid frame rate '%s'\n", optarg);
+                return false;
+            }
+            break;
+        case OPT_ZOOM:
+            if (!parseZoom(optarg, &options->zoom)) {
+                fprintf(stderr, "conway: invalid zoom '%s'\n", optarg);
+                return false;
+            }
+#ifndef CONWAY_WIDE_CURSES
+            if (zoomNeedsUnicode(options->zoom)) {
+                fprintf(stderr, "conway: zoom '%s' needs a wide character curses\n", optarg);
+                return false;
+            }
+#endif
+            break;
+        case OPT_SIZE:
+            if (!parseSize(optarg, &options->nrows, &options->ncols)) {
+                fprintf(stderr, "conway: invalid size '%s'\n", optarg);
+                return false;
+            }
+            break;
+        case OPT_ENGINE:
+            if (!parseStepEngine(optarg, &options->engine)) {
+                fprintf(stderr, "conway: unknown engine '%s'\n", optarg);
+                return false;
+            }
+            options->engineGiven = true;
+            break;
+        case OPT_RULE:
+            if (!parseLifeRule(optarg, &options->rule)) {
+                fprintf(stderr, "conway: invalid rule '%s'\n", optarg);
+                return false;
+            }
+            options->ruleGiven = true;
+            break;
+        case OPT_TOPOLOGY:
+            if (!parseTopology(optarg, &options->topology)) {
+                fprintf(stderr, "conway: unknown topology '%s'\n", optarg);
+                return false;
+            }
+            options->topologyGiven = true;
+            break;
+        case OPT_KERNEL:
+            if (!selectPackedKernel(optarg)) {
+                fprintf(stderr, "conway: kernel '%s' is unknown or unsupported by this CPU\n", optarg);
+                return false;
+            }
+            break;
+        case OPT_THREADS:
+            if (!parseUnsigned(optarg, &options->threads)) {
+                fprintf(stderr, "conway: invalid thread count '%s'\n", optarg);
+                return false;
+            }
+            if (options->threads == 0) {
+                options->threads = availableProcessors();
+            }
+            break;
+        case OPT_FULL_SWEEP:
+            options->fullSweep = true;
+            break;
+        case OPT_TEMPORAL_DEPTH:
+            if (!parseUnsigned(optarg, &options->temporalDepth) || options->temporalDepth > MAX_TEMPORAL_DEPTH) {
+                fprintf(stderr, "conway: temporal depth must be at most %d generations\n", MAX_TEMPORAL_DEPTH);
+                return false;
+            }
+            break;
+        case OPT_STEP_LOG2:
+            if (!parseUnsigned(optarg, &options->stepLog2) || options->stepLog2 > HASHLIFE_MAX_STEP_LOG2) {
+                fprintf(stderr, "conway: step must be at most 2^%d generations\n", HASHLIFE_MAX_STEP_LOG2);
+                return false;
+            }
+            break;
+        case OPT_HASHLIFE_MEMORY: {
+            unsigned int megabytes;
+            if (!parseUnsigned(optarg, &megabytes) || megabytes == 0) {
+                fprintf(stderr, "conway: invalid hashlife memory limit '%s'\n", optarg);
+                return false;
+            }
+            options->hashlifeMemoryLimit = (size_t) megabytes * 1024 * 1024;
+            break;
+        }
+        case OPT_STATS:
+            options->statsPath = optarg;
+            break;
+        case OPT_STATS_EVERY:
+            if (!parseUnsigned64(optarg, &options->statsEvery) || options->statsEvery == 0) {
+                fprintf(stderr, "conway: invalid stats interval '%s'\n", optarg);
+                return false;
+            }
+            break;
+        case OPT_STATS_FORMAT:
+            if (!parseStatsFormat(optarg, &options->statsFormat)) {
+                fprintf(stderr, "conway: unknown stats format '%s'\n", optarg);
+                return false;
+            }
+            break;
+        case OPT_CENSUS:
+            options->census = true;
+            break;
+        case OPT_STREAM:
+            options->streamPath = optarg;
+            break;
+        case OPT_STREAM_EVERY:
+            if (!parseUnsigned64(optarg, &options->streamEvery) || options->streamEvery == 0) {
+                fprintf(stderr, "conway: invalid stream interval '%s'\n", optarg);
+                return false;
+            }
+            break;
+        case OPT_STREAM_FORMAT:
+            if (!parseStreamFormat(optarg, &options->streamFormat)) {
+                fprintf(stderr, "conway: unknown stream format '%s'\n", optarg);
+                return false;
+            }
+            break;
+        case OPT_MAX_PERIOD:
+            if (!parseUnsigned(optarg, &options->maxPeriod) || options->maxPeriod > MAX_CYCLE_PERIOD) {
+                fprintf(stderr, "conway: period bound must be at most %u\n", MAX_CYCLE_PERIOD);
+                return false;
+            }
+            break;
+        case OPT_BATCH:
+            options->batch = true;
+            break;
+        case OPT_SEEDS: {
+            size_t count;
+            if (!parseSeedList(optarg, NULL, &count)) {
+                fprintf(stderr, "conway: invalid seed list '%s'\n", optarg);
+                return false;
+            }
+            options->seeds = optarg;
+            break;
+        }
+        case OPT_DENSITY: {
+            size_t count;
+            if (!parseDensityRange(optarg, NULL, &count)) {
+                fprintf(stderr, "conway: invalid density '%s'\n", optarg);
+                return false;
+            }
+            options->densities = optarg;
+            break;
+        }
+        case OPT_JOBS:
+            if (!parseUnsigned(optarg, &options->jobs)) {
+                fprintf(stderr, "conway: invalid job count '%s'\n", optarg);
+                return false;
+            }
+            break;
+        case OPT_HELP:
+            printUsage(stdout);
+            exit(0);
+        default:
+            printUsage(stderr);
+            return false;
+        }
+    }
+
+    if (optind != argc) {
+        printUsage(stderr);
+        return false;
+    }
+    if (options->inputPath != NULL && options->restorePath != NULL) {
+        fprintf(stderr, "conway: --load and --restore are exclusive\n");
+        return false;
+    }
+    if (options->batch && (options->inputPath != NULL || options->restorePath != NULL
+                           || options->checkpointPath != NULL || options->statsPath != NULL
+                           || options->streamPath != NULL)) {
+        fprintf(stderr, "conway: --batch runs random soups, without --load, --restore, --checkpoint, --stats or "
+                "--stream\n");
+        return false;
+    }
+    if (options->batch && options->seeds == NULL) {
+        fprintf(stderr, "conway: --batch requires --seeds\n");
+        return false;
+    }
+    if (options->batch && (options->nrows == 0 || options->ncols == 0)) {
+        options->nrows = 128;
+        options->ncols = 128;
+    }
+    if (options->headless && options->inputPath == NULL && options->restorePath == NULL) {
+        fprintf(stderr, "conway: --headless requires --load or --restore\n");
+        return false;
+    }
+    if (options->census && !options->headless) {
+        fprintf(stderr, "conway: --census requires --headless\n");
+        return false;
+    }
+    if (options->streamPath != NULL && !options->headless) {
+        fprintf(stderr, "conway: --stream requires --headless\n");
+        return false;
+    }
+    if (options->streamPath != NULL && options->statsPath != NULL && strcmp(options->streamPath, "-") == 0
+            && strcmp(options->statsPath, "-") == 0) {
+        fprintf(stderr, "conway: --stream and --stats can't both write to standard output\n");
+        return false;
+    }
+    if (options->checkpointEvery != 0 && options->checkpointPath == NULL) {
+        fprintf(stderr, "conway: --checkpoint-every requires --checkpoint\n");
+        return false;
+    }
+    // Interactively the terminal is a window onto an unbounded universe,
+    // unless the rule would fill one or the board is to have edges.  Only
+    // the packed engine ages the tiles of Generations rules.
+    const bool unboundedEngine = options->engine == ENGINE_HASHLIFE || options->engine == ENGINE_SPARSE;
+    if (!options->engineGiven) {
+        const bool bounded = options->headless || options->batch || ruleBirthsFromNothing(options->rule)
+                || ruleHasDecay(options->rule) || options->topology != TOPOLOGY_BOUNDED;
+        options->engine = bounded ? ENGINE_PACKED : ENGINE_SPARSE;
+    } else if (ruleHasDecay(options->rule) && options->engine != ENGINE_PACKED) {
+        printRuleRefusal(options->engine, options->rule);
+        return false;
+    } else if (unboundedEngine && ruleBirthsFromNothing(options->rule)) {
+        fprintf(stderr, "conway: the %s engine can't run rules with B0\n", stepEngineName(options->engine));
+        return false;
+    } else if (unboundedEngine && options->topology != TOPOLOGY_BOUNDED) {
+        fprintf(stderr, "conway: the %s engine has no edges to wrap\n", stepEngineName(options->engine));
+        return false;
+    } else if (options->engine == ENGINE_GPU && !findGpuDevice(NULL, 0)) {
+        fprintf(stderr, "conway: no OpenCL device for the gpu engine, or built without -DCONWAY_GPU=ON\n");
+        return false;
+    }
+    return true;
+}
+
+int main(const int argc, char * const argv[]) {
+    Options options = {0};
+    options.threads = 1;
+    options.hashlifeMemoryLimit = (size_t) 1024 * 1024 * 1024;
+    options.rule = LIFE_RULE;
+    options.framesPerSec = 30;
+    options.zoom = TILE_ZOOM;
+    options.statsEvery = 100;
+    options.streamEvery = 1;
+    options.maxPeriod = 64;
+    options.densities = "50";
+    if (!parseOptions(argc, argv, &options)) {
+        return 2;
+    }
+
+    if (options.batch) {
+        return runBatchMode(&options);
+    }
+    if (options.headless) {
+        return runHeadless(&options);
+    }
+    return runInteractive(&options);
+}
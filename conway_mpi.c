@@ -0,0 +1,338 @@
+// conway-mpi: runs one board over many processes, and possibly many hosts,
+// under MPI, each stepping a block of it.  It works like conway --headless
+// with the packed engine: every rank reads the starting pattern or snapshot
+// for itself, so it must be where every host can see it, and rank 0 prints
+// the results and writes the checkpoints.
+
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "board.h"
+#include "distributed.h"
+#include "packed.h"
+#include "pattern.h"
+#include "rule.h"
+#include "snapshot.h"
+
+#define DEFAULT_HALO_DEPTH 16
+
+typedef struct Options {
+    const char *inputPath;
+    const char *restorePath;
+    const char *checkpointPath;
+    uint64_t checkpointEvery;
+    // 0 to run until the board settles.
+    uint64_t generations;
+    unsigned int nrows;
+    unsigned int ncols;
+    unsigned int haloDepth;
+    // Ranks down and across, 0 for MPI to choose.
+    int dims[2];
+    LifeRule rule;
+    bool ruleGiven;
+    Topology topology;
+    bool topologyGiven;
+} Options;
+
+static void printUsage(FILE * const out) {
+    fprintf(out,
+            "usage: mpirun [mpirun options] conway-mpi [options]\n"
+            "  --load FILE         load a plaintext, RLE or Life 1.06 pattern\n"
+            "  --restore FILE      start from a snapshot written by --checkpoint\n"
+            "  --size ROWSxCOLS    board size (defaults to the pattern size)\n"
+            "  --generations N     stop after N generations (default: when the board stops changing)\n"
+            "  --halo K            exchange halos K tiles deep, once every K generations, 1 to %d\n"
+            "                      (default %d)\n"
+            "  --grid ROWSxCOLS    ranks down and across (default: as near square as the ranks allow)\n"
+            "  --rule RULE         B/S rule such as B36/S23 (default: the file's, or B3/S23)\n"
+            "  --topology NAME     bounded (default) or torus; edges of a torus wrap around\n"
+            "  --checkpoint FILE   write a snapshot to FILE at the end of the run\n"
+            "  --checkpoint-every N  also write one every N generations\n"
+            "  --kernel NAME       packed kernel: auto (default), scalar, avx2, avx512 or neon\n"
+            "  --help              show this message\n",
+            MAX_HALO_DEPTH, DEFAULT_HALO_DEPTH);
+}
+
+static bool parseUnsigned64(const char * const text, uint64_t * const out) {
+    char *end;
+    errno = 0;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (errno != 0 || end == text || *end != '\0' || text[0] == '-') {
+        return false;
+    }
+    *out = (uint64_t) value;
+    return true;
+}
+
+static bool parseSize(const char * const text, unsigned int * const nrows, unsigned int * const ncols) {
+    return sscanf(text, "%ux%u", nrows, ncols) == 2 && *nrows > 0 && *ncols > 0;
+}
+
+// Every rank parses the same command line, so only rank 0 says what is wrong
+// with it.  Returns 1 if the run should go ahead, 0 if it should stop
+// successfully, after --help, or -1 if the command line is invalid.
+static int parseOptions(const int argc, char * const argv[], const bool quiet, Options * const options) {
+    enum { OPT_INPUT = 256, OPT_RESTORE, OPT_SIZE, OPT_GENERATIONS, OPT_HALO, OPT_GRID, OPT_RULE, OPT_TOPOLOGY,
+           OPT_CHECKPOINT, OPT_CHECKPOINT_EVERY, OPT_KERNEL, OPT_HELP };
+    static const struct option longOptions[] = {
+        {"load", required_argument, NULL, OPT_INPUT},
+        {"input", required_argument, NULL, OPT_INPUT},
+        {"restore", required_argument, NULL, OPT_RESTORE},
+        {"size", required_argument, NULL, OPT_SIZE},
+        {"generations", required_argument, NULL, OPT_GENERATIONS},
+        {"halo", required_argument, NULL, OPT_HALO},
+        {"grid", required_argument, NULL, OPT_GRID},
+        {"rule", required_argument, NULL, OPT_RULE},
+        {"topology", required_argument, NULL, OPT_TOPOLOGY},
+        {"checkpoint", required_argument, NULL, OPT_CHECKPOINT},
+        {"checkpoint-every", required_argument, NULL, OPT_CHECKPOINT_EVERY},
+        {"kernel", required_argument, NULL, OPT_KERNEL},
+        {"help", no_argument, NULL, OPT_HELP},
+        {NULL, 0, NULL, 0}
+    };
+
+    *options = (Options) {0};
+    options->haloDepth = DEFAULT_HALO_DEPTH;
+    parseLifeRule("B3/S23", &options->rule);
+    options->topology = TOPOLOGY_BOUNDED;
+    opterr = !quiet;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", longOptions, NULL)) != -1) {
+        const char *error = NULL;
+        switch (opt) {
+        case OPT_INPUT:
+            options->inputPath = optarg;
+            break;
+        case OPT_RESTORE:
+            options->restorePath = optarg;
+            break;
+        case OPT_SIZE:
+            if (!parseSize(optarg, &options->nrows, &options->ncols)) {
+                error = "invalid size";
+            }
+            break;
+        case OPT_GENERATIONS:
+            if (!parseUnsigned64(optarg, &options->generations)) {
+                error = "invalid generation count";
+            }
+            break;
+        case OPT_HALO: {
+            uint64_t depth;
+            if (!parseUnsigned64(optarg, &depth) || depth == 0 || depth > MAX_HALO_DEPTH) {
+                error = "invalid halo depth";
+            }
+            options->haloDepth = (unsigned int) depth;
+            break;
+        }
+        case OPT_GRID: {
+            unsigned int down, across;
+            if (!parseSize(optarg, &down, &across) || down > (unsigned int) INT32_MAX
+                    || across > (unsigned int) INT32_MAX) {
+                error = "invalid grid";
+            }
+            options->dims[0] = (int) down;
+            options->dims[1] = (int) across;
+            break;
+        }
+        case OPT_RULE:
+            if (!parseLifeRule(optarg, &options->rule)) {
+                error = "invalid rule";
+            }
+            options->ruleGiven = true;
+            break;
+        case OPT_TOPOLOGY:
+            if (!parseTopology(optarg, &options->topology)) {
+                error = "unknown topology";
+            }
+            options->topologyGiven = true;
+            break;
+        case OPT_CHECKPOINT:
+            options->checkpointPath = optarg;
+            break;
+        case OPT_CHECKPOINT_EVERY:
+            if (!parseUnsigned64(optarg, &options->checkpointEvery) || options->checkpointEvery == 0) {
+                error = "invalid checkpoint interval";
+            }
+            break;
+        case OPT_KERNEL:
+            if (!selectPackedKernel(optarg)) {
+                error = "unknown or unsupported kernel";
+            }
+            break;
+        case OPT_HELP:
+            if (!quiet) {
+                printUsage(stdout);
+            }
+            return 0;
+        default:
+            if (!quiet) {
+                printUsage(stderr);
+            }
+            return -1;
+        }
+        if (error != NULL) {
+            if (!quiet) {
+                fprintf(stderr, "conway-mpi: %s '%s'\n", error, optarg);
+            }
+            return -1;
+        }
+    }
+
+    const char *error = NULL;
+    if (optind != argc) {
+        error = "unexpected arguments";
+    } else if (options->inputPath != NULL && options->restorePath != NULL) {
+        error = "--load and --restore are exclusive";
+    } else if (options->inputPath == NULL && options->restorePath == NULL && options->nrows == 0) {
+        error = "needs --load, --restore or --size";
+    } else if (options->checkpointEvery != 0 && options->checkpointPath == NULL) {
+        error = "--checkpoint-every needs --checkpoint";
+    }
+    if (error != NULL) {
+        if (!quiet) {
+            fprintf(stderr, "conway-mpi: %s\n", error);
+        }
+        return -1;
+    }
+    return 1;
+}
+
+// Reads the starting board, which every rank does for itself.  Only rank 0
+// reports failures, which are the same on every rank.
+static bool loadStart(const Options * const options, const bool quiet, Board * const board,
+                      SnapshotInfo * const start) {
+    *board = (Board) {0};
+    *start = (SnapshotInfo) {0, options->rule, options->topology};
+    if (options->restorePath != NULL) {
+        SnapshotInfo restored;
+        if (!loadSnapshot(options->restorePath, board, &restored)) {
+            if (!quiet) {
+                fprintf(stderr, "conway-mpi: could not read snapshot '%s'\n", options->restorePath);
+            }
+            return false;
+        }
+        start->tick = restored.tick;
+        start->rule = options->ruleGiven ? options->rule : restored.rule;
+        start->topology = options->topologyGiven ? options->topology : restored.topology;
+    } else if (options->inputPath != NULL) {
+        PatternInfo info;
+        if (!loadPattern(options->inputPath, board, &info)) {
+            if (!quiet) {
+                fprintf(stderr, "conway-mpi: could not read pattern '%s'\n", options->inputPath);
+            }
+            return false;
+        }
+        if (info.hasRule && !options->ruleGiven) {
+            start->rule = info.rule;
+        }
+    }
+    // The halo exchange only carries live tiles, not the ages of dying ones.
+    if (ruleHasDecay(start->rule)) {
+        if (!quiet) {
+            fprintf(stderr, "conway-mpi: Generations rules can't be distributed\n");
+        }
+        destroyBoard(board);
+        return false;
+    }
+    return true;
+}
+
+// Gathers the board to rank 0 and writes it there.  Collective.  Returns the
+// same on every rank.
+static bool writeCheckpoint(DistributedBoard * const dist, const char * const path) {
+    Board board = {0};
+    int ok = gatherDistributedBoard(dist, &board);
+    if (ok && dist->rank == 0) {
+        const SnapshotInfo info = {dist->tick, dist->rule, dist->topology};
+        ok = writeSnapshot(path, &board, &info);
+        if (!ok) {
+            fprintf(stderr, "conway-mpi: could not write checkpoint '%s'\n", path);
+        }
+    } else if (!ok) {
+        fprintf(stderr, "conway-mpi: out of memory gathering the board\n");
+    }
+    destroyBoard(&board);
+    MPI_Bcast(&ok, 1, MPI_INT, 0, dist->comm);
+    return ok;
+}
+
+static int run(const Options * const options, const int rank, const int nranks) {
+    const bool quiet = rank != 0;
+    Board board;
+    SnapshotInfo start;
+    int loaded = loadStart(options, quiet, &board, &start);
+    // A file another host can't see shouldn't leave the others waiting.
+    MPI_Allreduce(MPI_IN_PLACE, &loaded, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+    if (!loaded) {
+        if (!quiet) {
+            fprintf(stderr, "conway-mpi: some ranks could not read the starting board\n");
+        }
+        destroyBoard(&board);
+        return 1;
+    }
+    const unsigned int nrows = options->nrows != 0 ? options->nrows : board.nrows;
+    const unsigned int ncols = options->ncols != 0 ? options->ncols : board.ncols;
+
+    DistributedBoard dist;
+    if (!initDistributedBoard(&dist, MPI_COMM_WORLD, nrows, ncols, start.topology, start.rule, options->haloDepth,
+                              options->dims)) {
+        destroyDistributedBoard(&dist);
+        destroyBoard(&board);
+        return 1;
+    }
+    loadDistributedBoard(&dist, &board);
+    destroyBoard(&board);
+    dist.tick = start.tick;
+
+    int status = 0;
+    uint64_t nextCheckpoint = dist.tick + options->checkpointEvery;
+    const double startTime = MPI_Wtime();
+    while (options->generations == 0 || dist.tick < options->generations) {
+        const uint64_t remaining = options->generations == 0 ? UINT64_MAX : options->generations - dist.tick;
+        if (!stepDistributedBoard(&dist, remaining)) {
+            break;
+        }
+        if (options->checkpointEvery != 0 && dist.tick >= nextCheckpoint) {
+            if (!writeCheckpoint(&dist, options->checkpointPath)) {
+                status = 1;
+            }
+            nextCheckpoint = dist.tick + options->checkpointEvery;
+        }
+    }
+    const double endTime = MPI_Wtime();
+    if (options->checkpointPath != NULL && !writeCheckpoint(&dist, options->checkpointPath)) {
+        status = 1;
+    }
+
+    if (rank == 0) {
+        printf("engine: distributed (%s, %d ranks in a %dx%d grid, halo %u)\n", packedKernelName(), nranks,
+               dist.dims[0], dist.dims[1], dist.haloDepth);
+        char ruleText[32];
+        formatLifeRule(dist.rule, ruleText, sizeof(ruleText));
+        printf("rule: %s\n", ruleText);
+        printf("topology: %s\n", topologyName(dist.topology));
+        printf("generations: %" PRIu64 "\n", dist.tick);
+        printf("population: %" PRIu64 "\n", dist.population);
+        printf("wall time: %.6f s\n", endTime - startTime);
+    }
+    destroyDistributedBoard(&dist);
+    return status;
+}
+
+int main(int argc, char *argv[]) {
+    MPI_Init(&argc, &argv);
+    int rank, nranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &nranks);
+
+    Options options;
+    const int parsed = parseOptions(argc, argv, rank != 0, &options);
+    const int status = parsed < 0 ? 2 : parsed == 0 ? 0 : run(&options, rank, nranks);
+    MPI_Finalize();
+    return status;
+}
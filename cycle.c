@@ -0,0 +1,62 @@
+#include "cycle.h"
+
+#include <stdlib.h>
+
+uint64_t hashBoard(const Board * const board) {
+    uint64_t hash = 0;
+    if (board->wordsPerRow == 0) {
+        return hash;
+    }
+    const unsigned int lastWord = board->wordsPerRow - 1;
+    const BoardWord mask = lastWordMask(board);
+    for (unsigned int row = 0; row < board->nrows; ++row) {
+        const BoardWord * const words = getBoardRow(board, row);
+        for (unsigned int w = 0; w < board->wordsPerRow; ++w) {
+            hash ^= hashBoardWord(boardWordPosition(board, row, w), w == lastWord ? words[w] & mask : words[w]);
+        }
+    }
+    return hash;
+}
+
+bool initCycleDetector(CycleDetector * const detector, const unsigned int maxPeriod) {
+    detector->hashes = NULL;
+    detector->maxPeriod = 0;
+    resetCycleDetector(detector);
+    if (maxPeriod == 0) {
+        return true;
+    }
+    detector->hashes = (uint64_t *) malloc(maxPeriod * sizeof(uint64_t));
+    if (detector->hashes == NULL) {
+        return false;
+    }
+    detector->maxPeriod = maxPeriod;
+    return true;
+}
+
+void destroyCycleDetector(CycleDetector * const detector) {
+    free(detector->hashes);
+    detector->hashes = NULL;
+    detector->maxPeriod = 0;
+    resetCycleDetector(detector);
+}
+
+// Newest first, so that the period found is the shortest.
+unsigned int recordBoardHash(CycleDetector * const detector, const uint64_t hash) {
+    if (detector->maxPeriod == 0) {
+        return 0;
+    }
+    unsigned int period = 0;
+    for (unsigned int age = 1; age <= detector->count; ++age) {
+        const unsigned int i = (detector->next + detector->maxPeriod - age) % detector->maxPeriod;
+        if (detector->hashes[i] == hash) {
+            period = age;
+            break;
+        }
+    }
+    detector->hashes[detector->next] = hash;
+    detector->next = (detector->next + 1) % detector->maxPeriod;
+    if (detector->count < detector->maxPeriod) {
+        ++detector->count;
+    }
+    return period;
+}
@@ -0,0 +1,71 @@
+#ifndef CONWAY_CYCLE_H
+#define CONWAY_CYCLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "board.h"
+
+// Oscillator detection by board hashing.  The hash of a board is the XOR of a
+// hash of each of its words together with the word's position, so that a tick
+// can bring it up to date a changed word at a time, and empty words add
+// nothing wherever they are, so that an unbounded universe can be hashed the
+// same way as it grows and shrinks.
+
+// Murmur3's 64-bit finaliser.
+static inline uint64_t mixHash(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// The share of the hash of a board held by word at position.  Changing the
+// word from a to b changes the hash by hashBoardWord(position, a) ^
+// hashBoardWord(position, b).
+static inline uint64_t hashBoardWord(const uint64_t position, const BoardWord word) {
+    return word == 0 ? 0 : mixHash((position + 1) * 0x9E3779B97F4A7C15ULL ^ word);
+}
+
+// Position of word w of row row, for hashBoardWord().
+static inline uint64_t boardWordPosition(const Board * const board, const unsigned int row, const unsigned int w) {
+    return (uint64_t) row * board->wordsPerRow + w;
+}
+
+// Hashes the whole board from scratch, ignoring its padding.
+uint64_t hashBoard(const Board * const board);
+
+// The longest period that can be looked for.  Every tick searches the whole
+// history, so it is kept short enough for that to stay cheap.
+#define MAX_CYCLE_PERIOD 65536
+
+// The hashes of the last maxPeriod generations, in a ring.
+typedef struct CycleDetector {
+    uint64_t *hashes;
+    unsigned int maxPeriod;
+    unsigned int count;
+    // Where the next hash goes.
+    unsigned int next;
+} CycleDetector;
+
+// Remembers up to maxPeriod hashes, none to begin with.  A maxPeriod of 0
+// allocates nothing and never finds a cycle.  Returns false if the ring can't
+// be allocated, in which case the detector is left with a maxPeriod of 0.
+bool initCycleDetector(CycleDetector * const detector, const unsigned int maxPeriod);
+
+void destroyCycleDetector(CycleDetector * const detector);
+
+// Forgets every hash, for when the board no longer follows from them.
+static inline void resetCycleDetector(CycleDetector * const detector) {
+    detector->count = 0;
+    detector->next = 0;
+}
+
+// Records the hash of the next generation.  Returns the number of
+// generations since the most recent one with the same hash, or 0 if none of
+// those remembered had it.
+unsigned int recordBoardHash(CycleDetector * const detector, const uint64_t hash);
+
+#endif
@@ -0,0 +1,105 @@
+#include "decay.h"
+
+#include <string.h>
+
+// Bits needed for ages up to states - 2.
+static unsigned int planesFor(const unsigned int states) {
+    unsigned int nplanes = 0;
+    while ((states - 2) >> nplanes != 0) {
+        ++nplanes;
+    }
+    return nplanes;
+}
+
+bool initDecayPlanes(DecayPlanes * const decay, const Board * const board, const unsigned int states) {
+    memset(decay, 0, sizeof(*decay));
+    decay->states = states;
+    decay->nplanes = planesFor(states);
+    for (unsigned int k = 0; k < decay->nplanes; ++k) {
+        if (!initBoard(&decay->planes[k], board->nrows, board->ncols)) {
+            destroyDecayPlanes(decay);
+            return false;
+        }
+    }
+    return true;
+}
+
+void destroyDecayPlanes(DecayPlanes * const decay) {
+    for (unsigned int k = 0; k < decay->nplanes; ++k) {
+        destroyBoard(&decay->planes[k]);
+    }
+    decay->nplanes = 0;
+}
+
+void clearDecayPlanes(DecayPlanes * const decay) {
+    for (unsigned int k = 0; k < decay->nplanes; ++k) {
+        clearBoard(&decay->planes[k]);
+    }
+}
+
+void clearTileDecay(DecayPlanes * const decay, const unsigned int row, const unsigned int col) {
+    for (unsigned int k = 0; k < decay->nplanes; ++k) {
+        setTileState(&decay->planes[k], DEAD, row, col);
+    }
+}
+
+void clearDecayRect(DecayPlanes * const decay, const unsigned int rowBegin, const unsigned int rowEnd,
+                    const unsigned int colBegin, const unsigned int colEnd) {
+    for (unsigned int k = 0; k < decay->nplanes; ++k) {
+        fillBoardRect(&decay->planes[k], DEAD, rowBegin, rowEnd, colBegin, colEnd);
+    }
+}
+
+unsigned int decayTileState(const DecayPlanes * const decay, const Board * const board, const unsigned int row,
+                            const unsigned int col) {
+    if (getTileState(board, row, col) == ALIVE) {
+        return 1;
+    }
+    unsigned int age = 0;
+    for (unsigned int k = 0; k < decay->nplanes; ++k) {
+        age |= (unsigned int) getTileState(&decay->planes[k], row, col) << k;
+    }
+    return age == 0 ? 0 : age + 1;
+}
+
+// The age of the tiles of a word is a ripple carry counter across the planes.
+// Tiles of the oldest age die instead of carrying on, found by comparing each
+// plane with the matching bit of that age.
+bool stepDecayRows(DecayPlanes * const decay, const Board * const current, Board * const next,
+                   const unsigned int rowBegin, const unsigned int rowEnd) {
+    const unsigned int nplanes = decay->nplanes;
+    const unsigned int lastAge = decay->states - 2;
+    const unsigned int lastWord = current->wordsPerRow - 1;
+    const BoardWord mask = lastWordMask(current);
+    BoardWord *planeRows[MAX_DECAY_PLANES];
+    BoardWord any = 0;
+    for (unsigned int row = rowBegin; row < rowEnd; ++row) {
+        for (unsigned int k = 0; k < nplanes; ++k) {
+            planeRows[k] = getBoardRow(&decay->planes[k], row);
+        }
+        const BoardWord * const before = getBoardRow(current, row);
+        BoardWord * const after = getBoardRow(next, row);
+        for (unsigned int w = 0; w <= lastWord; ++w) {
+            BoardWord dying = 0;
+            BoardWord oldest = ~(BoardWord) 0;
+            for (unsigned int k = 0; k < nplanes; ++k) {
+                const BoardWord plane = planeRows[k][w];
+                dying |= plane;
+                oldest &= (lastAge >> k) & 1 ? plane : ~plane;
+            }
+            oldest &= dying;
+            const BoardWord alive = w == lastWord ? before[w] & mask : before[w];
+            after[w] &= ~dying;
+            const BoardWord started = alive & ~after[w];
+            BoardWord carry = dying & ~oldest;
+            for (unsigned int k = 0; k < nplanes; ++k) {
+                const BoardWord plane = planeRows[k][w] & ~oldest;
+                planeRows[k][w] = plane ^ carry;
+                carry &= plane;
+            }
+            planeRows[0][w] |= started;
+            any |= dying | started;
+        }
+    }
+    return any != 0;
+}
@@ -0,0 +1,56 @@
+#ifndef CONWAY_DECAY_H
+#define CONWAY_DECAY_H
+
+#include <stdbool.h>
+
+#include "board.h"
+#include "rule.h"
+
+// The dying tiles of a Generations rule.  The live tiles stay on the board,
+// stepped by the two-state kernels exactly as under the Life-like rule with
+// the same births and survivals, since only they count as neighbours.  Beside
+// the board, each tile has an age: 0 if it is alive or dead, or else how many
+// generations it has been dying, from 1 up to states - 2, so its state is its
+// age plus one.  The ages are bit sliced over planes laid out like the board,
+// plane k holding bit k of every tile's age, so that a generation of decay is
+// a few word operations per plane for 64 tiles at a time, with no neighbours.
+#define MAX_DECAY_PLANES 8
+
+typedef struct DecayPlanes {
+    unsigned int states;
+    unsigned int nplanes;
+    Board planes[MAX_DECAY_PLANES];
+} DecayPlanes;
+
+// Sizes the planes for board under a rule with states states, more than 2,
+// with no tile dying.  Returns false, leaving the planes empty, if the
+// allocation fails.
+bool initDecayPlanes(DecayPlanes * const decay, const Board * const board, const unsigned int states);
+
+void destroyDecayPlanes(DecayPlanes * const decay);
+
+// Makes every tile's age 0.
+void clearDecayPlanes(DecayPlanes * const decay);
+
+// Makes a tile's age 0, after it was set alive or dead.
+void clearTileDecay(DecayPlanes * const decay, const unsigned int row, const unsigned int col);
+
+// As clearTileDecay(), for rows [rowBegin, rowEnd) and columns [colBegin,
+// colEnd), a word at a time.
+void clearDecayRect(DecayPlanes * const decay, const unsigned int rowBegin, const unsigned int rowEnd,
+                    const unsigned int colBegin, const unsigned int colEnd);
+
+// The state of a tile of board, 0 dead, 1 alive, or from 2 up if dying.
+unsigned int decayTileState(const DecayPlanes * const decay, const Board * const board, const unsigned int row,
+                            const unsigned int col);
+
+// Ages rows [rowBegin, rowEnd) a generation from current to next, which the
+// two-state kernels have just stepped: births onto dying tiles are taken back
+// out of next, the tiles that stopped being alive start dying, and the rest
+// of the dying tiles get a generation older, or die.  Returns whether any of
+// the rows' tiles was dying or started to.  Rows of different workers can be
+// aged concurrently.
+bool stepDecayRows(DecayPlanes * const decay, const Board * const current, Board * const next,
+                   const unsigned int rowBegin, const unsigned int rowEnd);
+
+#endif
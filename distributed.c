@@ -0,0 +1,425 @@
+#include "distributed.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "packed.h"
+
+// Tags of halo messages, by the direction they travel in.
+enum { TAG_NORTH = 1, TAG_SOUTH, TAG_WEST, TAG_EAST };
+
+static unsigned int wordsFor(const unsigned int ncols) {
+    return (ncols + BOARD_WORD_BITS - 1) / BOARD_WORD_BITS;
+}
+
+// Mask of the bits of a word holding the first ncols % BOARD_WORD_BITS
+// tiles, every bit if that is 0.
+static BoardWord tailMask(const unsigned int ncols) {
+    const unsigned int rem = ncols % BOARD_WORD_BITS;
+    return rem == 0 ? ~(BoardWord) 0 : ((BoardWord) 1 << rem) - 1;
+}
+
+// The block of the rank at coords.  Rows are shared out evenly, and so are
+// the words of a row, which keeps every block but the last in a row of ranks
+// a whole number of words wide.
+static void findBlock(const DistributedBoard * const dist, const int coords[2], unsigned int * const rowBegin,
+                      unsigned int * const blockRows, unsigned int * const colBegin, unsigned int * const blockCols) {
+    const uint64_t nrows = dist->nrows;
+    const uint64_t nwords = wordsFor(dist->ncols);
+    *rowBegin = (unsigned int) (nrows * coords[0] / dist->dims[0]);
+    *blockRows = (unsigned int) (nrows * (coords[0] + 1) / dist->dims[0]) - *rowBegin;
+    const unsigned int wordBegin = (unsigned int) (nwords * coords[1] / dist->dims[1]);
+    const unsigned int wordEnd = (unsigned int) (nwords * (coords[1] + 1) / dist->dims[1]);
+    *colBegin = wordBegin * BOARD_WORD_BITS;
+    const unsigned int colEnd = wordEnd * BOARD_WORD_BITS;
+    *blockCols = (colEnd < dist->ncols ? colEnd : dist->ncols) - *colBegin;
+}
+
+// Checks the grid against the board using only what every rank knows, so
+// that every rank comes to the same answer without talking to the others.
+static bool checkGrid(const DistributedBoard * const dist) {
+    const bool torus = dist->topology == TOPOLOGY_TORUS;
+    if ((unsigned int) dist->dims[0] > dist->nrows || (unsigned int) dist->dims[1] > wordsFor(dist->ncols)) {
+        if (dist->rank == 0) {
+            fprintf(stderr, "conway-mpi: a %dx%d grid of ranks doesn't fit a %ux%u board\n", dist->dims[0],
+                    dist->dims[1], dist->nrows, dist->ncols);
+        }
+        return false;
+    }
+    // Only blocks with a neighbour have their edges exchanged.
+    unsigned int minRows = dist->nrows, minCols = dist->ncols;
+    const int n = dist->dims[0] > dist->dims[1] ? dist->dims[0] : dist->dims[1];
+    for (int i = 0; i < n; ++i) {
+        const int coords[2] = {i < dist->dims[0] ? i : 0, i < dist->dims[1] ? i : 0};
+        unsigned int rowBegin, blockRows, colBegin, blockCols;
+        findBlock(dist, coords, &rowBegin, &blockRows, &colBegin, &blockCols);
+        minRows = blockRows < minRows ? blockRows : minRows;
+        minCols = blockCols < minCols ? blockCols : minCols;
+    }
+    if (((dist->dims[0] > 1 || torus) && minRows < dist->haloDepth)
+            || ((dist->dims[1] > 1 || torus) && minCols < dist->haloDepth)) {
+        if (dist->rank == 0) {
+            fprintf(stderr, "conway-mpi: blocks of %ux%u tiles are too small for a halo %u deep\n", minRows,
+                    minCols, dist->haloDepth);
+        }
+        return false;
+    }
+    return true;
+}
+
+// Whether a grid of dims, where 0 is any number, can hold exactly nranks.
+static bool gridFits(const int dims[2], const int nranks) {
+    if (dims[0] < 0 || dims[1] < 0) {
+        return false;
+    }
+    if (dims[0] != 0 && dims[1] != 0) {
+        return dims[0] * dims[1] == nranks;
+    }
+    const int fixed = dims[0] != 0 ? dims[0] : dims[1];
+    return fixed == 0 || nranks % fixed == 0;
+}
+
+bool initDistributedBoard(DistributedBoard * const dist, MPI_Comm comm, const unsigned int nrows,
+                          const unsigned int ncols, const Topology topology, const LifeRule rule,
+                          const unsigned int haloDepth, const int dims[2]) {
+    memset(dist, 0, sizeof(*dist));
+    dist->comm = MPI_COMM_NULL;
+    dist->nrows = nrows;
+    dist->ncols = ncols;
+    dist->topology = topology;
+    dist->rule = rule;
+    dist->haloDepth = haloDepth;
+    MPI_Comm_size(comm, &dist->nranks);
+    MPI_Comm_rank(comm, &dist->rank);
+    if (!gridFits(dims, dist->nranks)) {
+        if (dist->rank == 0) {
+            fprintf(stderr, "conway-mpi: a %dx%d grid can't hold %d ranks\n", dims[0], dims[1], dist->nranks);
+        }
+        return false;
+    }
+    dist->dims[0] = dims[0];
+    dist->dims[1] = dims[1];
+    MPI_Dims_create(dist->nranks, 2, dist->dims);
+    if (haloDepth == 0 || haloDepth > MAX_HALO_DEPTH) {
+        if (dist->rank == 0) {
+            fprintf(stderr, "conway-mpi: the halo must be 1 to %d tiles deep\n", MAX_HALO_DEPTH);
+        }
+        return false;
+    }
+    if (!checkGrid(dist)) {
+        return false;
+    }
+
+    const int periods[2] = {topology == TOPOLOGY_TORUS, topology == TOPOLOGY_TORUS};
+    MPI_Cart_create(comm, 2, dist->dims, periods, 0, &dist->comm);
+    MPI_Comm_rank(dist->comm, &dist->rank);
+    MPI_Cart_coords(dist->comm, dist->rank, 2, dist->coords);
+    MPI_Cart_shift(dist->comm, 0, 1, &dist->north, &dist->south);
+    MPI_Cart_shift(dist->comm, 1, 1, &dist->west, &dist->east);
+    findBlock(dist, dist->coords, &dist->rowBegin, &dist->blockRows, &dist->colBegin, &dist->blockCols);
+
+    dist->haloNorth = dist->north != MPI_PROC_NULL ? haloDepth : 0;
+    dist->haloSouth = dist->south != MPI_PROC_NULL ? haloDepth : 0;
+    dist->haloWest = dist->west != MPI_PROC_NULL ? 1 : 0;
+    dist->eastCol = dist->haloWest * BOARD_WORD_BITS + dist->blockCols;
+    const unsigned int localRows = dist->haloNorth + dist->blockRows + dist->haloSouth;
+    const unsigned int localCols = dist->eastCol + (dist->east != MPI_PROC_NULL ? BOARD_WORD_BITS : 0);
+    bool ok = initBoard(&dist->current, localRows, localCols) && initBoard(&dist->next, localRows, localCols);
+    const size_t stripBytes = dist->blockRows * sizeof(BoardWord);
+    dist->sendWest = (BoardWord *) malloc(stripBytes);
+    dist->sendEast = (BoardWord *) malloc(stripBytes);
+    dist->recvWest = (BoardWord *) malloc(stripBytes);
+    dist->recvEast = (BoardWord *) malloc(stripBytes);
+    ok = ok && dist->sendWest != NULL && dist->sendEast != NULL && dist->recvWest != NULL && dist->recvEast != NULL;
+
+    int allOk = ok;
+    MPI_Allreduce(MPI_IN_PLACE, &allOk, 1, MPI_INT, MPI_LAND, dist->comm);
+    if (!allOk && dist->rank == 0) {
+        fprintf(stderr, "conway-mpi: out of memory\n");
+    }
+    return allOk;
+}
+
+void destroyDistributedBoard(DistributedBoard * const dist) {
+    destroyBoard(&dist->current);
+    destroyBoard(&dist->next);
+    free(dist->sendWest);
+    free(dist->sendEast);
+    free(dist->recvWest);
+    free(dist->recvEast);
+    dist->sendWest = dist->sendEast = dist->recvWest = dist->recvEast = NULL;
+    if (dist->comm != MPI_COMM_NULL) {
+        MPI_Comm_free(&dist->comm);
+    }
+}
+
+// The BOARD_WORD_BITS tiles of row from column col on, with those past the
+// end of the row dead.
+static BoardWord getRowBits(const Board * const board, const unsigned int row, const unsigned int col) {
+    const BoardWord * const words = getBoardRow(board, row);
+    const unsigned int w = col / BOARD_WORD_BITS;
+    const unsigned int shift = col % BOARD_WORD_BITS;
+    BoardWord bits = words[w] >> shift;
+    if (shift != 0 && w + 1 < board->wordsPerRow) {
+        bits |= words[w + 1] << (BOARD_WORD_BITS - shift);
+    }
+    return bits;
+}
+
+// Sets the BOARD_WORD_BITS tiles of row from column col on, which must all be
+// on the board.
+static void setRowBits(Board * const board, const unsigned int row, const unsigned int col, const BoardWord bits) {
+    BoardWord * const words = getBoardRow(board, row);
+    const unsigned int w = col / BOARD_WORD_BITS;
+    const unsigned int shift = col % BOARD_WORD_BITS;
+    const BoardWord below = ((BoardWord) 1 << shift) - 1;
+    words[w] = (words[w] & below) | bits << shift;
+    if (shift != 0) {
+        words[w + 1] = (words[w + 1] & ~below) | bits >> (BOARD_WORD_BITS - shift);
+    }
+}
+
+// Sums over every rank, returning the totals on all of them.
+static void sumOverRanks(const DistributedBoard * const dist, uint64_t * const values, const int count) {
+    MPI_Allreduce(MPI_IN_PLACE, values, count, MPI_UINT64_T, MPI_SUM, dist->comm);
+}
+
+static uint64_t blockPopulation(const DistributedBoard * const dist, const Board * const board) {
+    const unsigned int nwords = wordsFor(dist->blockCols);
+    const BoardWord mask = tailMask(dist->blockCols);
+    uint64_t population = 0;
+    for (unsigned int r = 0; r < dist->blockRows; ++r) {
+        const BoardWord * const words = getBoardRow(board, dist->haloNorth + r) + dist->haloWest;
+        for (unsigned int w = 0; w + 1 < nwords; ++w) {
+            population += popcountWord(words[w]);
+        }
+        population += popcountWord(words[nwords - 1] & mask);
+    }
+    return population;
+}
+
+static bool blocksDiffer(const DistributedBoard * const dist, const Board * const a, const Board * const b) {
+    const unsigned int nwords = wordsFor(dist->blockCols);
+    const BoardWord mask = tailMask(dist->blockCols);
+    for (unsigned int r = 0; r < dist->blockRows; ++r) {
+        const BoardWord * const wordsA = getBoardRow(a, dist->haloNorth + r) + dist->haloWest;
+        const BoardWord * const wordsB = getBoardRow(b, dist->haloNorth + r) + dist->haloWest;
+        if ((nwords > 1 && memcmp(wordsA, wordsB, (nwords - 1) * sizeof(BoardWord)) != 0)
+                || ((wordsA[nwords - 1] ^ wordsB[nwords - 1]) & mask) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void loadDistributedBoard(DistributedBoard * const dist, const Board * const board) {
+    clearBoard(&dist->current);
+    const unsigned int nwords = wordsFor(dist->blockCols);
+    const unsigned int wordBegin = dist->colBegin / BOARD_WORD_BITS;
+    const BoardWord mask = tailMask(dist->blockCols);
+    for (unsigned int r = 0; r < dist->blockRows && dist->rowBegin + r < board->nrows; ++r) {
+        const BoardWord * const src = getBoardRow(board, dist->rowBegin + r);
+        BoardWord * const dst = getBoardRow(&dist->current, dist->haloNorth + r) + dist->haloWest;
+        for (unsigned int w = 0; w < nwords && wordBegin + w < board->wordsPerRow; ++w) {
+            dst[w] = w == nwords - 1 ? src[wordBegin + w] & mask : src[wordBegin + w];
+        }
+    }
+    uint64_t population = blockPopulation(dist, &dist->current);
+    sumOverRanks(dist, &population, 1);
+    dist->population = population;
+}
+
+// Sends the block's first and last columns west and east.  The east strip is
+// aligned so that its last tile is the top bit, ready to be the west halo
+// word of the rank it goes to.
+static int startEastWestExchange(DistributedBoard * const dist, MPI_Request * const requests) {
+    const Board * const board = &dist->current;
+    const unsigned int westCol = dist->haloWest * BOARD_WORD_BITS;
+    const unsigned int width = dist->blockCols < BOARD_WORD_BITS ? dist->blockCols : BOARD_WORD_BITS;
+    const BoardWord mask = tailMask(width);
+    for (unsigned int r = 0; r < dist->blockRows; ++r) {
+        const unsigned int row = dist->haloNorth + r;
+        dist->sendWest[r] = getRowBits(board, row, westCol) & mask;
+        dist->sendEast[r] = (getRowBits(board, row, dist->eastCol - width) & mask) << (BOARD_WORD_BITS - width);
+    }
+    int nrequests = 0;
+    const int count = (int) dist->blockRows;
+    if (dist->west != MPI_PROC_NULL) {
+        MPI_Irecv(dist->recvWest, count, MPI_UINT64_T, dist->west, TAG_EAST, dist->comm, &requests[nrequests++]);
+        MPI_Isend(dist->sendWest, count, MPI_UINT64_T, dist->west, TAG_WEST, dist->comm, &requests[nrequests++]);
+    }
+    if (dist->east != MPI_PROC_NULL) {
+        MPI_Irecv(dist->recvEast, count, MPI_UINT64_T, dist->east, TAG_WEST, dist->comm, &requests[nrequests++]);
+        MPI_Isend(dist->sendEast, count, MPI_UINT64_T, dist->east, TAG_EAST, dist->comm, &requests[nrequests++]);
+    }
+    return nrequests;
+}
+
+static void finishEastWestExchange(DistributedBoard * const dist, MPI_Request * const requests, const int nrequests) {
+    MPI_Waitall(nrequests, requests, MPI_STATUSES_IGNORE);
+    for (unsigned int r = 0; r < dist->blockRows; ++r) {
+        const unsigned int row = dist->haloNorth + r;
+        if (dist->west != MPI_PROC_NULL) {
+            getBoardRow(&dist->current, row)[0] = dist->recvWest[r];
+        }
+        if (dist->east != MPI_PROC_NULL) {
+            setRowBits(&dist->current, row, dist->eastCol, dist->recvEast[r]);
+        }
+    }
+}
+
+// Sends the block's first and last haloDepth rows north and south, straight
+// out of the board and into the neighbours' halo rows.  The rows include
+// their east and west halos, so this also fills the corners of the halo
+// once the east and west exchange is done.  The words of the board's own
+// halo between the rows go along too, but fillBoardHalo() resets them before
+// they are read.
+static int startNorthSouthExchange(DistributedBoard * const dist, MPI_Request * const requests) {
+    Board * const board = &dist->current;
+    const unsigned int depth = dist->haloDepth;
+    const int count = (int) ((depth - 1) * board->rowStride + board->wordsPerRow);
+    int nrequests = 0;
+    if (dist->north != MPI_PROC_NULL) {
+        MPI_Irecv(getBoardRow(board, 0), count, MPI_UINT64_T, dist->north, TAG_SOUTH, dist->comm,
+                  &requests[nrequests++]);
+        MPI_Isend(getBoardRow(board, dist->haloNorth), count, MPI_UINT64_T, dist->north, TAG_NORTH, dist->comm,
+                  &requests[nrequests++]);
+    }
+    if (dist->south != MPI_PROC_NULL) {
+        const unsigned int southRow = dist->haloNorth + dist->blockRows;
+        MPI_Irecv(getBoardRow(board, southRow), count, MPI_UINT64_T, dist->south, TAG_NORTH, dist->comm,
+                  &requests[nrequests++]);
+        MPI_Isend(getBoardRow(board, southRow - depth), count, MPI_UINT64_T, dist->south, TAG_SOUTH, dist->comm,
+                  &requests[nrequests++]);
+    }
+    return nrequests;
+}
+
+// Steps the first generation after an exchange, overlapping it with the
+// exchange.  The inner part of the local board, which reads no halo tile, is
+// stepped half while the east and west halos are in flight and half while
+// the north and south ones are, and the rest once they have arrived.
+static void stepExchanging(DistributedBoard * const dist) {
+    const Board * const src = &dist->current;
+    Board * const dst = &dist->next;
+    const unsigned int nrows = src->nrows;
+    const unsigned int nwords = src->wordsPerRow;
+    // A word reads the nearest tile of the words either side.
+    unsigned int innerRowBegin = dist->haloNorth != 0 ? dist->haloNorth + 1 : 0;
+    unsigned int innerRowEnd = dist->haloSouth != 0 ? dist->haloNorth + dist->blockRows - 1 : nrows;
+    const unsigned int innerWordBegin = dist->haloWest != 0 ? dist->haloWest + 1 : 0;
+    const unsigned int innerWordEnd = dist->east != MPI_PROC_NULL ? (dist->eastCol - 1) / BOARD_WORD_BITS : nwords;
+    if (innerRowBegin >= innerRowEnd || innerWordBegin >= innerWordEnd) {
+        innerRowBegin = innerRowEnd = 0;
+    }
+    const unsigned int innerRowMid = innerRowBegin + (innerRowEnd - innerRowBegin) / 2;
+
+    // fillBoardHalo() only touches the board's own halo, which no message
+    // reads or writes.
+    fillBoardHalo(&dist->current, TOPOLOGY_BOUNDED);
+    MPI_Request requests[4];
+    int nrequests = startEastWestExchange(dist, requests);
+    stepPackedRect(&dist->rule, src, dst, innerRowBegin, innerRowMid, innerWordBegin, innerWordEnd);
+    finishEastWestExchange(dist, requests, nrequests);
+
+    nrequests = startNorthSouthExchange(dist, requests);
+    stepPackedRect(&dist->rule, src, dst, innerRowMid, innerRowEnd, innerWordBegin, innerWordEnd);
+    MPI_Waitall(nrequests, requests, MPI_STATUSES_IGNORE);
+    // The messages overwrote the halo words between the rows received.
+    fillBoardHalo(&dist->current, TOPOLOGY_BOUNDED);
+
+    stepPackedRows(&dist->rule, src, dst, 0, innerRowBegin);
+    stepPackedRows(&dist->rule, src, dst, innerRowEnd, nrows);
+    if (innerRowBegin < innerRowEnd) {
+        stepPackedRect(&dist->rule, src, dst, innerRowBegin, innerRowEnd, 0, innerWordBegin);
+        stepPackedRect(&dist->rule, src, dst, innerRowBegin, innerRowEnd, innerWordEnd, nwords);
+    }
+}
+
+static void swapBoards(DistributedBoard * const dist) {
+    const Board tmp = dist->current;
+    dist->current = dist->next;
+    dist->next = tmp;
+}
+
+bool stepDistributedBoard(DistributedBoard * const dist, const uint64_t maxGenerations) {
+    const uint64_t generations = maxGenerations < dist->haloDepth ? maxGenerations : dist->haloDepth;
+    if (generations == 0) {
+        return true;
+    }
+    bool changed = false;
+    for (uint64_t i = 0; i < generations; ++i) {
+        if (i == 0) {
+            stepExchanging(dist);
+        } else {
+            fillBoardHalo(&dist->current, TOPOLOGY_BOUNDED);
+            stepPackedRows(&dist->rule, &dist->current, &dist->next, 0, dist->current.nrows);
+        }
+        if (i == generations - 1) {
+            changed = blocksDiffer(dist, &dist->current, &dist->next);
+        }
+        swapBoards(dist);
+    }
+    dist->tick += generations;
+
+    uint64_t totals[2] = {blockPopulation(dist, &dist->current), changed};
+    sumOverRanks(dist, totals, 2);
+    dist->population = totals[0];
+    return totals[1] != 0;
+}
+
+// A block of blockRows rows of board by blockCols columns, as an MPI datatype
+// starting at the block's first word.
+static MPI_Datatype blockType(const Board * const board, const unsigned int blockRows, const unsigned int blockCols) {
+    MPI_Datatype type;
+    MPI_Type_vector((int) blockRows, (int) wordsFor(blockCols), (int) board->rowStride, MPI_UINT64_T, &type);
+    MPI_Type_commit(&type);
+    return type;
+}
+
+bool gatherDistributedBoard(DistributedBoard * const dist, Board * const board) {
+    const BoardWord * const ownBlock = getBoardRow(&dist->current, dist->haloNorth) + dist->haloWest;
+    int ok = 1;
+    if (dist->rank != 0) {
+        MPI_Bcast(&ok, 1, MPI_INT, 0, dist->comm);
+        if (ok) {
+            MPI_Datatype type = blockType(&dist->current, dist->blockRows, dist->blockCols);
+            MPI_Send(ownBlock, 1, type, 0, 0, dist->comm);
+            MPI_Type_free(&type);
+        }
+        return true;
+    }
+
+    ok = initBoard(board, dist->nrows, dist->ncols);
+    MPI_Bcast(&ok, 1, MPI_INT, 0, dist->comm);
+    if (!ok) {
+        return false;
+    }
+    for (int rank = 0; rank < dist->nranks; ++rank) {
+        int coords[2];
+        MPI_Cart_coords(dist->comm, rank, 2, coords);
+        unsigned int rowBegin, blockRows, colBegin, blockCols;
+        findBlock(dist, coords, &rowBegin, &blockRows, &colBegin, &blockCols);
+        BoardWord * const dst = getBoardRow(board, rowBegin) + colBegin / BOARD_WORD_BITS;
+        if (rank == dist->rank) {
+            for (unsigned int r = 0; r < blockRows; ++r) {
+                memcpy(dst + (size_t) r * board->rowStride, ownBlock + (size_t) r * dist->current.rowStride,
+                       wordsFor(blockCols) * sizeof(BoardWord));
+            }
+            continue;
+        }
+        MPI_Datatype type = blockType(board, blockRows, blockCols);
+        MPI_Recv(dst, 1, type, rank, 0, dist->comm, MPI_STATUS_IGNORE);
+        MPI_Type_free(&type);
+    }
+    // The last word of a block with an east halo can hold some of it.
+    clearBoardPadding(board);
+    for (unsigned int row = 0; row < board->nrows; ++row) {
+        const BoardWord * const words = getBoardRow(board, row);
+        for (unsigned int w = 0; w < board->wordsPerRow; ++w) {
+            board->nalive += popcountWord(words[w]);
+        }
+    }
+    return true;
+}
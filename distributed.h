@@ -0,0 +1,103 @@
+#ifndef CONWAY_DISTRIBUTED_H
+#define CONWAY_DISTRIBUTED_H
+
+#include <mpi.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "board.h"
+#include "rule.h"
+
+// A board too large for one host, cut into a grid of rectangular blocks, one
+// per MPI rank.  Each rank steps its block padded with a halo of its
+// neighbours' tiles haloDepth deep, so that the ranks only need to exchange
+// halos once every haloDepth generations: a tile's state haloDepth
+// generations on depends only on tiles at most haloDepth away, so every tile
+// of the block stays exact for that long while the halo goes stale from the
+// outside in.
+//
+// Blocks are cut on word boundaries, so the tiles of a block are the same
+// words as in the whole board.  The halo is always BOARD_WORD_BITS columns
+// wide to the east and west, so that it is a whole word to the west, and
+// haloDepth rows to the north and south.  Halos are only kept on sides that
+// have a neighbour: the edges of a bounded board are left to the local
+// board's own halo, which is dead.
+//
+// With a single rank and a bounded board the local board is the whole board
+// and there is nothing to exchange, so stepping is the same as a single
+// process headless run with the packed engine.
+
+// Halos are exchanged east and west a word at a time, so they can't be any
+// deeper than a word is wide.
+#define MAX_HALO_DEPTH BOARD_WORD_BITS
+
+typedef struct DistributedBoard {
+    // Cartesian communicator over every rank, periodic for a torus.
+    MPI_Comm comm;
+    int rank;
+    int nranks;
+    // Ranks down and across, and this rank's place among them.
+    int dims[2];
+    int coords[2];
+    // Neighbouring ranks, MPI_PROC_NULL where there are none.
+    int north, south, west, east;
+
+    unsigned int nrows;
+    unsigned int ncols;
+    Topology topology;
+    LifeRule rule;
+    unsigned int haloDepth;
+
+    // The block: rows [rowBegin, rowBegin + blockRows) and columns
+    // [colBegin, colBegin + blockCols) of the whole board.  colBegin is a
+    // multiple of BOARD_WORD_BITS.
+    unsigned int rowBegin;
+    unsigned int blockRows;
+    unsigned int colBegin;
+    unsigned int blockCols;
+    // Halo rows above and below the block in the local board, and halo
+    // words before it, 0 on sides without a neighbour.
+    unsigned int haloNorth;
+    unsigned int haloSouth;
+    unsigned int haloWest;
+    // Column of the local board where the east halo starts.
+    unsigned int eastCol;
+
+    // The block and its halo, and the board the next generation goes into.
+    Board current;
+    Board next;
+    // One word per block row, for the east and west exchanges.
+    BoardWord *sendWest, *sendEast, *recvWest, *recvEast;
+
+    uint64_t tick;
+    // Of the whole board, as of the last stepDistributedBoard().
+    uint64_t population;
+} DistributedBoard;
+
+// Cuts a board of the given size into blocks over every rank of comm, dims[0]
+// down by dims[1] across, or as MPI_Dims_create() chooses where a dimension
+// is 0.  Collective.  Returns false on every rank, after rank 0 has printed a
+// message, if the grid doesn't fit the board or a block is too small for
+// haloDepth, or if memory runs out.
+bool initDistributedBoard(DistributedBoard * const dist, MPI_Comm comm, const unsigned int nrows,
+                          const unsigned int ncols, const Topology topology, const LifeRule rule,
+                          const unsigned int haloDepth, const int dims[2]);
+
+void destroyDistributedBoard(DistributedBoard * const dist);
+
+// Sets every rank's block to its part of board, which every rank holds in
+// full, with its top left corner at the top left corner of the whole board.
+// Tiles of board past the whole board are dropped.  Collective, for the
+// population.
+void loadDistributedBoard(DistributedBoard * const dist, const Board * const board);
+
+// Steps the whole board up to haloDepth generations on, but no more than
+// maxGenerations, in one halo exchange.  Collective.  Returns false if no
+// tile changed in the last of the generations, the board having settled.
+bool stepDistributedBoard(DistributedBoard * const dist, const uint64_t maxGenerations);
+
+// Gathers the whole board into board on rank 0, which is allocated there.
+// Collective.  Returns false on rank 0 if the allocation fails.
+bool gatherDistributedBoard(DistributedBoard * const dist, Board * const board);
+
+#endif
@@ -0,0 +1,59 @@
+#include "framering.h"
+
+#include <stdalign.h>
+#include <stdlib.h>
+
+bool initFrameRing(FrameRing * const ring, const unsigned int nslots, const size_t slotSize) {
+    const size_t align = alignof(max_align_t);
+    ring->slotSize = (slotSize + align - 1) / align * align;
+    ring->slots = (unsigned char *) malloc(nslots * ring->slotSize);
+    ring->nslots = nslots;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->reading = 0;
+    return ring->slots != NULL;
+}
+
+void destroyFrameRing(FrameRing * const ring) {
+    free(ring->slots);
+    ring->slots = NULL;
+}
+
+static unsigned char *frameSlot(const FrameRing * const ring, const uint64_t frame) {
+    return ring->slots + (size_t) (frame % ring->nslots) * ring->slotSize;
+}
+
+// Only the producer moves head, so it can read it relaxed.  The acquire of
+// tail orders the consumer's last reads of a released slot before the
+// producer's writes to it.
+void *frameRingAcquire(FrameRing * const ring) {
+    const uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    const uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return head - tail < ring->nslots ? frameSlot(ring, head) : NULL;
+}
+
+void frameRingPublish(FrameRing * const ring) {
+    const uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+// The producer only writes to frames from head on while fewer than nslots
+// frames are past tail, and tail isn't moved until release, so the frame
+// read here, which is between tail and head, isn't overwritten while it is
+// being read.
+const void *frameRingLatest(FrameRing * const ring, uint64_t * const dropped) {
+    const uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    const uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if (head == tail) {
+        return NULL;
+    }
+    if (dropped != NULL) {
+        *dropped += head - 1 - tail;
+    }
+    ring->reading = head - 1;
+    return frameSlot(ring, ring->reading);
+}
+
+void frameRingRelease(FrameRing * const ring) {
+    atomic_store_explicit(&ring->tail, ring->reading + 1, memory_order_release);
+}
@@ -0,0 +1,49 @@
+#ifndef CONWAY_FRAMERING_H
+#define CONWAY_FRAMERING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// A lock-free ring of fixed-size frames passed from exactly one producer
+// thread to exactly one consumer thread.  Neither side ever waits for the
+// other: a producer that finds the ring full drops its frame, and the
+// consumer always skips ahead to the newest frame, dropping the rest, so a
+// slow consumer costs frames rather than holding up the producer.
+typedef struct FrameRing {
+    unsigned char *slots;
+    size_t slotSize;
+    unsigned int nslots;
+    // Frames [tail, head) have been published and not yet released.  Each is
+    // only ever advanced by one side.
+    _Atomic uint64_t head;
+    _Atomic uint64_t tail;
+    // Of the consumer: the frame it holds, between frameRingLatest() and
+    // frameRingRelease().
+    uint64_t reading;
+} FrameRing;
+
+// Allocates nslots frames of slotSize bytes each, every one aligned for any
+// type.  nslots must be at least 2.  Returns false if the allocation fails.
+bool initFrameRing(FrameRing * const ring, const unsigned int nslots, const size_t slotSize);
+
+void destroyFrameRing(FrameRing * const ring);
+
+// Producer: returns the frame to fill next, or NULL if every frame is still
+// waiting for the consumer.
+void *frameRingAcquire(FrameRing * const ring);
+
+// Producer: hands the frame from frameRingAcquire() to the consumer.
+void frameRingPublish(FrameRing * const ring);
+
+// Consumer: returns the newest published frame, or NULL if there is none.
+// Older frames are dropped, and their number added to *dropped unless dropped
+// is NULL.  The frame stays the consumer's until frameRingRelease().
+const void *frameRingLatest(FrameRing * const ring, uint64_t * const dropped);
+
+// Consumer: gives the frame from frameRingLatest(), and every one before it,
+// back to the producer.
+void frameRingRelease(FrameRing * const ring);
+
+#endif
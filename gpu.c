@@ -0,0 +1,414 @@
+#include "gpu.h"
+
+#ifdef CONWAY_GPU
+
+#define CL_TARGET_OPENCL_VERSION 120
+#ifdef __APPLE__
+#include <OpenCL/opencl.h>
+#else
+#include <CL/cl.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "packed_kernel.h"
+
+// Each work-group steps a tile of rows by words, which it first loads into
+// local memory together with the words around it, and each of its work-items
+// one word.
+#define GPU_TILE_ROWS 16
+#define GPU_TILE_WORDS 16
+
+#define STRINGIFY(...) #__VA_ARGS__
+#define EXPAND_AND_STRINGIFY(...) STRINGIFY(__VA_ARGS__)
+
+// The word of the board at (row, w), where row may be -1 or nrows and w -1 or
+// nwords, as fillBoardHalo() would have it: dead beyond bounded edges, and
+// the opposite edge of a torus.  For a torus with a partial last word, the
+// west neighbour of column 0 is the last column, and the tile past the last
+// column is column 0.
+//
+// The new generation's totals are summed in local memory, then added to the
+// global ones by one work-item per group.  The 64-bit hash is XORed as two
+// halves, as 64-bit atomics are an extension.
+static const char kernelSource[] =
+    "ulong mixHash(ulong h) {\n"
+    "    h ^= h >> 33;\n"
+    "    h *= 0xFF51AFD7ED558CCDUL;\n"
+    "    h ^= h >> 33;\n"
+    "    h *= 0xC4CEB9FE1A85EC53UL;\n"
+    "    h ^= h >> 33;\n"
+    "    return h;\n"
+    "}\n"
+    "\n"
+    "ulong loadWord(__global const ulong *src, int row, const int w, const uint nrows, const uint nwords,\n"
+    "               const uint rem, const uint torus) {\n"
+    "    if (row < 0 || row >= (int) nrows) {\n"
+    "        if (!torus) {\n"
+    "            return 0;\n"
+    "        }\n"
+    "        row = row < 0 ? (int) nrows - 1 : 0;\n"
+    "    }\n"
+    "    __global const ulong *words = src + (size_t) row * nwords;\n"
+    "    if (w < 0) {\n"
+    "        return !torus ? 0 : rem == 0 ? words[nwords - 1] : words[nwords - 1] << (64 - rem);\n"
+    "    }\n"
+    "    if (w >= (int) nwords) {\n"
+    "        return torus ? words[0] : 0;\n"
+    "    }\n"
+    "    if (torus && rem != 0 && w == (int) nwords - 1) {\n"
+    "        return words[w] | (words[0] & 1) << rem;\n"
+    "    }\n"
+    "    return words[w];\n"
+    "}\n"
+    "\n"
+    "__kernel __attribute__((reqd_work_group_size(TILE_WORDS, TILE_ROWS, 1)))\n"
+    "void stepBoard(__global const ulong *src, __global ulong *dst, const uint nrows, const uint nwords,\n"
+    "               const uint rem, const uint torus, const uint birth, const uint survive,\n"
+    "               const uint hashing, __global uint *totals) {\n"
+    "    __local ulong tile[TILE_ROWS + 2][TILE_WORDS + 2];\n"
+    "    __local uint groupTotals[4];\n"
+    "    const uint lw = get_local_id(0);\n"
+    "    const uint lr = get_local_id(1);\n"
+    "    const int wordBase = (int) (get_group_id(0) * TILE_WORDS);\n"
+    "    const int rowBase = (int) (get_group_id(1) * TILE_ROWS);\n"
+    "    for (uint i = lr * TILE_WORDS + lw; i < (TILE_ROWS + 2) * (TILE_WORDS + 2); i += TILE_ROWS * TILE_WORDS) {\n"
+    "        const int tr = (int) (i / (TILE_WORDS + 2));\n"
+    "        const int tw = (int) (i % (TILE_WORDS + 2));\n"
+    "        tile[tr][tw] = loadWord(src, rowBase + tr - 1, wordBase + tw - 1, nrows, nwords, rem, torus);\n"
+    "    }\n"
+    "    if (lr == 0 && lw < 4) {\n"
+    "        groupTotals[lw] = 0;\n"
+    "    }\n"
+    "    barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "\n"
+    "    const uint row = (uint) rowBase + lr;\n"
+    "    const uint w = (uint) wordBase + lw;\n"
+    "    if (row < nrows && w < nwords) {\n"
+    "        const ulong aboveWest = tile[lr][lw], above = tile[lr][lw + 1], aboveEast = tile[lr][lw + 2];\n"
+    "        const ulong west = tile[lr + 1][lw], centre = tile[lr + 1][lw + 1], east = tile[lr + 1][lw + 2];\n"
+    "        const ulong belowWest = tile[lr + 2][lw], below = tile[lr + 2][lw + 1];\n"
+    "        const ulong belowEast = tile[lr + 2][lw + 2];\n"
+    "        " EXPAND_AND_STRINGIFY(STEP_WORD_PARTIAL_SUMS(ulong)) "\n"
+    "        const ulong twosSum = aboveTwos ^ belowTwos ^ middleTwos;\n"
+    "        const ulong twosCarry = (aboveTwos & belowTwos) | (middleTwos & (aboveTwos ^ belowTwos));\n"
+    "        const ulong twos = twosSum ^ onesCarry;\n"
+    "        const ulong foursCarry = twosSum & onesCarry;\n"
+    "        const ulong fours = twosCarry ^ foursCarry;\n"
+    "        const ulong eights = twosCarry & foursCarry;\n"
+    "        ulong next = 0;\n"
+    "        for (uint n = 0; n < 9; ++n) {\n"
+    "            const uint bit = 1u << n;\n"
+    "            if (((birth | survive) & bit) == 0) {\n"
+    "                continue;\n"
+    "            }\n"
+    "            const ulong count = ((n & 1) ? ones : ~ones) & ((n & 2) ? twos : ~twos)\n"
+    "                    & ((n & 4) ? fours : ~fours) & ((n & 8) ? eights : ~eights);\n"
+    "            if (birth & bit) {\n"
+    "                next |= count & ~centre;\n"
+    "            }\n"
+    "            if (survive & bit) {\n"
+    "                next |= count & centre;\n"
+    "            }\n"
+    "        }\n"
+    "        const ulong mask = w == nwords - 1 && rem != 0 ? ((ulong) 1 << rem) - 1 : ~(ulong) 0;\n"
+    "        next &= mask;\n"
+    "        dst[(size_t) row * nwords + w] = next;\n"
+    "\n"
+    "        const uint population = popcount(next);\n"
+    "        const uint flips = popcount(next ^ (centre & mask));\n"
+    "        if (population != 0) {\n"
+    "            atomic_add(&groupTotals[0], population);\n"
+    "        }\n"
+    "        if (flips != 0) {\n"
+    "            atomic_add(&groupTotals[1], flips);\n"
+    "        }\n"
+    "        if (hashing && next != 0) {\n"
+    "            const ulong position = (ulong) row * nwords + w;\n"
+    "            const ulong hash = mixHash((position + 1) * 0x9E3779B97F4A7C15UL ^ next);\n"
+    "            atomic_xor(&groupTotals[2], (uint) hash);\n"
+    "            atomic_xor(&groupTotals[3], (uint) (hash >> 32));\n"
+    "        }\n"
+    "    }\n"
+    "    barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "    if (lr == 0 && lw == 0) {\n"
+    "        atomic_add(&totals[0], groupTotals[0]);\n"
+    "        atomic_add(&totals[1], groupTotals[1]);\n"
+    "        atomic_xor(&totals[2], groupTotals[2]);\n"
+    "        atomic_xor(&totals[3], groupTotals[3]);\n"
+    "    }\n"
+    "}\n";
+
+struct GpuBoard {
+    cl_context context;
+    cl_command_queue queue;
+    cl_program program;
+    cl_kernel kernel;
+    // The current generation and the next, swapped by every step.
+    cl_mem boards[2];
+    unsigned int current;
+    // Population, flips and the two halves of the hash, summed by a step.
+    cl_mem totals;
+    unsigned int nrows;
+    unsigned int ncols;
+    unsigned int wordsPerRow;
+};
+
+// The first GPU of any platform, or failing that the first device of any
+// kind.
+static bool findDevice(cl_device_id * const device) {
+    cl_uint nplatforms = 0;
+    if (clGetPlatformIDs(0, NULL, &nplatforms) != CL_SUCCESS || nplatforms == 0) {
+        return false;
+    }
+    cl_platform_id * const platforms = (cl_platform_id *) malloc(nplatforms * sizeof(cl_platform_id));
+    if (platforms == NULL || clGetPlatformIDs(nplatforms, platforms, NULL) != CL_SUCCESS) {
+        free(platforms);
+        return false;
+    }
+    bool found = false;
+    for (int pass = 0; pass < 2 && !found; ++pass) {
+        const cl_device_type type = pass == 0 ? CL_DEVICE_TYPE_GPU : CL_DEVICE_TYPE_ALL;
+        for (cl_uint i = 0; i < nplatforms && !found; ++i) {
+            found = clGetDeviceIDs(platforms[i], type, 1, device, NULL) == CL_SUCCESS;
+        }
+    }
+    free(platforms);
+    return found;
+}
+
+bool findGpuDevice(char * const name, const size_t size) {
+    cl_device_id device;
+    if (!findDevice(&device)) {
+        return false;
+    }
+    if (size != 0 && clGetDeviceInfo(device, CL_DEVICE_NAME, size, name, NULL) != CL_SUCCESS) {
+        snprintf(name, size, "unknown device");
+    }
+    return true;
+}
+
+// Prints why the kernel didn't build, which is only ever a driver problem.
+static void printBuildLog(const cl_program program, const cl_device_id device) {
+    size_t size = 0;
+    clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, 0, NULL, &size);
+    char * const log = (char *) malloc(size + 1);
+    if (log != NULL && clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, size, log, NULL) == CL_SUCCESS) {
+        log[size] = '\0';
+        fprintf(stderr, "conway: the GPU kernel failed to build:\n%s\n", log);
+    }
+    free(log);
+}
+
+static bool buildKernel(GpuBoard * const gpu, const cl_device_id device) {
+    cl_int err;
+    const char *source = kernelSource;
+    gpu->program = clCreateProgramWithSource(gpu->context, 1, &source, NULL, &err);
+    if (err != CL_SUCCESS) {
+        gpu->program = NULL;
+        return false;
+    }
+    char options[64];
+    snprintf(options, sizeof(options), "-DTILE_ROWS=%d -DTILE_WORDS=%d", GPU_TILE_ROWS, GPU_TILE_WORDS);
+    if (clBuildProgram(gpu->program, 1, &device, options, NULL, NULL) != CL_SUCCESS) {
+        printBuildLog(gpu->program, device);
+        return false;
+    }
+    gpu->kernel = clCreateKernel(gpu->program, "stepBoard", &err);
+    if (err != CL_SUCCESS) {
+        gpu->kernel = NULL;
+        return false;
+    }
+    return true;
+}
+
+GpuBoard *createGpuBoard(const Board * const board) {
+    cl_device_id device;
+    if (!findDevice(&device)) {
+        return NULL;
+    }
+    GpuBoard * const gpu = (GpuBoard *) calloc(1, sizeof(GpuBoard));
+    if (gpu == NULL) {
+        return NULL;
+    }
+    gpu->nrows = board->nrows;
+    gpu->ncols = board->ncols;
+    gpu->wordsPerRow = board->wordsPerRow;
+
+    cl_int err;
+    gpu->context = clCreateContext(NULL, 1, &device, NULL, NULL, &err);
+    bool ok = err == CL_SUCCESS;
+    if (!ok) {
+        gpu->context = NULL;
+    }
+    if (ok) {
+        gpu->queue = clCreateCommandQueue(gpu->context, device, 0, &err);
+        ok = err == CL_SUCCESS;
+        if (!ok) {
+            gpu->queue = NULL;
+        }
+    }
+    ok = ok && buildKernel(gpu, device);
+    const size_t bytes = (size_t) board->nrows * board->wordsPerRow * sizeof(BoardWord);
+    for (int i = 0; ok && i < 2; ++i) {
+        gpu->boards[i] = clCreateBuffer(gpu->context, CL_MEM_READ_WRITE, bytes, NULL, &err);
+        ok = err == CL_SUCCESS;
+        if (!ok) {
+            gpu->boards[i] = NULL;
+        }
+    }
+    if (ok) {
+        gpu->totals = clCreateBuffer(gpu->context, CL_MEM_READ_WRITE, 4 * sizeof(cl_uint), NULL, &err);
+        ok = err == CL_SUCCESS;
+        if (!ok) {
+            gpu->totals = NULL;
+        }
+    }
+    if (!ok || !gpuLoadBoard(gpu, board)) {
+        destroyGpuBoard(gpu);
+        return NULL;
+    }
+    return gpu;
+}
+
+void destroyGpuBoard(GpuBoard * const gpu) {
+    if (gpu == NULL) {
+        return;
+    }
+    for (int i = 0; i < 2; ++i) {
+        if (gpu->boards[i] != NULL) {
+            clReleaseMemObject(gpu->boards[i]);
+        }
+    }
+    if (gpu->totals != NULL) {
+        clReleaseMemObject(gpu->totals);
+    }
+    if (gpu->kernel != NULL) {
+        clReleaseKernel(gpu->kernel);
+    }
+    if (gpu->program != NULL) {
+        clReleaseProgram(gpu->program);
+    }
+    if (gpu->queue != NULL) {
+        clReleaseCommandQueue(gpu->queue);
+    }
+    if (gpu->context != NULL) {
+        clReleaseContext(gpu->context);
+    }
+    free(gpu);
+}
+
+// The device's boards are packed rows with no halo, so the transfers pick
+// the rows out of the host's with their pitches.
+bool gpuLoadBoard(GpuBoard * const gpu, const Board * const board) {
+    const size_t origin[3] = {0, 0, 0};
+    const size_t region[3] = {gpu->wordsPerRow * sizeof(BoardWord), gpu->nrows, 1};
+    return clEnqueueWriteBufferRect(gpu->queue, gpu->boards[gpu->current], CL_TRUE, origin, origin, region,
+                                    region[0], 0, board->rowStride * sizeof(BoardWord), 0, board->words, 0, NULL,
+                                    NULL) == CL_SUCCESS;
+}
+
+bool gpuExportBoard(const GpuBoard * const gpu, Board * const board) {
+    const size_t origin[3] = {0, 0, 0};
+    const size_t region[3] = {gpu->wordsPerRow * sizeof(BoardWord), gpu->nrows, 1};
+    if (clEnqueueReadBufferRect(gpu->queue, gpu->boards[gpu->current], CL_TRUE, origin, origin, region, region[0],
+                                0, board->rowStride * sizeof(BoardWord), 0, board->words, 0, NULL,
+                                NULL) != CL_SUCCESS) {
+        return false;
+    }
+    board->nalive = 0;
+    for (unsigned int row = 0; row < board->nrows; ++row) {
+        const BoardWord * const words = getBoardRow(board, row);
+        for (unsigned int w = 0; w < board->wordsPerRow; ++w) {
+            board->nalive += popcountWord(words[w]);
+        }
+    }
+    return true;
+}
+
+static size_t roundUp(const size_t n, const size_t multiple) {
+    return (n + multiple - 1) / multiple * multiple;
+}
+
+bool gpuStep(GpuBoard * const gpu, const LifeRule rule, const Topology topology, const bool hashing,
+             GpuTick * const tick) {
+    static const cl_uint zeros[4] = {0, 0, 0, 0};
+    const cl_uint nrows = gpu->nrows;
+    const cl_uint nwords = gpu->wordsPerRow;
+    const cl_uint rem = gpu->ncols % BOARD_WORD_BITS;
+    const cl_uint torus = topology == TOPOLOGY_TORUS;
+    const cl_uint birth = rule.birth;
+    const cl_uint survive = rule.survive;
+    const cl_uint hash = hashing;
+    cl_kernel kernel = gpu->kernel;
+    bool ok = clEnqueueWriteBuffer(gpu->queue, gpu->totals, CL_FALSE, 0, sizeof(zeros), zeros, 0, NULL, NULL)
+            == CL_SUCCESS;
+    ok = ok && clSetKernelArg(kernel, 0, sizeof(cl_mem), &gpu->boards[gpu->current]) == CL_SUCCESS;
+    ok = ok && clSetKernelArg(kernel, 1, sizeof(cl_mem), &gpu->boards[1 - gpu->current]) == CL_SUCCESS;
+    ok = ok && clSetKernelArg(kernel, 2, sizeof(cl_uint), &nrows) == CL_SUCCESS;
+    ok = ok && clSetKernelArg(kernel, 3, sizeof(cl_uint), &nwords) == CL_SUCCESS;
+    ok = ok && clSetKernelArg(kernel, 4, sizeof(cl_uint), &rem) == CL_SUCCESS;
+    ok = ok && clSetKernelArg(kernel, 5, sizeof(cl_uint), &torus) == CL_SUCCESS;
+    ok = ok && clSetKernelArg(kernel, 6, sizeof(cl_uint), &birth) == CL_SUCCESS;
+    ok = ok && clSetKernelArg(kernel, 7, sizeof(cl_uint), &survive) == CL_SUCCESS;
+    ok = ok && clSetKernelArg(kernel, 8, sizeof(cl_uint), &hash) == CL_SUCCESS;
+    ok = ok && clSetKernelArg(kernel, 9, sizeof(cl_mem), &gpu->totals) == CL_SUCCESS;
+    const size_t local[2] = {GPU_TILE_WORDS, GPU_TILE_ROWS};
+    const size_t global[2] = {roundUp(nwords, GPU_TILE_WORDS), roundUp(nrows, GPU_TILE_ROWS)};
+    ok = ok && clEnqueueNDRangeKernel(gpu->queue, kernel, 2, NULL, global, local, 0, NULL, NULL) == CL_SUCCESS;
+    cl_uint totals[4];
+    ok = ok && clEnqueueReadBuffer(gpu->queue, gpu->totals, CL_TRUE, 0, sizeof(totals), totals, 0, NULL, NULL)
+            == CL_SUCCESS;
+    if (!ok) {
+        return false;
+    }
+    gpu->current = 1 - gpu->current;
+    tick->population = totals[0];
+    tick->flips = totals[1];
+    tick->hash = (uint64_t) totals[3] << 32 | totals[2];
+    return true;
+}
+
+#else
+
+// Without OpenCL there is never a device, so nothing else is ever called.
+
+bool findGpuDevice(char * const name, const size_t size) {
+    (void) name;
+    (void) size;
+    return false;
+}
+
+GpuBoard *createGpuBoard(const Board * const board) {
+    (void) board;
+    return NULL;
+}
+
+void destroyGpuBoard(GpuBoard * const gpu) {
+    (void) gpu;
+}
+
+bool gpuLoadBoard(GpuBoard * const gpu, const Board * const board) {
+    (void) gpu;
+    (void) board;
+    return false;
+}
+
+bool gpuExportBoard(const GpuBoard * const gpu, Board * const board) {
+    (void) gpu;
+    (void) board;
+    return false;
+}
+
+bool gpuStep(GpuBoard * const gpu, const LifeRule rule, const Topology topology, const bool hashing,
+             GpuTick * const tick) {
+    (void) gpu;
+    (void) rule;
+    (void) topology;
+    (void) hashing;
+    (void) tick;
+    return false;
+}
+
+#endif
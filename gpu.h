@@ -0,0 +1,53 @@
+#ifndef CONWAY_GPU_H
+#define CONWAY_GPU_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board.h"
+#include "rule.h"
+
+// A copy of a board kept in the memory of an OpenCL device, usually a GPU,
+// and stepped there.  Each step reads back only its totals, so the board
+// only crosses the bus when it is loaded or exported.  The kernel steps
+// tiles of words from local memory, with the same bit-sliced adder as the
+// packed engine.
+//
+// Only built with -DCONWAY_GPU=ON; otherwise there is never a device and
+// createGpuBoard() always fails.  The internals are private to gpu.c.
+typedef struct GpuBoard GpuBoard;
+
+// What a step found, without reading the board back.
+typedef struct GpuTick {
+    unsigned int population;
+    // Tiles that changed state.
+    unsigned long long flips;
+    // hashBoard() of the new generation, if it was asked for.
+    uint64_t hash;
+} GpuTick;
+
+// Writes the name of the device boards are stepped on to name, and returns
+// false if there is none: no OpenCL platform has a device, or the engine
+// wasn't built.  The first GPU found is used, or failing that any device.
+bool findGpuDevice(char * const name, const size_t size);
+
+// Copies board onto the device.  Returns NULL if there is no device or it
+// can't hold the board.
+GpuBoard *createGpuBoard(const Board * const board);
+
+void destroyGpuBoard(GpuBoard * const gpu);
+
+// Replaces the device's board with board, which must be the same size.
+bool gpuLoadBoard(GpuBoard * const gpu, const Board * const board);
+
+// Copies the device's board into board, which must be the same size, and
+// counts its population.
+bool gpuExportBoard(const GpuBoard * const gpu, Board * const board);
+
+// Steps the device's board one generation.  The hash is only computed if
+// hashing is set.  Returns false if the device fails.
+bool gpuStep(GpuBoard * const gpu, const LifeRule rule, const Topology topology, const bool hashing,
+             GpuTick * const tick);
+
+#endif
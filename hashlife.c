@@ -0,0 +1,618 @@
+#include "hashlife.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "packed_kernel.h"
+
+// Leaves are 8x8 blocks of tiles packed into one word, row r in byte r with
+// column c in bit c of that byte.
+#define LEAF_LEVEL 3
+#define LEAF_SIZE 8
+// The root is kept big enough that its centre-of-centre, used to decide when
+// to expand it, is made of whole nodes.
+#define MIN_ROOT_LEVEL (LEAF_LEVEL + 3)
+#define MAX_LEVEL (HASHLIFE_MAX_STEP_LOG2 + 4)
+#define NODES_PER_BLOCK 16384
+#define INITIAL_BUCKETS 65536
+
+typedef struct Node {
+    union {
+        // Interior nodes, of level > LEAF_LEVEL.
+        struct {
+            struct Node *nw;
+            struct Node *ne;
+            struct Node *sw;
+            struct Node *se;
+        };
+        // Leaves.
+        uint64_t bits;
+    };
+    // The centre half of this node, 2^min(level - 2, step) generations on,
+    // or NULL if not yet computed.
+    struct Node *result;
+    struct Node *hashNext;
+    uint64_t population;
+    uint32_t level;
+    uint32_t marked;
+} Node;
+
+typedef struct NodeBlock {
+    struct NodeBlock *next;
+    Node nodes[NODES_PER_BLOCK];
+} NodeBlock;
+
+struct Hashlife {
+    // Canonicalising table of every live node, chained through hashNext.
+    Node **buckets;
+    size_t nbuckets;
+    size_t nnodes;
+    // Nodes are carved out of blocks and recycled through freeList, threaded
+    // through hashNext.
+    NodeBlock *blocks;
+    size_t blockUsed;
+    Node *freeList;
+    size_t memoryLimit;
+    // Usage at which the next collection happens.  Normally memoryLimit, but
+    // raised if the live nodes alone exceed it, so that collections don't
+    // follow each other back to back.
+    size_t collectAt;
+
+    Node *empty[MAX_LEVEL + 1];
+    Node *root;
+    // Universe coordinates of the root's top left tile.
+    int64_t originRow;
+    int64_t originCol;
+    uint64_t generation;
+    // log2 of the step memoised results of nodes above level step + 2 are
+    // for, or -1 before the first step.
+    int step;
+
+    // Nodes held by in-progress result computations, which garbage collection
+    // must keep alive.
+    Node **stack;
+    size_t stackSize;
+    size_t stackCapacity;
+
+    LifeRule rule;
+    // Whether rule is Life, which has a faster step than the generic one.
+    bool isLife;
+};
+
+DEFINE_STEP_WORDS(stepLeafRow, BoardWord, )
+
+static inline size_t hashChildren(const Node * const nw, const Node * const ne,
+                                  const Node * const sw, const Node * const se) {
+    uint64_t h = (uintptr_t) nw;
+    h = h * 0x9E3779B97F4A7C15ULL + (uintptr_t) ne;
+    h = h * 0x9E3779B97F4A7C15ULL + (uintptr_t) sw;
+    h = h * 0x9E3779B97F4A7C15ULL + (uintptr_t) se;
+    return (size_t) (h ^ (h >> 29));
+}
+
+static inline size_t hashBits(const uint64_t bits) {
+    uint64_t h = bits * 0xFF51AFD7ED558CCDULL;
+    return (size_t) (h ^ (h >> 32));
+}
+
+static inline size_t hashNode(const Node * const node) {
+    return node->level == LEAF_LEVEL ? hashBits(node->bits) : hashChildren(node->nw, node->ne, node->sw, node->se);
+}
+
+static Node *allocateNode(Hashlife * const hl) {
+    Node *node = hl->freeList;
+    if (node != NULL) {
+        hl->freeList = node->hashNext;
+        return node;
+    }
+    if (hl->blocks == NULL || hl->blockUsed == NODES_PER_BLOCK) {
+        NodeBlock *block = (NodeBlock *) malloc(sizeof(NodeBlock));
+        if (block == NULL) {
+            exit(1);
+        }
+        block->next = hl->blocks;
+        hl->blocks = block;
+        hl->blockUsed = 0;
+    }
+    return &hl->blocks->nodes[hl->blockUsed++];
+}
+
+static void rehash(Hashlife * const hl, const size_t nbuckets) {
+    Node **buckets = (Node **) calloc(nbuckets, sizeof(Node *));
+    if (buckets == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < hl->nbuckets; ++i) {
+        Node *node = hl->buckets[i];
+        while (node != NULL) {
+            Node *next = node->hashNext;
+            const size_t bucket = hashNode(node) & (nbuckets - 1);
+            node->hashNext = buckets[bucket];
+            buckets[bucket] = node;
+            node = next;
+        }
+    }
+    free(hl->buckets);
+    hl->buckets = buckets;
+    hl->nbuckets = nbuckets;
+}
+
+static Node *insertNode(Hashlife * const hl, Node * const node, const size_t hash) {
+    const size_t bucket = hash & (hl->nbuckets - 1);
+    node->result = NULL;
+    node->marked = 0;
+    node->hashNext = hl->buckets[bucket];
+    hl->buckets[bucket] = node;
+    if (++hl->nnodes > hl->nbuckets) {
+        rehash(hl, hl->nbuckets * 2);
+    }
+    return node;
+}
+
+static Node *findLeaf(Hashlife * const hl, const uint64_t bits) {
+    const size_t hash = hashBits(bits);
+    for (Node *node = hl->buckets[hash & (hl->nbuckets - 1)]; node != NULL; node = node->hashNext) {
+        if (node->level == LEAF_LEVEL && node->bits == bits) {
+            return node;
+        }
+    }
+    Node * const node = allocateNode(hl);
+    node->bits = bits;
+    node->level = LEAF_LEVEL;
+    node->population = popcountWord(bits);
+    return insertNode(hl, node, hash);
+}
+
+static Node *findNode(Hashlife * const hl, Node * const nw, Node * const ne, Node * const sw, Node * const se) {
+    const size_t hash = hashChildren(nw, ne, sw, se);
+    for (Node *node = hl->buckets[hash & (hl->nbuckets - 1)]; node != NULL; node = node->hashNext) {
+        if (node->level != LEAF_LEVEL && node->nw == nw && node->ne == ne && node->sw == sw && node->se == se) {
+            return node;
+        }
+    }
+    Node * const node = allocateNode(hl);
+    node->nw = nw;
+    node->ne = ne;
+    node->sw = sw;
+    node->se = se;
+    node->level = nw->level + 1;
+    node->population = nw->population + ne->population + sw->population + se->population;
+    return insertNode(hl, node, hash);
+}
+
+static Node *emptyNode(Hashlife * const hl, const unsigned int level) {
+    if (hl->empty[level] == NULL) {
+        if (level == LEAF_LEVEL) {
+            hl->empty[level] = findLeaf(hl, 0);
+        } else {
+            Node * const child = emptyNode(hl, level - 1);
+            hl->empty[level] = findNode(hl, child, child, child, child);
+        }
+    }
+    return hl->empty[level];
+}
+
+size_t hashlifeMemoryUsed(const Hashlife * const hl) {
+    return hl->nnodes * sizeof(Node) + hl->nbuckets * sizeof(Node *);
+}
+
+// Garbage collection
+
+static void markNode(Node * const node) {
+    if (node == NULL || node->marked) {
+        return;
+    }
+    node->marked = 1;
+    if (node->level != LEAF_LEVEL) {
+        markNode(node->nw);
+        markNode(node->ne);
+        markNode(node->sw);
+        markNode(node->se);
+    }
+    markNode(node->result);
+}
+
+static void collectGarbage(Hashlife * const hl) {
+    markNode(hl->root);
+    for (unsigned int level = LEAF_LEVEL; level <= MAX_LEVEL; ++level) {
+        markNode(hl->empty[level]);
+    }
+    for (size_t i = 0; i < hl->stackSize; ++i) {
+        markNode(hl->stack[i]);
+    }
+
+    for (size_t i = 0; i < hl->nbuckets; ++i) {
+        Node **link = &hl->buckets[i];
+        while (*link != NULL) {
+            Node * const node = *link;
+            if (node->marked) {
+                node->marked = 0;
+                link = &node->hashNext;
+            } else {
+                *link = node->hashNext;
+                node->hashNext = hl->freeList;
+                hl->freeList = node;
+                hl->nnodes--;
+            }
+        }
+    }
+}
+
+static void clearResults(Hashlife * const hl, const unsigned int aboveLevel) {
+    for (size_t i = 0; i < hl->nbuckets; ++i) {
+        for (Node *node = hl->buckets[i]; node != NULL; node = node->hashNext) {
+            if (node->level > aboveLevel) {
+                node->result = NULL;
+            }
+        }
+    }
+}
+
+// Brings the cache back under its limit if possible: first by dropping nodes
+// nothing refers to, then by forgetting memoised results too.
+static void enforceMemoryLimit(Hashlife * const hl) {
+    if (hashlifeMemoryUsed(hl) <= hl->collectAt) {
+        return;
+    }
+    collectGarbage(hl);
+    if (hashlifeMemoryUsed(hl) > hl->memoryLimit / 2) {
+        clearResults(hl, 0);
+        collectGarbage(hl);
+    }
+    const size_t used = hashlifeMemoryUsed(hl);
+    hl->collectAt = used * 2 > hl->memoryLimit ? used * 2 : hl->memoryLimit;
+}
+
+static Node *keep(Hashlife * const hl, Node * const node) {
+    if (hl->stackSize == hl->stackCapacity) {
+        const size_t capacity = hl->stackCapacity * 2;
+        Node **stack = (Node **) realloc(hl->stack, capacity * sizeof(Node *));
+        if (stack == NULL) {
+            exit(1);
+        }
+        hl->stack = stack;
+        hl->stackCapacity = capacity;
+    }
+    hl->stack[hl->stackSize++] = node;
+    return node;
+}
+
+// Stepping
+
+static inline uint64_t leafRow(const Node * const leaf, const unsigned int row) {
+    return (leaf->bits >> (row * LEAF_SIZE)) & 0xff;
+}
+
+// Unpacks the 16x16 tiles of a level 4 node into the low bits of 16 words.
+static void unpackLevel4(const Node * const node, BoardWord rows[2 * LEAF_SIZE]) {
+    for (unsigned int r = 0; r < LEAF_SIZE; ++r) {
+        rows[r] = leafRow(node->nw, r) | (leafRow(node->ne, r) << LEAF_SIZE);
+        rows[r + LEAF_SIZE] = leafRow(node->sw, r) | (leafRow(node->se, r) << LEAF_SIZE);
+    }
+}
+
+static Node *centreLeaf(Hashlife * const hl, const BoardWord rows[2 * LEAF_SIZE]) {
+    uint64_t bits = 0;
+    for (unsigned int r = 0; r < LEAF_SIZE; ++r) {
+        bits |= ((rows[r + LEAF_SIZE / 2] >> (LEAF_SIZE / 2)) & 0xff) << (r * LEAF_SIZE);
+    }
+    return findLeaf(hl, bits);
+}
+
+// The centre half of a node, not advanced.
+static Node *centreNode(Hashlife * const hl, Node * const node) {
+    if (node->level == LEAF_LEVEL + 1) {
+        BoardWord rows[2 * LEAF_SIZE];
+        unpackLevel4(node, rows);
+        return centreLeaf(hl, rows);
+    }
+    return findNode(hl, node->nw->se, node->ne->sw, node->sw->ne, node->se->nw);
+}
+
+// Base case: runs the tiles of a level 4 node directly for up to 4
+// generations, which is as far as its centre can be known.
+static Node *level4Result(Hashlife * const hl, Node * const node, const unsigned int generations) {
+    BoardWord rows[2 * LEAF_SIZE];
+    BoardWord next[2 * LEAF_SIZE];
+    unpackLevel4(node, rows);
+    for (unsigned int g = 0; g < generations; ++g) {
+        for (unsigned int r = 0; r < 2 * LEAF_SIZE; ++r) {
+            const BoardWord above = r > 0 ? rows[r - 1] : 0;
+            const BoardWord below = r + 1 < 2 * LEAF_SIZE ? rows[r + 1] : 0;
+            const BoardWord row = hl->isLife
+                    ? stepLeafRowLife(0, above, 0, 0, rows[r], 0, 0, below, 0, &hl->rule)
+                    : stepLeafRowGeneric(0, above, 0, 0, rows[r], 0, 0, below, 0, &hl->rule);
+            next[r] = row & 0xffff;
+        }
+        memcpy(rows, next, sizeof(rows));
+    }
+    return centreLeaf(hl, rows);
+}
+
+static Node *nodeResult(Hashlife * const hl, Node * const node) {
+    if (node->result != NULL) {
+        return node->result;
+    }
+    if (node->population == 0) {
+        node->result = emptyNode(hl, node->level - 1);
+        return node->result;
+    }
+
+    const size_t stackMark = hl->stackSize;
+    keep(hl, node);
+    enforceMemoryLimit(hl);
+
+    const unsigned int level = node->level;
+    // Nodes up to step + 2 levels advance as far as they can, 2^(level - 2)
+    // generations, in two rounds of their children's results.  Bigger nodes
+    // only advance 2^step, so the first round just recentres.
+    const bool fullSpeed = (int) level - 2 <= hl->step;
+    Node *result;
+    if (level == LEAF_LEVEL + 1) {
+        const unsigned int generations = fullSpeed ? 4 : 1u << hl->step;
+        result = level4Result(hl, node, generations);
+    } else {
+        Node * const nw = node->nw;
+        Node * const ne = node->ne;
+        Node * const sw = node->sw;
+        Node * const se = node->se;
+        // The nine overlapping subnodes one level down.
+        Node *sub[3][3];
+        sub[0][0] = keep(hl, nw);
+        sub[0][1] = keep(hl, findNode(hl, nw->ne, ne->nw, nw->se, ne->sw));
+        sub[0][2] = keep(hl, ne);
+        sub[1][0] = keep(hl, findNode(hl, nw->sw, nw->se, sw->nw, sw->ne));
+        sub[1][1] = keep(hl, findNode(hl, nw->se, ne->sw, sw->ne, se->nw));
+        sub[1][2] = keep(hl, findNode(hl, ne->sw, ne->se, se->nw, se->ne));
+        sub[2][0] = keep(hl, sw);
+        sub[2][1] = keep(hl, findNode(hl, sw->ne, se->nw, sw->se, se->sw));
+        sub[2][2] = keep(hl, se);
+
+        Node *first[3][3];
+        for (unsigned int r = 0; r < 3; ++r) {
+            for (unsigned int c = 0; c < 3; ++c) {
+                first[r][c] = keep(hl, fullSpeed ? nodeResult(hl, sub[r][c]) : centreNode(hl, sub[r][c]));
+            }
+        }
+
+        Node *second[2][2];
+        for (unsigned int r = 0; r < 2; ++r) {
+            for (unsigned int c = 0; c < 2; ++c) {
+                Node * const combined = keep(hl, findNode(hl, first[r][c], first[r][c + 1],
+                                                          first[r + 1][c], first[r + 1][c + 1]));
+                second[r][c] = keep(hl, nodeResult(hl, combined));
+            }
+        }
+        result = findNode(hl, second[0][0], second[0][1], second[1][0], second[1][1]);
+    }
+
+    node->result = result;
+    hl->stackSize = stackMark;
+    return result;
+}
+
+// Memoised results of nodes above step + 2 levels depend on the step, so they
+// are dropped when it changes.
+static void setStep(Hashlife * const hl, const int step) {
+    if (hl->step == step) {
+        return;
+    }
+    if (hl->step >= 0) {
+        const int keepBelow = (step < hl->step ? step : hl->step) + 2;
+        clearResults(hl, (unsigned int) keepBelow);
+    }
+    hl->step = step;
+}
+
+// Doubles the root's width, keeping its contents centred.
+static void expandRoot(Hashlife * const hl) {
+    Node * const root = hl->root;
+    Node * const e = emptyNode(hl, root->level - 1);
+    Node * const nw = findNode(hl, e, e, e, root->nw);
+    Node * const ne = findNode(hl, e, e, root->ne, e);
+    Node * const sw = findNode(hl, e, root->sw, e, e);
+    Node * const se = findNode(hl, root->se, e, e, e);
+    const int64_t half = (int64_t) 1 << (root->level - 1);
+    hl->root = findNode(hl, nw, ne, sw, se);
+    hl->originRow -= half;
+    hl->originCol -= half;
+}
+
+// Whether every live tile is in the central quarter-width square of the root,
+// so that nothing can escape its result.
+static bool rootIsPadded(const Hashlife * const hl) {
+    const Node * const root = hl->root;
+    const uint64_t inner = root->nw->se->se->population + root->ne->sw->sw->population
+            + root->sw->ne->ne->population + root->se->nw->nw->population;
+    return inner == root->population;
+}
+
+// The result covers the same tiles as the root's centre, which holds every
+// live tile of the padded root, and nodes are canonical, so the universe is
+// unchanged exactly when the two are the same node.
+bool hashlifeStep(Hashlife * const hl, const unsigned int log2Generations) {
+    setStep(hl, (int) log2Generations);
+    while (hl->root->level < log2Generations + 3 || !rootIsPadded(hl)) {
+        expandRoot(hl);
+    }
+    enforceMemoryLimit(hl);
+
+    const int64_t quarter = (int64_t) 1 << (hl->root->level - 2);
+    const size_t stackMark = hl->stackSize;
+    const Node * const before = keep(hl, centreNode(hl, hl->root));
+    hl->root = nodeResult(hl, hl->root);
+    hl->stackSize = stackMark;
+    const bool changed = hl->root != before;
+    hl->originRow += quarter;
+    hl->originCol += quarter;
+    hl->generation += (uint64_t) 1 << log2Generations;
+    // The result is a level smaller than the root it came from.
+    while (hl->root->level < MIN_ROOT_LEVEL) {
+        expandRoot(hl);
+    }
+    return changed;
+}
+
+// Conversion to and from Boards
+
+static Node *buildNode(Hashlife * const hl, const Board * const board, const unsigned int level,
+                       const int64_t row, const int64_t col) {
+    if (row >= board->nrows || col >= board->ncols) {
+        return emptyNode(hl, level);
+    }
+    if (level == LEAF_LEVEL) {
+        uint64_t bits = 0;
+        for (unsigned int r = 0; r < LEAF_SIZE && row + r < board->nrows; ++r) {
+            const BoardWord word = getBoardRow(board, (unsigned int) (row + r))[col / BOARD_WORD_BITS];
+            bits |= ((word >> (col % BOARD_WORD_BITS)) & 0xff) << (r * LEAF_SIZE);
+        }
+        return findLeaf(hl, bits);
+    }
+    const int64_t half = (int64_t) 1 << (level - 1);
+    Node * const nw = buildNode(hl, board, level - 1, row, col);
+    Node * const ne = buildNode(hl, board, level - 1, row, col + half);
+    Node * const sw = buildNode(hl, board, level - 1, row + half, col);
+    Node * const se = buildNode(hl, board, level - 1, row + half, col + half);
+    return findNode(hl, nw, ne, sw, se);
+}
+
+void hashlifeLoadBoard(Hashlife * const hl, const Board * const board,
+                       const int64_t originRow, const int64_t originCol) {
+    unsigned int level = MIN_ROOT_LEVEL;
+    while (((uint64_t) 1 << level) < board->nrows || ((uint64_t) 1 << level) < board->ncols) {
+        ++level;
+    }
+    hl->root = buildNode(hl, board, level, 0, 0);
+    hl->originRow = originRow;
+    hl->originCol = originCol;
+    enforceMemoryLimit(hl);
+}
+
+static Node *setNodeTile(Hashlife * const hl, Node * const node, const int64_t row, const int64_t col,
+                         const TileState state) {
+    if (node->level == LEAF_LEVEL) {
+        const uint64_t bit = (uint64_t) 1 << (row * LEAF_SIZE + col);
+        return findLeaf(hl, state == ALIVE ? node->bits | bit : node->bits & ~bit);
+    }
+    const int64_t half = (int64_t) 1 << (node->level - 1);
+    if (row < half) {
+        if (col < half) {
+            return findNode(hl, setNodeTile(hl, node->nw, row, col, state), node->ne, node->sw, node->se);
+        }
+        return findNode(hl, node->nw, setNodeTile(hl, node->ne, row, col - half, state), node->sw, node->se);
+    }
+    if (col < half) {
+        return findNode(hl, node->nw, node->ne, setNodeTile(hl, node->sw, row - half, col, state), node->se);
+    }
+    return findNode(hl, node->nw, node->ne, node->sw, setNodeTile(hl, node->se, row - half, col - half, state));
+}
+
+void hashlifeSetTile(Hashlife * const hl, const int64_t row, const int64_t col, const TileState state) {
+    while (true) {
+        const int64_t size = (int64_t) 1 << hl->root->level;
+        if (row >= hl->originRow && row < hl->originRow + size && col >= hl->originCol && col < hl->originCol + size) {
+            break;
+        }
+        expandRoot(hl);
+    }
+    hl->root = setNodeTile(hl, hl->root, row - hl->originRow, col - hl->originCol, state);
+}
+
+static void exportNode(const Node * const node, Board * const board, const int64_t row, const int64_t col) {
+    const int64_t size = (int64_t) 1 << node->level;
+    if (node->population == 0 || row >= board->nrows || col >= board->ncols || row + size <= 0 || col + size <= 0) {
+        return;
+    }
+    if (node->level == LEAF_LEVEL) {
+        // The window may start at any column, so a leaf row can straddle two
+        // board words, the first of them west of the board.
+        const int64_t word = col >= 0 ? col / BOARD_WORD_BITS : (col - BOARD_WORD_BITS + 1) / BOARD_WORD_BITS;
+        const unsigned int shift = (unsigned int) (col - word * BOARD_WORD_BITS);
+        for (unsigned int r = 0; r < LEAF_SIZE; ++r) {
+            if (row + r < 0 || row + r >= board->nrows) {
+                continue;
+            }
+            BoardWord * const words = getBoardRow(board, (unsigned int) (row + r));
+            const BoardWord bits = leafRow(node, r);
+            if (word >= 0) {
+                words[word] |= bits << shift;
+            }
+            if (shift > BOARD_WORD_BITS - LEAF_SIZE && word + 1 < board->wordsPerRow) {
+                words[word + 1] |= bits >> (BOARD_WORD_BITS - shift);
+            }
+        }
+        return;
+    }
+    const int64_t half = size / 2;
+    exportNode(node->nw, board, row, col);
+    exportNode(node->ne, board, row, col + half);
+    exportNode(node->sw, board, row + half, col);
+    exportNode(node->se, board, row + half, col + half);
+}
+
+void hashlifeExportBoard(const Hashlife * const hl, Board * const board,
+                         const int64_t originRow, const int64_t originCol) {
+    clearBoard(board);
+    exportNode(hl->root, board, hl->originRow - originRow, hl->originCol - originCol);
+
+    const BoardWord mask = lastWordMask(board);
+    board->nalive = 0;
+    for (unsigned int row = 0; row < board->nrows && board->wordsPerRow > 0; ++row) {
+        BoardWord * const words = getBoardRow(board, row);
+        words[board->wordsPerRow - 1] &= mask;
+        for (unsigned int w = 0; w < board->wordsPerRow; ++w) {
+            board->nalive += popcountWord(words[w]);
+        }
+    }
+}
+
+// Lifetime and queries
+
+Hashlife *createHashlife(const size_t memoryLimit, const LifeRule rule) {
+    Hashlife *hl = (Hashlife *) calloc(1, sizeof(Hashlife));
+    if (hl == NULL) {
+        return NULL;
+    }
+    hl->nbuckets = INITIAL_BUCKETS;
+    hl->buckets = (Node **) calloc(hl->nbuckets, sizeof(Node *));
+    hl->stackCapacity = 256;
+    hl->stack = (Node **) malloc(hl->stackCapacity * sizeof(Node *));
+    if (hl->buckets == NULL || hl->stack == NULL) {
+        destroyHashlife(hl);
+        return NULL;
+    }
+    hl->memoryLimit = memoryLimit;
+    hl->collectAt = memoryLimit;
+    hashlifeSetRule(hl, rule);
+    hl->step = -1;
+    hl->root = emptyNode(hl, MIN_ROOT_LEVEL);
+    return hl;
+}
+
+void destroyHashlife(Hashlife * const hl) {
+    if (hl == NULL) {
+        return;
+    }
+    while (hl->blocks != NULL) {
+        NodeBlock *next = hl->blocks->next;
+        free(hl->blocks);
+        hl->blocks = next;
+    }
+    free(hl->buckets);
+    free(hl->stack);
+    free(hl);
+}
+
+void hashlifeSetRule(Hashlife * const hl, const LifeRule rule) {
+    hl->rule = rule;
+    hl->isLife = lifeRulesEqual(rule, LIFE_RULE);
+    clearResults(hl, 0);
+}
+
+uint64_t hashlifeGeneration(const Hashlife * const hl) {
+    return hl->generation;
+}
+
+uint64_t hashlifePopulation(const Hashlife * const hl) {
+    return hl->root->population;
+}
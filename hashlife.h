@@ -0,0 +1,61 @@
+#ifndef CONWAY_HASHLIFE_H
+#define CONWAY_HASHLIFE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board.h"
+#include "rule.h"
+
+// Gosper's Hashlife over an unbounded plane.  The universe is a quadtree of
+// canonicalised nodes, so identical regions anywhere, at any time, are the same
+// node and have their futures computed once.  The internals are private to
+// hashlife.c.
+//
+// Universe coordinates are signed.  Boards are loaded from and exported to
+// windows of the universe given by the universe coordinates of their top left
+// tile.  Unlike the Board engines nothing is clipped at the Board's edges.
+typedef struct Hashlife Hashlife;
+
+// Largest step hashlifeStep() accepts, keeping universe coordinates within
+// int64_t.
+#define HASHLIFE_MAX_STEP_LOG2 56
+
+// Creates an empty universe.  memoryLimit bounds, in bytes, the node cache;
+// when it is exceeded unreachable nodes, and then memoised results, are
+// garbage collected.  The universe evolves under rule, which must not have
+// B0.  Returns NULL on failure.
+Hashlife *createHashlife(const size_t memoryLimit, const LifeRule rule);
+
+void destroyHashlife(Hashlife * const hashlife);
+
+// Replaces the whole universe with the live tiles of board, with its top left
+// tile at universe (originRow, originCol).
+void hashlifeLoadBoard(Hashlife * const hashlife, const Board * const board,
+                       const int64_t originRow, const int64_t originCol);
+
+void hashlifeSetTile(Hashlife * const hashlife, const int64_t row, const int64_t col, const TileState state);
+
+// Overwrites board with the window of the universe whose top left tile is at
+// universe (originRow, originCol).
+void hashlifeExportBoard(const Hashlife * const hashlife, Board * const board,
+                         const int64_t originRow, const int64_t originCol);
+
+// Takes effect from the next step, forgetting every memoised result.  rule
+// must not have B0.
+void hashlifeSetRule(Hashlife * const hashlife, const LifeRule rule);
+
+// Advances the universe by 2^log2Generations generations at once, where
+// log2Generations is at most HASHLIFE_MAX_STEP_LOG2.  Returns whether any tile
+// of the universe, in the window or not, differs from before the step.
+bool hashlifeStep(Hashlife * const hashlife, const unsigned int log2Generations);
+
+uint64_t hashlifeGeneration(const Hashlife * const hashlife);
+
+uint64_t hashlifePopulation(const Hashlife * const hashlife);
+
+// Bytes currently held by the node cache.
+size_t hashlifeMemoryUsed(const Hashlife * const hashlife);
+
+#endif
@@ -0,0 +1,244 @@
+#include "libconway.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "board.h"
+#include "cycle.h"
+#include "gpu.h"
+#include "pattern.h"
+#include "rule.h"
+#include "simulation.h"
+#include "threadpool.h"
+
+struct ConwayBoard {
+    Simulation sim;
+    // Every tick's stats, summed since creation.
+    TickStats totals;
+    bool stepped;
+    // Set once a step finds a still life, so that later steps return at once,
+    // and cleared by anything that can change the next generation.
+    bool still;
+};
+
+unsigned int conwayApiVersion(void) {
+    return CONWAY_API_VERSION;
+}
+
+const char *conwayStatusMessage(const ConwayStatus status) {
+    switch (status) {
+    case CONWAY_OK:
+        return "ok";
+    case CONWAY_INVALID_ARGUMENT:
+        return "invalid argument";
+    case CONWAY_OUT_OF_MEMORY:
+        return "out of memory";
+    case CONWAY_IO_ERROR:
+        return "could not read the pattern";
+    case CONWAY_UNSUPPORTED:
+        return "not supported by the engine";
+    }
+    return "unknown status";
+}
+
+// Takes ownership of tiles, even on failure.  No view reads the change list,
+// so the engines that can skip recording it do.
+static ConwayStatus createFromBoard(Board tiles, ConwayBoard ** const board) {
+    ConwayBoard * const created = (ConwayBoard *) calloc(1, sizeof(ConwayBoard));
+    if (created == NULL) {
+        destroyBoard(&tiles);
+        return CONWAY_OUT_OF_MEMORY;
+    }
+    if (!initSimulation(&created->sim, tiles)) {
+        destroySimulation(&created->sim);
+        free(created);
+        return CONWAY_OUT_OF_MEMORY;
+    }
+    created->sim.recordChanges = false;
+    created->sim.collectStats = true;
+    *board = created;
+    return CONWAY_OK;
+}
+
+ConwayStatus conwayCreate(const uint32_t nrows, const uint32_t ncols, ConwayBoard ** const board) {
+    if (board == NULL) {
+        return CONWAY_INVALID_ARGUMENT;
+    }
+    Board tiles;
+    if (!initBoard(&tiles, nrows, ncols)) {
+        return CONWAY_OUT_OF_MEMORY;
+    }
+    return createFromBoard(tiles, board);
+}
+
+ConwayStatus conwayLoadPattern(const char * const path, const uint32_t nrows, const uint32_t ncols,
+                               ConwayBoard ** const board) {
+    if (path == NULL || board == NULL) {
+        return CONWAY_INVALID_ARGUMENT;
+    }
+    Board pattern;
+    PatternInfo info;
+    if (!loadPattern(path, &pattern, &info)) {
+        return CONWAY_IO_ERROR;
+    }
+    Board tiles = pattern;
+    if (nrows != 0 && ncols != 0) {
+        const bool ok = initBoard(&tiles, nrows, ncols);
+        if (ok) {
+            blitBoard(&tiles, &pattern, 0, 0);
+        }
+        destroyBoard(&pattern);
+        if (!ok) {
+            return CONWAY_OUT_OF_MEMORY;
+        }
+    }
+    const ConwayStatus status = createFromBoard(tiles, board);
+    if (status == CONWAY_OK && info.hasRule) {
+        setSimulationRule(&(*board)->sim, info.rule);
+    }
+    return status;
+}
+
+void conwayDestroy(ConwayBoard * const board) {
+    if (board == NULL) {
+        return;
+    }
+    destroySimulation(&board->sim);
+    free(board);
+}
+
+ConwayStatus conwaySetRule(ConwayBoard * const board, const char * const rule) {
+    LifeRule parsed;
+    if (board == NULL || rule == NULL || !parseLifeRule(rule, &parsed)) {
+        return CONWAY_INVALID_ARGUMENT;
+    }
+    if (!setSimulationRule(&board->sim, parsed)) {
+        return CONWAY_UNSUPPORTED;
+    }
+    board->still = false;
+    return CONWAY_OK;
+}
+
+ConwayStatus conwaySetTopology(ConwayBoard * const board, const char * const topology) {
+    Topology parsed;
+    if (board == NULL || topology == NULL || !parseTopology(topology, &parsed)) {
+        return CONWAY_INVALID_ARGUMENT;
+    }
+    setSimulationTopology(&board->sim, parsed);
+    board->still = false;
+    return CONWAY_OK;
+}
+
+// The unbounded engines build their universe from the board on their first
+// tick, so switching to or from one afterwards would lose the universe.  Only
+// the packed engine ages the tiles of Generations rules.
+ConwayStatus conwaySetEngine(ConwayBoard * const board, const char * const engine) {
+    StepEngine parsed;
+    if (board == NULL || engine == NULL || !parseStepEngine(engine, &parsed)) {
+        return CONWAY_INVALID_ARGUMENT;
+    }
+    const bool unbounded = parsed == ENGINE_HASHLIFE || parsed == ENGINE_SPARSE;
+    if (board->stepped || (unbounded && ruleBirthsFromNothing(board->sim.rule))
+            || (ruleHasDecay(board->sim.rule) && parsed != ENGINE_PACKED)
+            || (parsed == ENGINE_GPU && !findGpuDevice(NULL, 0))) {
+        return CONWAY_UNSUPPORTED;
+    }
+    board->sim.engine = parsed;
+    return CONWAY_OK;
+}
+
+ConwayStatus conwaySetThreads(ConwayBoard * const board, const unsigned int nthreads) {
+    if (board == NULL) {
+        return CONWAY_INVALID_ARGUMENT;
+    }
+    return setSimulationThreads(&board->sim, nthreads == 0 ? availableProcessors() : nthreads)
+            ? CONWAY_OK : CONWAY_OUT_OF_MEMORY;
+}
+
+ConwayStatus conwaySetCycleLimit(ConwayBoard * const board, const unsigned int maxPeriod) {
+    if (board == NULL || maxPeriod > MAX_CYCLE_PERIOD) {
+        return CONWAY_INVALID_ARGUMENT;
+    }
+    return setSimulationCycleLimit(&board->sim, maxPeriod) ? CONWAY_OK : CONWAY_OUT_OF_MEMORY;
+}
+
+void conwayBoardSize(const ConwayBoard * const board, uint32_t * const nrows, uint32_t * const ncols) {
+    *nrows = board->sim.logicalBoard.nrows;
+    *ncols = board->sim.logicalBoard.ncols;
+}
+
+ConwayStatus conwaySetCell(ConwayBoard * const board, const uint32_t row, const uint32_t col, const int alive) {
+    if (board == NULL || row >= board->sim.logicalBoard.nrows || col >= board->sim.logicalBoard.ncols) {
+        return CONWAY_INVALID_ARGUMENT;
+    }
+    syncSimulationBoard(&board->sim);
+    setTileState(&board->sim.logicalBoard, alive ? ALIVE : DEAD, row, col);
+    simulationTileEdited(&board->sim, row, col);
+    board->still = false;
+    return CONWAY_OK;
+}
+
+ConwayStatus conwayStep(ConwayBoard * const board, const uint64_t generations, uint64_t * const stepped) {
+    if (board == NULL) {
+        return CONWAY_INVALID_ARGUMENT;
+    }
+    Simulation * const sim = &board->sim;
+    const uint64_t start = sim->tick;
+    board->stepped = true;
+    bool cycled = false;
+    while (sim->tick - start < generations && !board->still && !cycled) {
+        board->still = !stepSimulationUpTo(sim, generations - (sim->tick - start));
+        cycled = sim->cyclePeriod != 0;
+        addTickStats(&board->totals, &sim->lastTick);
+    }
+    if (stepped != NULL) {
+        *stepped = sim->tick - start;
+    }
+    return CONWAY_OK;
+}
+
+ConwayStatus conwayReadRegion(ConwayBoard * const board, const uint32_t row, const uint32_t col,
+                              const uint32_t nrows, const uint32_t ncols, uint8_t * const cells,
+                              const size_t stride) {
+    if (board == NULL || (cells == NULL && nrows != 0 && ncols != 0) || stride < ncols) {
+        return CONWAY_INVALID_ARGUMENT;
+    }
+    const Board * const tiles = &board->sim.logicalBoard;
+    if (row > tiles->nrows || nrows > tiles->nrows - row || col > tiles->ncols || ncols > tiles->ncols - col) {
+        return CONWAY_INVALID_ARGUMENT;
+    }
+    syncSimulationBoard(&board->sim);
+    for (uint32_t r = 0; r < nrows; ++r) {
+        const BoardWord * const words = getBoardRow(tiles, row + r);
+        uint8_t * const out = cells + r * stride;
+        for (uint32_t c = 0; c < ncols; ++c) {
+            const unsigned int tile = col + c;
+            out[c] = (uint8_t) ((words[tile / BOARD_WORD_BITS] >> (tile % BOARD_WORD_BITS)) & 1);
+        }
+    }
+    if (board->sim.decay == NULL) {
+        return CONWAY_OK;
+    }
+    // Only a Generations rule's dying tiles need their ages looking up.
+    for (uint32_t r = 0; r < nrows; ++r) {
+        uint8_t * const out = cells + r * stride;
+        for (uint32_t c = 0; c < ncols; ++c) {
+            if (out[c] == 0) {
+                out[c] = (uint8_t) simulationTileState(&board->sim, row + r, col + c);
+            }
+        }
+    }
+    return CONWAY_OK;
+}
+
+ConwayStatus conwayGetStats(ConwayBoard * const board, ConwayStats * const stats) {
+    if (board == NULL || stats == NULL) {
+        return CONWAY_INVALID_ARGUMENT;
+    }
+    const Simulation * const sim = &board->sim;
+    *stats = (ConwayStats) {
+        sim->tick, sim->logicalBoard.nalive, board->totals.births, board->totals.deaths,
+        board->totals.computeNanos, board->totals.commitNanos, sim->cyclePeriod, board->still ? 1 : 0
+    };
+    return CONWAY_OK;
+}
@@ -0,0 +1,132 @@
+#ifndef CONWAY_LIBCONWAY_H
+#define CONWAY_LIBCONWAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The engine as a library, for programs that run simulations in process
+// rather than through the conway executable.  Everything goes through an
+// opaque ConwayBoard handle and plain C types, so that the interface can be
+// called from other languages' foreign function interfaces and stays the
+// same as the engine behind it changes.  CONWAY_API_VERSION goes up whenever
+// a declaration here changes incompatibly.
+//
+// A handle is not thread safe: calls on one handle must not overlap, though
+// calls on different handles may.  The stepping threads started by
+// conwaySetThreads() belong to the handle, and live until the next
+// conwaySetThreads() or conwayDestroy(), idle between steps.
+//
+// CONWAY_OUT_OF_MEMORY only covers allocations made by the calls returning
+// it.  The engines grow their universes, caches and scratch boards while
+// stepping, and running out of memory there exits the process, as it does in
+// the conway executable.
+#define CONWAY_API_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define CONWAY_API __attribute__((visibility("default")))
+#else
+#define CONWAY_API
+#endif
+
+typedef struct ConwayBoard ConwayBoard;
+
+typedef enum ConwayStatus {
+    CONWAY_OK = 0,
+    // An argument is out of range, or a name isn't recognised.
+    CONWAY_INVALID_ARGUMENT,
+    CONWAY_OUT_OF_MEMORY,
+    // A pattern file couldn't be read or is malformed.
+    CONWAY_IO_ERROR,
+    // The engine can't do what was asked: run a rule with B0 in an unbounded
+    // universe, run a Generations rule on any but the packed engine, run on a
+    // GPU without one, or change engine after stepping.
+    CONWAY_UNSUPPORTED
+} ConwayStatus;
+
+// Totals since the board was created.
+typedef struct ConwayStats {
+    uint64_t generation;
+    uint64_t population;
+    uint64_t births;
+    uint64_t deaths;
+    // Nanoseconds spent working out generations and making them current.
+    uint64_t computeNanos;
+    uint64_t commitNanos;
+    // The period of the cycle the board has entered, if cycle detection is on
+    // and found one, or else 0.
+    uint32_t period;
+    // 1 if the last step found the board a still life, or else 0.
+    uint32_t still;
+} ConwayStats;
+
+// CONWAY_API_VERSION of the library actually loaded.
+CONWAY_API unsigned int conwayApiVersion(void);
+
+// A short description of status, never NULL.
+CONWAY_API const char *conwayStatusMessage(const ConwayStatus status);
+
+// Creates an all-dead board of nrows by ncols tiles, run under B3/S23 with
+// bounded edges by the packed engine on one thread until told otherwise.
+CONWAY_API ConwayStatus conwayCreate(const uint32_t nrows, const uint32_t ncols, ConwayBoard ** const board);
+
+// As conwayCreate(), with the plaintext, RLE or Life 1.06 pattern at path in
+// the top left corner, and run under the rule the pattern names, if any.  If
+// nrows or ncols is 0 the board is exactly the size of the pattern.
+CONWAY_API ConwayStatus conwayLoadPattern(const char * const path, const uint32_t nrows, const uint32_t ncols,
+                                          ConwayBoard ** const board);
+
+// Frees board and everything it holds.  Does nothing if board is NULL.
+CONWAY_API void conwayDestroy(ConwayBoard * const board);
+
+// Switches to a Life-like rule, e.g. "B36/S23" or "highlife", or a
+// Generations rule, e.g. "B2/S/C3" or "briansbrain", from the next step on.
+// Dying tiles keep their ages only under a rule with as many states.
+CONWAY_API ConwayStatus conwaySetRule(ConwayBoard * const board, const char * const rule);
+
+// Switches to "bounded" or "torus" edges from the next step on.
+CONWAY_API ConwayStatus conwaySetTopology(ConwayBoard * const board, const char * const topology);
+
+// Chooses the engine by its command line name: "packed", "scalar",
+// "reference", "hashlife", "sparse" or "gpu".  The unbounded engines,
+// hashlife and sparse, treat the board as a window at the origin of their
+// universe.  Only allowed before the first step.
+CONWAY_API ConwayStatus conwaySetEngine(ConwayBoard * const board, const char * const engine);
+
+// Steps the packed engine on nthreads threads, or one per core if 0.
+CONWAY_API ConwayStatus conwaySetThreads(ConwayBoard * const board, const unsigned int nthreads);
+
+// Makes each step look for the board repeating one of the last maxPeriod
+// generations, stopping once it does; 0, the default, turns this off.
+CONWAY_API ConwayStatus conwaySetCycleLimit(ConwayBoard * const board, const unsigned int maxPeriod);
+
+CONWAY_API void conwayBoardSize(const ConwayBoard * const board, uint32_t * const nrows, uint32_t * const ncols);
+
+// Makes the tile at (row, col) alive if alive is non-zero, or else dead.
+CONWAY_API ConwayStatus conwaySetCell(ConwayBoard * const board, const uint32_t row, const uint32_t col,
+                                      const int alive);
+
+// Advances up to generations generations, stopping early once the board is a
+// still life or, with a cycle limit, has cycled.  The generations actually
+// advanced are stored in *stepped unless stepped is NULL.  Running out of
+// memory while stepping exits the process; see above.
+CONWAY_API ConwayStatus conwayStep(ConwayBoard * const board, const uint64_t generations, uint64_t * const stepped);
+
+// Copies the nrows by ncols tiles from (row, col) into cells, one byte per
+// tile, 1 if alive, 0 if dead, or from 2 up while dying under a Generations
+// rule, with rows stride bytes apart.  The region must lie within the board,
+// and stride be at least ncols.
+CONWAY_API ConwayStatus conwayReadRegion(ConwayBoard * const board, const uint32_t row, const uint32_t col,
+                                         const uint32_t nrows, const uint32_t ncols, uint8_t * const cells,
+                                         const size_t stride);
+
+CONWAY_API ConwayStatus conwayGetStats(ConwayBoard * const board, ConwayStats * const stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
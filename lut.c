@@ -0,0 +1,46 @@
+#include "lut.h"
+
+void initRuleTable(RuleTable * const table, const LifeRule rule) {
+    for (unsigned int index = 0; index < NEIGHBOURHOOD_STATES; ++index) {
+        const bool alive = (index >> NEIGHBOURHOOD_CENTRE_BIT) & 1;
+        const unsigned int neighbours = popcountWord(index & ~(1u << NEIGHBOURHOOD_CENTRE_BIT));
+        table->next[index] = ((alive ? rule.survive : rule.birth) >> neighbours) & 1;
+    }
+}
+
+// The three bits of column col for rows row - 1 to row + 1, north in the
+// lowest bit.  col may be -1 or ncols, in the halo.
+static inline unsigned int neighbourhoodColumn(const BoardWord * const above, const BoardWord * const centre,
+                                               const BoardWord * const below, const int col) {
+    const int x = col + BOARD_WORD_BITS;
+    const int word = x / BOARD_WORD_BITS - 1;
+    const int bit = x % BOARD_WORD_BITS;
+    return (unsigned int) ((above[word] >> bit) & 1)
+            | (unsigned int) ((centre[word] >> bit) & 1) << 1
+            | (unsigned int) ((below[word] >> bit) & 1) << 2;
+}
+
+void stepLutRows(const RuleTable * const table, const Board * const src, Board * const dst,
+                 const unsigned int rowBegin, const unsigned int rowEnd) {
+    const unsigned int ncols = src->ncols;
+    for (unsigned int row = rowBegin; row < rowEnd; ++row) {
+        const BoardWord * const centre = getBoardRow(src, row);
+        const BoardWord * const above = centre - src->rowStride;
+        const BoardWord * const below = centre + src->rowStride;
+        BoardWord * const out = getBoardRow(dst, row);
+
+        // Slide the neighbourhood east one column at a time, so each tile is
+        // read once rather than nine times.
+        unsigned int index = neighbourhoodColumn(above, centre, below, -1) << 3
+                | neighbourhoodColumn(above, centre, below, 0) << 6;
+        BoardWord word = 0;
+        for (unsigned int col = 0; col < ncols; ++col) {
+            index = (index >> 3) | neighbourhoodColumn(above, centre, below, (int) col + 1) << 6;
+            word |= (BoardWord) table->next[index] << (col % BOARD_WORD_BITS);
+            if (col % BOARD_WORD_BITS == BOARD_WORD_BITS - 1 || col + 1 == ncols) {
+                out[col / BOARD_WORD_BITS] = word;
+                word = 0;
+            }
+        }
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef CONWAY_LUT_H
+#define CONWAY_LUT_H
+
+#include <stdint.h>
+
+#include "board.h"
+#include "rule.h"
+
+// Number of distinct 3x3 neighbourhoods.
+#define NEIGHBOURHOOD_STATES 512
+
+// Next state of a tile for every 3x3 neighbourhood.  A neighbourhood is
+// indexed column by column from west to east, three bits per column from north
+// to south, so bit 4 is the tile itself and stepping one tile east is a shift
+// right by three with the new column entering at the top.
+typedef struct RuleTable {
+    uint8_t next[NEIGHBOURHOOD_STATES];
+} RuleTable;
+
+#define NEIGHBOURHOOD_CENTRE_BIT 4
+
+// Fills table with rule.
+void initRuleTable(RuleTable * const table, const LifeRule rule);
+
+// Computes rows [rowBegin, rowEnd) of the generation following src into dst,
+// one table lookup per tile.  Neighbours beyond the edges are read from src's
+// halo, which must have been filled for the topology.  src and dst must have the same dimensions and
+// must not alias.  dst's nalive is not maintained.
+void stepLutRows(const RuleTable * const table, const Board * const src, Board * const dst,
+                 const unsigned int rowBegin, const unsigned int rowEnd);
+
+#endif
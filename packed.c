@@ -0,0 +1,161 @@
+#include "packed.h"
+
+#include <pthread.h>
+#include <string.h>
+#ifdef __aarch64__
+#include <sys/auxv.h>
+#endif
+
+#include "packed_kernel.h"
+
+DEFINE_STEP_WORDS(stepWord, BoardWord, )
+
+// Only the births and survivals matter: the dying states of a Generations
+// rule are stepped apart from the live tiles.
+RuleKernel ruleKernelFor(const LifeRule rule) {
+    if (rule.birth == LIFE_RULE.birth && rule.survive == LIFE_RULE.survive) {
+        return RULE_KERNEL_LIFE;
+    }
+    if (rule.birth == HIGHLIFE_BIRTH && rule.survive == HIGHLIFE_SURVIVE) {
+        return RULE_KERNEL_HIGHLIFE;
+    }
+    if (rule.birth == DAY_AND_NIGHT_BIRTH && rule.survive == DAY_AND_NIGHT_SURVIVE) {
+        return RULE_KERNEL_DAY_AND_NIGHT;
+    }
+    if (rule.birth == SEEDS_BIRTH && rule.survive == SEEDS_SURVIVE) {
+        return RULE_KERNEL_SEEDS;
+    }
+    return RULE_KERNEL_GENERIC;
+}
+
+// Defines the scalar row and rect kernels for one RuleKernel.  The row kernel
+// slides a window of three words along the row, so that each word is loaded
+// once.  The halo supplies the neighbours of the edge tiles, so nothing in the
+// loop depends on where the row is.
+#define DEFINE_SCALAR_KERNELS(kernel, suffix) \
+    void stepPackedRowWords##suffix(const LifeRule * const rule, const Board * const src, Board * const dst, \
+                                    const unsigned int row, const unsigned int wordBegin, \
+                                    const unsigned int wordEnd) { \
+        const BoardWord * const centreRow = getBoardRow(src, row); \
+        const BoardWord * const aboveRow = centreRow - src->rowStride; \
+        const BoardWord * const belowRow = centreRow + src->rowStride; \
+        BoardWord * const out = getBoardRow(dst, row); \
+        if (wordBegin >= wordEnd) { \
+            return; \
+        } \
+        \
+        BoardWord aw = aboveRow[(int) wordBegin - 1]; \
+        BoardWord mw = centreRow[(int) wordBegin - 1]; \
+        BoardWord bw = belowRow[(int) wordBegin - 1]; \
+        BoardWord a = aboveRow[wordBegin]; \
+        BoardWord m = centreRow[wordBegin]; \
+        BoardWord b = belowRow[wordBegin]; \
+        for (unsigned int w = wordBegin; w < wordEnd; ++w) { \
+            const BoardWord ae = aboveRow[w + 1]; \
+            const BoardWord me = centreRow[w + 1]; \
+            const BoardWord be = belowRow[w + 1]; \
+            out[w] = stepWord##suffix(aw, a, ae, mw, m, me, bw, b, be, rule); \
+            aw = a; a = ae; \
+            mw = m; m = me; \
+            bw = b; b = be; \
+        } \
+        if (wordEnd == src->wordsPerRow) { \
+            out[wordEnd - 1] &= lastWordMask(src); \
+        } \
+    } \
+    \
+    static void stepPackedRectScalar##suffix(const LifeRule * const rule, const Board * const src, \
+                                             Board * const dst, \
+                                             const unsigned int rowBegin, const unsigned int rowEnd, \
+                                             const unsigned int wordBegin, const unsigned int wordEnd) { \
+        for (unsigned int row = rowBegin; row < rowEnd; ++row) { \
+            stepPackedRowWords##suffix(rule, src, dst, row, wordBegin, wordEnd); \
+        } \
+    }
+
+FOR_EACH_RULE_KERNEL(DEFINE_SCALAR_KERNELS)
+
+#define SCALAR_RECT_KERNEL_ENTRY(kernel, suffix) [kernel] = stepPackedRectScalar##suffix,
+const PackedRectKernel scalarRectKernels[RULE_KERNELS] = {
+    FOR_EACH_RULE_KERNEL(SCALAR_RECT_KERNEL_ENTRY)
+};
+
+typedef struct PackedKernelInfo {
+    const char *name;
+    const PackedRectKernel *kernels;
+    bool (*isSupported)(void);
+} PackedKernelInfo;
+
+static bool alwaysSupported(void) {
+    return true;
+}
+
+#ifdef CONWAY_X86_KERNELS
+static bool avx2Supported(void) {
+    return __builtin_cpu_supports("avx2");
+}
+
+static bool avx512Supported(void) {
+    return __builtin_cpu_supports("avx512f");
+}
+#endif
+
+#ifdef CONWAY_NEON_KERNELS
+static bool neonSupported(void) {
+    return (getauxval(AT_HWCAP) & HWCAP_ASIMD) != 0;
+}
+#endif
+
+// Ordered from most to least preferred, so "auto" takes the first supported.
+static const PackedKernelInfo kernelSets[] = {
+#ifdef CONWAY_X86_KERNELS
+    {"avx512", avx512RectKernels, avx512Supported},
+    {"avx2", avx2RectKernels, avx2Supported},
+#endif
+#ifdef CONWAY_NEON_KERNELS
+    {"neon", neonRectKernels, neonSupported},
+#endif
+    {"scalar", scalarRectKernels, alwaysSupported},
+};
+
+static const PackedKernelInfo *activeKernel = NULL;
+
+bool selectPackedKernel(const char * const name) {
+    const bool automatic = strcmp(name, "auto") == 0;
+    for (size_t i = 0; i < sizeof(kernelSets) / sizeof(kernelSets[0]); ++i) {
+        if (automatic || strcmp(name, kernelSets[i].name) == 0) {
+            if (kernelSets[i].isSupported()) {
+                activeKernel = &kernelSets[i];
+                return true;
+            }
+            if (!automatic) {
+                return false;
+            }
+        }
+    }
+    return false;
+}
+
+static pthread_once_t automaticSelection = PTHREAD_ONCE_INIT;
+
+static void selectAutomatically(void) {
+    if (activeKernel == NULL) {
+        selectPackedKernel("auto");
+    }
+}
+
+// The first call may come from several stepping threads at once.
+static const PackedKernelInfo *getActiveKernel(void) {
+    pthread_once(&automaticSelection, selectAutomatically);
+    return activeKernel;
+}
+
+const char *packedKernelName(void) {
+    return getActiveKernel()->name;
+}
+
+void stepPackedRect(const LifeRule * const rule, const Board * const src, Board * const dst,
+                    const unsigned int rowBegin, const unsigned int rowEnd,
+                    const unsigned int wordBegin, const unsigned int wordEnd) {
+    getActiveKernel()->kernels[ruleKernelFor(*rule)](rule, src, dst, rowBegin, rowEnd, wordBegin, wordEnd);
+}
@@ -0,0 +1,35 @@
+#ifndef CONWAY_PACKED_H
+#define CONWAY_PACKED_H
+
+#include <stdbool.h>
+
+#include "board.h"
+#include "rule.h"
+
+// Computes words [wordBegin, wordEnd) of rows [rowBegin, rowEnd) of the
+// generation following src under rule into dst, a whole word of tiles at a
+// time, using the kernel picked by selectPackedKernel().  Life, HighLife, Day
+// & Night and Seeds have kernels specialised for them.  Neighbours beyond the
+// edges are read from src's halo, which must have been filled for the
+// topology.  src and dst must have the same dimensions and must not alias.
+// dst's nalive is not maintained.
+void stepPackedRect(const LifeRule * const rule, const Board * const src, Board * const dst,
+                    const unsigned int rowBegin, const unsigned int rowEnd,
+                    const unsigned int wordBegin, const unsigned int wordEnd);
+
+// As stepPackedRect(), over the full width of the board.
+static inline void stepPackedRows(const LifeRule * const rule, const Board * const src, Board * const dst,
+                                  const unsigned int rowBegin, const unsigned int rowEnd) {
+    stepPackedRect(rule, src, dst, rowBegin, rowEnd, 0, src->wordsPerRow);
+}
+
+// Chooses the implementation used by stepPackedRect() for the whole process:
+// "scalar", "avx2", "avx512", "neon", or "auto" for the widest one this CPU
+// supports.  Returns false, leaving the choice unchanged, if the kernel is
+// unknown or the CPU lacks the instructions for it.  Until this is called the
+// kernel is chosen as if by "auto".  Not thread safe; call it at startup.
+bool selectPackedKernel(const char * const name);
+
+const char *packedKernelName(void);
+
+#endif
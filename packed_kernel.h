@@ -0,0 +1,177 @@
+#ifndef CONWAY_PACKED_KERNEL_H
+#define CONWAY_PACKED_KERNEL_H
+
+// Internals shared by the scalar and vector implementations of packed.h.
+
+#include "board.h"
+#include "rule.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CONWAY_X86_KERNELS 1
+#endif
+#if defined(__aarch64__)
+#define CONWAY_NEON_KERNELS 1
+#endif
+
+// Rules with kernels of their own, in which the rule is a compile time
+// constant.  Any other rule runs on the generic kernels, which read it at run
+// time.
+typedef enum RuleKernel {
+    RULE_KERNEL_LIFE,
+    RULE_KERNEL_HIGHLIFE,
+    RULE_KERNEL_DAY_AND_NIGHT,
+    RULE_KERNEL_SEEDS,
+    RULE_KERNEL_GENERIC,
+    RULE_KERNELS
+} RuleKernel;
+
+#define HIGHLIFE_BIRTH ((1u << 3) | (1u << 6))
+#define HIGHLIFE_SURVIVE ((1u << 2) | (1u << 3))
+#define DAY_AND_NIGHT_BIRTH ((1u << 3) | (1u << 6) | (1u << 7) | (1u << 8))
+#define DAY_AND_NIGHT_SURVIVE ((1u << 3) | (1u << 4) | (1u << 6) | (1u << 7) | (1u << 8))
+#define SEEDS_BIRTH (1u << 2)
+#define SEEDS_SURVIVE 0u
+
+RuleKernel ruleKernelFor(const LifeRule rule);
+
+// Partial neighbour sums of the words centred on a word in the rows above, at
+// and below it, bit-sliced so that every bit position is an independent lane:
+//   above/below: 3 tiles each -> 2 bit sums (ones + 2 * twos)
+//   middle: 2 tiles -> 2 bit sum
+// Expects the nine operands of a step function in scope.
+#define STEP_WORD_PARTIAL_SUMS(T) \
+    /* Shift each row so that bit i of every operand neighbours bit i. */ \
+    const T a0 = (above << 1) | (aboveWest >> (BOARD_WORD_BITS - 1)); \
+    const T a2 = (above >> 1) | (aboveEast << (BOARD_WORD_BITS - 1)); \
+    const T m0 = (centre << 1) | (west >> (BOARD_WORD_BITS - 1)); \
+    const T m2 = (centre >> 1) | (east << (BOARD_WORD_BITS - 1)); \
+    const T b0 = (below << 1) | (belowWest >> (BOARD_WORD_BITS - 1)); \
+    const T b2 = (below >> 1) | (belowEast << (BOARD_WORD_BITS - 1)); \
+    \
+    const T aboveOnes = a0 ^ above ^ a2; \
+    const T aboveTwos = (a0 & above) | (a2 & (a0 ^ above)); \
+    const T belowOnes = b0 ^ below ^ b2; \
+    const T belowTwos = (b0 & below) | (b2 & (b0 ^ below)); \
+    const T middleOnes = m0 ^ m2; \
+    const T middleTwos = m0 & m2; \
+    \
+    const T ones = aboveOnes ^ belowOnes ^ middleOnes; \
+    const T onesCarry = (aboveOnes & belowOnes) | (middleOnes & (aboveOnes ^ belowOnes));
+
+#define STEP_WORD_PARAMETERS(T) \
+    const T aboveWest, const T above, const T aboveEast, \
+    const T west, const T centre, const T east, \
+    const T belowWest, const T below, const T belowEast
+
+#define STEP_WORD_ARGUMENTS \
+    aboveWest, above, aboveEast, west, centre, east, belowWest, below, belowEast
+
+// Defines functions computing one word (or one vector of words) of the next
+// generation from the three words centred on it in each of the rows above, at
+// and below it, one per RuleKernel: prefix##Life, prefix##HighLife,
+// prefix##DayAndNight, prefix##Seeds and prefix##Generic.  All take the rule
+// as their last argument, though only the generic one reads it.  T may be
+// BoardWord or a GCC vector of BoardWords, in which case every word of the
+// vector is an independent row word.
+//
+// After the partial sums, count = ones + 2 * (sum of the four twos bits).
+// For Life a tile lives next generation if count is 3, or 2 and the tile is
+// alive, i.e. if exactly one twos bit is set and either ones or the tile
+// itself is.  Other rules need the full count, so the twos are summed into
+// three more bit planes, and the rule selects the lanes whose count it has a
+// bit set for.  With the rule a constant that selection folds down to a
+// handful of operations.
+#define DEFINE_STEP_WORDS(prefix, T, attributes) \
+    static inline attributes T prefix##Life(STEP_WORD_PARAMETERS(T), const LifeRule * const rule) { \
+        (void) rule; \
+        STEP_WORD_PARTIAL_SUMS(T) \
+        const T x = aboveTwos ^ belowTwos; \
+        const T y = middleTwos ^ onesCarry; \
+        const T atLeastTwo = (aboveTwos & belowTwos) | (middleTwos & onesCarry) | (x & y); \
+        const T exactlyOne = (x ^ y) & ~atLeastTwo; \
+        return exactlyOne & (ones | centre); \
+    } \
+    \
+    static inline __attribute__((always_inline)) attributes T prefix##Rule(STEP_WORD_PARAMETERS(T), \
+                                                                           const unsigned int birth, \
+                                                                           const unsigned int survive) { \
+        STEP_WORD_PARTIAL_SUMS(T) \
+        /* count = ones + 2 * twos + 4 * fours + 8 * eights */ \
+        const T twosSum = aboveTwos ^ belowTwos ^ middleTwos; \
+        const T twosCarry = (aboveTwos & belowTwos) | (middleTwos & (aboveTwos ^ belowTwos)); \
+        const T twos = twosSum ^ onesCarry; \
+        const T foursCarry = twosSum & onesCarry; \
+        const T fours = twosCarry ^ foursCarry; \
+        const T eights = twosCarry & foursCarry; \
+        T next = centre ^ centre; \
+        for (unsigned int n = 0; n < NEIGHBOUR_COUNTS; ++n) { \
+            const unsigned int bit = 1u << n; \
+            if (((birth | survive) & bit) == 0) { \
+                continue; \
+            } \
+            const T count = ((n & 1) ? ones : ~ones) & ((n & 2) ? twos : ~twos) \
+                    & ((n & 4) ? fours : ~fours) & ((n & 8) ? eights : ~eights); \
+            if (birth & bit) { \
+                next |= count & ~centre; \
+            } \
+            if (survive & bit) { \
+                next |= count & centre; \
+            } \
+        } \
+        return next; \
+    } \
+    \
+    static inline attributes T prefix##HighLife(STEP_WORD_PARAMETERS(T), const LifeRule * const rule) { \
+        (void) rule; \
+        return prefix##Rule(STEP_WORD_ARGUMENTS, HIGHLIFE_BIRTH, HIGHLIFE_SURVIVE); \
+    } \
+    \
+    static inline attributes T prefix##DayAndNight(STEP_WORD_PARAMETERS(T), const LifeRule * const rule) { \
+        (void) rule; \
+        return prefix##Rule(STEP_WORD_ARGUMENTS, DAY_AND_NIGHT_BIRTH, DAY_AND_NIGHT_SURVIVE); \
+    } \
+    \
+    static inline attributes T prefix##Seeds(STEP_WORD_PARAMETERS(T), const LifeRule * const rule) { \
+        (void) rule; \
+        return prefix##Rule(STEP_WORD_ARGUMENTS, SEEDS_BIRTH, SEEDS_SURVIVE); \
+    } \
+    \
+    static inline attributes T prefix##Generic(STEP_WORD_PARAMETERS(T), const LifeRule * const rule) { \
+        return prefix##Rule(STEP_WORD_ARGUMENTS, rule->birth, rule->survive); \
+    }
+
+// Invokes X(kernel, suffix) for every RuleKernel, with the suffix of its step
+// word function.
+#define FOR_EACH_RULE_KERNEL(X) \
+    X(RULE_KERNEL_LIFE, Life) \
+    X(RULE_KERNEL_HIGHLIFE, HighLife) \
+    X(RULE_KERNEL_DAY_AND_NIGHT, DayAndNight) \
+    X(RULE_KERNEL_SEEDS, Seeds) \
+    X(RULE_KERNEL_GENERIC, Generic)
+
+typedef void (*PackedRectKernel)(const LifeRule * const rule, const Board * const src, Board * const dst,
+                                 const unsigned int rowBegin, const unsigned int rowEnd,
+                                 const unsigned int wordBegin, const unsigned int wordEnd);
+
+// Computes words [wordBegin, wordEnd) of one row of the next generation, one
+// per RuleKernel.  The vector kernels use these for the words their vectors
+// can't cover.
+#define DECLARE_ROW_WORDS(kernel, suffix) \
+    void stepPackedRowWords##suffix(const LifeRule * const rule, const Board * const src, Board * const dst, \
+                                    const unsigned int row, const unsigned int wordBegin, \
+                                    const unsigned int wordEnd);
+FOR_EACH_RULE_KERNEL(DECLARE_ROW_WORDS)
+#undef DECLARE_ROW_WORDS
+
+// One rect kernel per RuleKernel for each instruction set, indexed by
+// RuleKernel.
+extern const PackedRectKernel scalarRectKernels[RULE_KERNELS];
+#ifdef CONWAY_X86_KERNELS
+extern const PackedRectKernel avx2RectKernels[RULE_KERNELS];
+extern const PackedRectKernel avx512RectKernels[RULE_KERNELS];
+#endif
+#ifdef CONWAY_NEON_KERNELS
+extern const PackedRectKernel neonRectKernels[RULE_KERNELS];
+#endif
+
+#endif
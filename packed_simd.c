@@ -0,0 +1,74 @@
+#include <string.h>
+
+#include "packed_kernel.h"
+
+// Defines a packed rect kernel for one RuleKernel that steps VECTOR_WORDS
+// words of a row at once with T, a GCC vector of BoardWords.  The
+// neighbouring words of each vector are fetched with unaligned loads one word
+// to either side, which the halo makes valid everywhere, so only the leftovers
+// of each row of the rect and the last word of the board's rows, which needs
+// its padding masked, fall back to the scalar row kernel.  The arithmetic is
+// exactly that of the scalar kernel, so results are bit-identical.
+#define DEFINE_VECTOR_KERNEL(prefix, T, VECTOR_WORDS, attributes, suffix) \
+    attributes void prefix##suffix(const LifeRule * const rule, const Board * const src, Board * const dst, \
+                                   const unsigned int rowBegin, const unsigned int rowEnd, \
+                                   const unsigned int wordBegin, const unsigned int wordEnd) { \
+        if (wordBegin >= wordEnd) { \
+            return; \
+        } \
+        const unsigned int vectorEnd = wordEnd == src->wordsPerRow ? wordEnd - 1 : wordEnd; \
+        for (unsigned int row = rowBegin; row < rowEnd; ++row) { \
+            const BoardWord * const m = getBoardRow(src, row); \
+            const BoardWord * const a = m - src->rowStride; \
+            const BoardWord * const b = m + src->rowStride; \
+            BoardWord * const out = getBoardRow(dst, row); \
+            unsigned int w = wordBegin; \
+            for (; w + VECTOR_WORDS <= vectorEnd; w += VECTOR_WORDS) { \
+                const T next = prefix##Word##suffix( \
+                        prefix##Load(a + w - 1), prefix##Load(a + w), prefix##Load(a + w + 1), \
+                        prefix##Load(m + w - 1), prefix##Load(m + w), prefix##Load(m + w + 1), \
+                        prefix##Load(b + w - 1), prefix##Load(b + w), prefix##Load(b + w + 1), rule); \
+                memcpy(out + w, &next, sizeof(next)); \
+            } \
+            stepPackedRowWords##suffix(rule, src, dst, row, w, wordEnd); \
+        } \
+    }
+
+// Defines the step word functions, unaligned load and every rule's rect
+// kernel for one instruction set, along with the table of its kernels.
+#define DEFINE_VECTOR_KERNELS(prefix, T, VECTOR_WORDS, attributes, table) \
+    DEFINE_STEP_WORDS(prefix##Word, T, attributes) \
+    \
+    static inline attributes T prefix##Load(const BoardWord * const p) { \
+        T v; \
+        memcpy(&v, p, sizeof(v)); \
+        return v; \
+    } \
+    \
+    DEFINE_VECTOR_KERNEL(prefix, T, VECTOR_WORDS, attributes, Life) \
+    DEFINE_VECTOR_KERNEL(prefix, T, VECTOR_WORDS, attributes, HighLife) \
+    DEFINE_VECTOR_KERNEL(prefix, T, VECTOR_WORDS, attributes, DayAndNight) \
+    DEFINE_VECTOR_KERNEL(prefix, T, VECTOR_WORDS, attributes, Seeds) \
+    DEFINE_VECTOR_KERNEL(prefix, T, VECTOR_WORDS, attributes, Generic) \
+    \
+    const PackedRectKernel table[RULE_KERNELS] = { \
+        [RULE_KERNEL_LIFE] = prefix##Life, \
+        [RULE_KERNEL_HIGHLIFE] = prefix##HighLife, \
+        [RULE_KERNEL_DAY_AND_NIGHT] = prefix##DayAndNight, \
+        [RULE_KERNEL_SEEDS] = prefix##Seeds, \
+        [RULE_KERNEL_GENERIC] = prefix##Generic, \
+    };
+
+#ifdef CONWAY_X86_KERNELS
+typedef BoardWord Vector4Words __attribute__((vector_size(4 * sizeof(BoardWord))));
+typedef BoardWord Vector8Words __attribute__((vector_size(8 * sizeof(BoardWord))));
+
+DEFINE_VECTOR_KERNELS(stepPackedRectAvx2, Vector4Words, 4, __attribute__((target("avx2"))), avx2RectKernels)
+DEFINE_VECTOR_KERNELS(stepPackedRectAvx512, Vector8Words, 8, __attribute__((target("avx512f"))), avx512RectKernels)
+#endif
+
+#ifdef CONWAY_NEON_KERNELS
+typedef BoardWord Vector2Words __attribute__((vector_size(2 * sizeof(BoardWord))));
+
+DEFINE_VECTOR_KERNELS(stepPackedRectNeon, Vector2Words, 2, , neonRectKernels)
+#endif
@@ -0,0 +1,281 @@
+#include "pattern.h"
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Size of the chunks RLE bodies are read in.
+#define READ_CHUNK_SIZE 65536
+
+static bool isCommentLine(const char * const line) {
+    return line[0] == '!';
+}
+
+static bool isAliveChar(const char c) {
+    return c == 'O' || c == 'X' || c == '*';
+}
+
+static unsigned int lineLength(const char * const line, const ssize_t len) {
+    ssize_t end = len;
+    while (end > 0 && (line[end - 1] == '\n' || line[end - 1] == '\r')) {
+        --end;
+    }
+    return (unsigned int) end;
+}
+
+// Brings tiles [col, col + count) of a row to life a word at a time.  They
+// must all be dead.
+static void setAliveRun(Board * const board, const unsigned int row, unsigned int col, unsigned int count) {
+    BoardWord * const words = getBoardRow(board, row);
+    board->nalive += count;
+    while (count > 0) {
+        const unsigned int bit = col % BOARD_WORD_BITS;
+        const unsigned int n = count < BOARD_WORD_BITS - bit ? count : BOARD_WORD_BITS - bit;
+        const BoardWord run = n == BOARD_WORD_BITS ? ~(BoardWord) 0 : (((BoardWord) 1 << n) - 1);
+        words[col / BOARD_WORD_BITS] |= run << bit;
+        col += n;
+        count -= n;
+    }
+}
+
+// Tells the formats apart by their first line.
+static PatternFormat detectFormat(FILE * const file) {
+    char *line = NULL;
+    size_t cap = 0;
+    PatternFormat format = PATTERN_PLAINTEXT;
+    if (getline(&line, &cap, file) != -1) {
+        if (strncmp(line, "#Life 1.06", 10) == 0) {
+            format = PATTERN_LIFE_106;
+        } else if (line[0] == '#' || line[0] == 'x') {
+            format = PATTERN_RLE;
+        }
+    }
+    free(line);
+    rewind(file);
+    return format;
+}
+
+static bool loadPlaintext(FILE * const file, Board * const board) {
+    // First pass finds the pattern's extent so that the board is allocated
+    // only once.
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    unsigned int nrows = 0;
+    unsigned int ncols = 0;
+    while ((len = getline(&line, &cap, file)) != -1) {
+        if (isCommentLine(line)) {
+            continue;
+        }
+        unsigned int lineCols = lineLength(line, len);
+        if (lineCols > ncols) {
+            ncols = lineCols;
+        }
+        ++nrows;
+    }
+
+    bool ok = initBoard(board, nrows, ncols);
+    rewind(file);
+    unsigned int row = 0;
+    while (ok && (len = getline(&line, &cap, file)) != -1) {
+        if (isCommentLine(line)) {
+            continue;
+        }
+        unsigned int lineCols = lineLength(line, len);
+        for (unsigned int col = 0; col < lineCols; ++col) {
+            if (isAliveChar(line[col])) {
+                setTileState(board, ALIVE, row, col);
+            }
+        }
+        ++row;
+    }
+    free(line);
+    return ok;
+}
+
+// Parses the "x = N, y = N, rule = R" header line of an RLE file.
+static bool parseRleHeader(const char * const line, unsigned int * const ncols, unsigned int * const nrows,
+                           PatternInfo * const info) {
+    if (sscanf(line, " x = %u , y = %u", ncols, nrows) != 2) {
+        return false;
+    }
+    const char *rule = strstr(line, "rule");
+    if (rule != NULL && (rule = strchr(rule, '=')) != NULL) {
+        ++rule;
+        while (*rule == ' ') {
+            ++rule;
+        }
+        char text[64];
+        size_t len = strcspn(rule, " ,\r\n");
+        if (len < sizeof(text)) {
+            memcpy(text, rule, len);
+            text[len] = '\0';
+            info->hasRule = parseLifeRule(text, &info->rule);
+        }
+    }
+    return true;
+}
+
+// The body of an RLE file is streamed through a fixed buffer: runs of dead
+// tiles just advance the position and runs of live ones are set a word at a
+// time, so a huge file costs no more memory than its board.
+static bool loadRle(FILE * const file, Board * const board, PatternInfo * const info) {
+    char *line = NULL;
+    size_t cap = 0;
+    bool haveHeader = false;
+    unsigned int nrows = 0;
+    unsigned int ncols = 0;
+    while (!haveHeader && getline(&line, &cap, file) != -1) {
+        if (line[0] == '#') {
+            continue;
+        }
+        haveHeader = parseRleHeader(line, &ncols, &nrows, info);
+        if (!haveHeader) {
+            break;
+        }
+    }
+    free(line);
+    if (!haveHeader || !initBoard(board, nrows, ncols)) {
+        return false;
+    }
+
+    char * const buf = (char *) malloc(READ_CHUNK_SIZE);
+    if (buf == NULL) {
+        return false;
+    }
+    uint64_t count = 0;
+    unsigned int row = 0;
+    uint64_t col = 0;
+    bool ok = true;
+    bool done = false;
+    size_t len;
+    while (ok && !done && (len = fread(buf, 1, READ_CHUNK_SIZE, file)) > 0) {
+        for (size_t i = 0; i < len && ok && !done; ++i) {
+            const char c = buf[i];
+            if (c >= '0' && c <= '9') {
+                count = count * 10 + (uint64_t) (c - '0');
+                ok = count <= UINT32_MAX;
+                continue;
+            }
+            if (isspace((unsigned char) c)) {
+                // Line breaks may fall anywhere, even inside a count.
+                continue;
+            }
+            const uint64_t n = count == 0 ? 1 : count;
+            count = 0;
+            if (c == 'b' || c == '.') {
+                col += n;
+            } else if (c == '$') {
+                row = n > nrows - row ? nrows : row + (unsigned int) n;
+                col = 0;
+            } else if (c == '!') {
+                done = true;
+            } else if (isalpha((unsigned char) c)) {
+                // Any other state counts as alive.
+                ok = row < nrows && col + n <= ncols;
+                if (ok) {
+                    setAliveRun(board, row, (unsigned int) col, (unsigned int) n);
+                }
+                col += n;
+            } else {
+                ok = false;
+            }
+        }
+    }
+    free(buf);
+    return ok;
+}
+
+// Reads the "x y" coordinates on the next non-comment line into *col and *row.
+// Returns false at the end of the file.
+static bool readLife106Cell(FILE * const file, char ** const line, size_t * const cap,
+                            long long * const col, long long * const row, bool * const ok) {
+    while (getline(line, cap, file) != -1) {
+        if ((*line)[0] == '#') {
+            continue;
+        }
+        char *end;
+        *col = strtoll(*line, &end, 10);
+        char * const rowText = end;
+        *row = strtoll(rowText, &end, 10);
+        if (end == rowText) {
+            // Blank lines are harmless anywhere else.
+            *ok = strspn(*line, " \t\r\n") == strlen(*line);
+            if (!*ok) {
+                return false;
+            }
+            continue;
+        }
+        return true;
+    }
+    return false;
+}
+
+// Life 1.06 coordinates may be anywhere, so a first pass finds their extent,
+// which becomes the board.
+static bool loadLife106(FILE * const file, Board * const board) {
+    char *line = NULL;
+    size_t cap = 0;
+    long long col, row;
+    long long minCol = 0, maxCol = -1, minRow = 0, maxRow = -1;
+    bool ok = true;
+    bool any = false;
+    while (readLife106Cell(file, &line, &cap, &col, &row, &ok)) {
+        if (!any || col < minCol) {
+            minCol = col;
+        }
+        if (!any || col > maxCol) {
+            maxCol = col;
+        }
+        if (!any || row < minRow) {
+            minRow = row;
+        }
+        if (!any || row > maxRow) {
+            maxRow = row;
+        }
+        any = true;
+    }
+    ok = ok && maxCol - minCol < UINT32_MAX && maxRow - minRow < UINT32_MAX
+            && initBoard(board, (unsigned int) (maxRow - minRow + 1), (unsigned int) (maxCol - minCol + 1));
+
+    rewind(file);
+    while (ok && readLife106Cell(file, &line, &cap, &col, &row, &ok)) {
+        setTileState(board, ALIVE, (unsigned int) (row - minRow), (unsigned int) (col - minCol));
+    }
+    free(line);
+    return ok;
+}
+
+bool loadPattern(const char * const path, Board * const board, PatternInfo * const info) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return false;
+    }
+
+    PatternInfo scratch;
+    PatternInfo * const out = info != NULL ? info : &scratch;
+    out->format = detectFormat(file);
+    out->hasRule = false;
+    *board = (Board) {0};
+    bool ok;
+    switch (out->format) {
+    case PATTERN_RLE:
+        ok = loadRle(file, board, out);
+        break;
+    case PATTERN_LIFE_106:
+        ok = loadLife106(file, board);
+        break;
+    default:
+        ok = loadPlaintext(file, board);
+        break;
+    }
+
+    if (!ok || ferror(file)) {
+        destroyBoard(board);
+        ok = false;
+    }
+    fclose(file);
+    return ok;
+}
@@ -0,0 +1,35 @@
+#ifndef CONWAY_PATTERN_H
+#define CONWAY_PATTERN_H
+
+#include <stdbool.h>
+
+#include "board.h"
+#include "rule.h"
+
+typedef enum PatternFormat {
+    // Lines of '.' dead and 'O' live tiles, with '!' comment lines.
+    PATTERN_PLAINTEXT,
+    // Run length encoded, with an "x = N, y = N" header line.
+    PATTERN_RLE,
+    // "#Life 1.06" followed by the "x y" coordinates of every live tile.
+    PATTERN_LIFE_106
+} PatternFormat;
+
+// What a pattern file says about itself besides its tiles.
+typedef struct PatternInfo {
+    PatternFormat format;
+    // Set if the file names the rule it is meant for, in rule.
+    bool hasRule;
+    LifeRule rule;
+} PatternInfo;
+
+// Reads a plaintext, RLE or Life 1.06 pattern file, telling them apart by
+// their contents, into a freshly allocated board exactly large enough to hold
+// it.  The file is streamed straight into the board, which is allocated once,
+// so memory use doesn't depend on the file's size.  In plaintext files 'O',
+// 'X' and '*' mark live tiles and any other character is a dead tile.  info
+// may be NULL.  Returns false and leaves the board empty if the file can't be
+// read or is malformed.
+bool loadPattern(const char * const path, Board * const board, PatternInfo * const info);
+
+#endif
@@ -0,0 +1,104 @@
+#include "rule.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+typedef struct NamedRule {
+    const char *name;
+    const char *notation;
+} NamedRule;
+
+static const NamedRule namedRules[] = {
+    {"life", "B3/S23"},
+    {"highlife", "B36/S23"},
+    {"daynight", "B3678/S34678"},
+    {"seeds", "B2/S"},
+    {"briansbrain", "B2/S/C3"},
+    {"starwars", "B2/S345/C4"},
+};
+
+// Parses the digits of one half of a rule, from text up to (not including)
+// end, into a mask.
+static bool parseCounts(const char *text, const char * const end, uint16_t * const mask) {
+    *mask = 0;
+    for (; text != end; ++text) {
+        if (*text < '0' || *text >= '0' + NEIGHBOUR_COUNTS) {
+            return false;
+        }
+        *mask |= (uint16_t) (1u << (*text - '0'));
+    }
+    return true;
+}
+
+// Parses the number of states of a Generations rule, with or without a 'C'.
+static bool parseStates(const char *text, uint16_t * const states) {
+    if (toupper((unsigned char) *text) == 'C') {
+        ++text;
+    }
+    if (*text < '0' || *text > '9') {
+        return false;
+    }
+    char *end;
+    const unsigned long value = strtoul(text, &end, 10);
+    if (*end != '\0' || value < 2 || value > MAX_RULE_STATES) {
+        return false;
+    }
+    *states = (uint16_t) value;
+    return true;
+}
+
+bool parseLifeRule(const char * const text, LifeRule * const rule) {
+    for (size_t i = 0; i < sizeof(namedRules) / sizeof(namedRules[0]); ++i) {
+        if (strcasecmp(text, namedRules[i].name) == 0) {
+            return parseLifeRule(namedRules[i].notation, rule);
+        }
+    }
+
+    const char * const slash = strchr(text, '/');
+    if (slash == NULL) {
+        return false;
+    }
+    const char * const firstEnd = slash;
+    const char * const second = slash + 1;
+    const char * const secondSlash = strchr(second, '/');
+    const char * const secondEnd = secondSlash != NULL ? secondSlash : second + strlen(second);
+    rule->states = 2;
+    if (secondSlash != NULL && !parseStates(secondSlash + 1, &rule->states)) {
+        return false;
+    }
+
+    const char firstTag = (char) toupper((unsigned char) text[0]);
+    const char secondTag = (char) toupper((unsigned char) second[0]);
+    if (firstTag == 'B' && secondTag == 'S') {
+        return parseCounts(text + 1, firstEnd, &rule->birth) && parseCounts(second + 1, secondEnd, &rule->survive);
+    }
+    if (firstTag == 'S' && secondTag == 'B') {
+        return parseCounts(text + 1, firstEnd, &rule->survive) && parseCounts(second + 1, secondEnd, &rule->birth);
+    }
+    // Untagged, the survive counts come first.
+    return parseCounts(text, firstEnd, &rule->survive) && parseCounts(second, secondEnd, &rule->birth);
+}
+
+void formatLifeRule(const LifeRule rule, char * const buf, const size_t size) {
+    char birth[NEIGHBOUR_COUNTS + 1];
+    char survive[NEIGHBOUR_COUNTS + 1];
+    size_t nbirth = 0, nsurvive = 0;
+    for (unsigned int n = 0; n < NEIGHBOUR_COUNTS; ++n) {
+        if (rule.birth & (1u << n)) {
+            birth[nbirth++] = (char) ('0' + n);
+        }
+        if (rule.survive & (1u << n)) {
+            survive[nsurvive++] = (char) ('0' + n);
+        }
+    }
+    birth[nbirth] = '\0';
+    survive[nsurvive] = '\0';
+    if (ruleHasDecay(rule)) {
+        snprintf(buf, size, "B%s/S%s/C%u", birth, survive, rule.states);
+    } else {
+        snprintf(buf, size, "B%s/S%s", birth, survive);
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef CONWAY_RULE_H
+#define CONWAY_RULE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// A Life-like rule in B/S notation: bit n of birth is set if a dead tile with
+// n live neighbours comes alive, and bit n of survive if a live tile with n
+// live neighbours stays alive.
+//
+// With more than two states it is a Generations rule instead, under which a
+// live tile that doesn't survive isn't dead yet but dying: it passes through
+// states 2, 3 and on to states - 1, a generation each, and then dies.  Dying
+// tiles neither count as live neighbours nor can come alive.
+typedef struct LifeRule {
+    uint16_t birth;
+    uint16_t survive;
+    // 2 for a Life-like rule, up to MAX_RULE_STATES.
+    uint16_t states;
+} LifeRule;
+
+#define NEIGHBOUR_COUNTS 9
+
+#define MAX_RULE_STATES 256
+
+// B3/S23, Conway's Game of Life.
+#define LIFE_RULE ((LifeRule) {1u << 3, (1u << 2) | (1u << 3), 2})
+
+// Parses "B3/S23" style notation (case insensitive, in either order), the
+// older "23/3" survive/birth notation, or one of the names "life",
+// "highlife", "daynight", "seeds", "briansbrain" and "starwars".  Either
+// notation may end in a third part giving the number of states of a
+// Generations rule, e.g. "B2/S/C3" or "345/2/4".  Returns false if text is
+// none of these.
+bool parseLifeRule(const char * const text, LifeRule * const rule);
+
+// Writes rule in B/S notation, e.g. "B36/S23", or "B2/S/C3" for a
+// Generations rule.
+void formatLifeRule(const LifeRule rule, char * const buf, const size_t size);
+
+static inline bool lifeRulesEqual(const LifeRule a, const LifeRule b) {
+    return a.birth == b.birth && a.survive == b.survive && a.states == b.states;
+}
+
+// Whether tiles that stop being alive pass through dying states first.
+static inline bool ruleHasDecay(const LifeRule rule) {
+    return rule.states > 2;
+}
+
+// Whether dead tiles with no live neighbours come alive, so that empty space
+// doesn't stay empty.
+static inline bool ruleBirthsFromNothing(const LifeRule rule) {
+    return (rule.birth & 1) != 0;
+}
+
+#endif
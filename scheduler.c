@@ -0,0 +1,52 @@
+#include "scheduler.h"
+
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+
+// Further behind than this the schedule is restarted from now.
+#define MAX_LAG_NANOS (NANOS_PER_SEC / 10)
+
+uint64_t monotonicNanos(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * NANOS_PER_SEC + (uint64_t) now.tv_nsec;
+}
+
+void startTickScheduler(TickScheduler * const scheduler, const unsigned int ticksPerSec) {
+    *scheduler = (TickScheduler) {0};
+    scheduler->periodNanos = ticksPerSec == 0 ? 0 : NANOS_PER_SEC / ticksPerSec;
+    scheduler->startNanos = monotonicNanos();
+    scheduler->nextDeadline = scheduler->startNanos;
+}
+
+void waitForNextTick(TickScheduler * const scheduler) {
+    scheduler->ticks++;
+    if (scheduler->periodNanos == 0) {
+        return;
+    }
+    scheduler->nextDeadline += scheduler->periodNanos;
+    const struct timespec deadline = {
+        (time_t) (scheduler->nextDeadline / NANOS_PER_SEC), (long) (scheduler->nextDeadline % NANOS_PER_SEC)
+    };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {}
+
+    const uint64_t now = monotonicNanos();
+    const uint64_t late = now - scheduler->nextDeadline;
+    const double lateness = (double) late / NANOS_PER_SEC;
+    const double delta = lateness - scheduler->meanLateness;
+    scheduler->meanLateness += delta / (double) scheduler->ticks;
+    scheduler->lateness2 += delta * (lateness - scheduler->meanLateness);
+    if (late > MAX_LAG_NANOS) {
+        scheduler->nextDeadline = now;
+    }
+}
+
+double achievedTickRate(const TickScheduler * const scheduler) {
+    const uint64_t elapsed = monotonicNanos() - scheduler->startNanos;
+    return elapsed == 0 ? 0 : (double) scheduler->ticks * NANOS_PER_SEC / (double) elapsed;
+}
+
+double tickJitter(const TickScheduler * const scheduler) {
+    return scheduler->ticks < 2 ? 0 : sqrt(scheduler->lateness2 / (double) (scheduler->ticks - 1));
+}
@@ -0,0 +1,39 @@
+#ifndef CONWAY_SCHEDULER_H
+#define CONWAY_SCHEDULER_H
+
+#include <stdint.h>
+
+#define NANOS_PER_SEC UINT64_C(1000000000)
+
+// Paces ticks against absolute deadlines on the monotonic clock, so that time
+// spent stepping and drawing doesn't add to the period, and measures how well
+// the rate was kept.
+typedef struct TickScheduler {
+    // 0 when unlimited.
+    uint64_t periodNanos;
+    uint64_t startNanos;
+    uint64_t nextDeadline;
+    uint64_t ticks;
+    // Running mean and sum of squared deviations of how late each tick
+    // started after its deadline, by Welford's method.
+    double meanLateness;
+    double lateness2;
+} TickScheduler;
+
+uint64_t monotonicNanos(void);
+
+// Starts the clock.  A ticksPerSec of 0 runs unlimited.
+void startTickScheduler(TickScheduler * const scheduler, const unsigned int ticksPerSec);
+
+// Sleeps until the next tick's deadline, which has passed already if the last
+// tick overran.  Overruns of more than a fraction of a second are forgiven
+// rather than caught up with a burst of ticks.
+void waitForNextTick(TickScheduler * const scheduler);
+
+// Ticks per second achieved since the scheduler was started.
+double achievedTickRate(const TickScheduler * const scheduler);
+
+// Standard deviation of how late ticks started, in seconds.
+double tickJitter(const TickScheduler * const scheduler);
+
+#endif
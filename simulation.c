@@ -0,0 +1,1003 @@
+#include "simulation.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "census.h"
+#include "decay.h"
+#include "gpu.h"
+#include "hashlife.h"
+#include "packed.h"
+#include "scheduler.h"
+#include "sparse.h"
+#include "temporal.h"
+#include "threadpool.h"
+
+// Initial change buffer capacity as a fraction of the board's tiles.  Soups
+// rarely flip more than this many tiles in a tick, and the buffer grows if
+// one does.
+#define INITIAL_CHANGE_FRACTION 8
+#define MIN_CHANGE_CAPACITY 64
+
+#define DEFAULT_HASHLIFE_MEMORY_LIMIT ((size_t) 1024 * 1024 * 1024)
+
+static bool initTileChangeBuffer(TileChangeBuffer * const buffer, const size_t capacity) {
+    buffer->count = 0;
+    buffer->capacity = capacity;
+    buffer->changes = (TileChange *) malloc(capacity * sizeof(TileChange));
+    if (buffer->changes == NULL) {
+        buffer->capacity = 0;
+        return false;
+    }
+    return true;
+}
+
+// Slow path of pushTileChange, kept out of line so the common case stays small.
+static void growTileChangeBuffer(TileChangeBuffer * const buffer) {
+    size_t capacity = buffer->capacity * 2;
+    TileChange *changes = (TileChange *) realloc(buffer->changes, capacity * sizeof(TileChange));
+    if (changes == NULL) {
+        exit(1);
+    }
+    buffer->changes = changes;
+    buffer->capacity = capacity;
+}
+
+static inline void pushTileChange(TileChangeBuffer * const buffer, const TileChange change) {
+    if (buffer->count == buffer->capacity) {
+        growTileChangeBuffer(buffer);
+    }
+    buffer->changes[buffer->count++] = change;
+}
+
+bool initSimulation(Simulation * const sim, Board board) {
+    sim->logicalBoard = board;
+    sim->tick = 0;
+    sim->recordChanges = true;
+    sim->engine = ENGINE_PACKED;
+    sim->threadPool = NULL;
+    sim->bandDiffs = NULL;
+    sim->temporalDepth = 0;
+    sim->temporal = NULL;
+    sim->trackActiveRegions = true;
+    sim->hashlife = NULL;
+    sim->hashlifeMemoryLimit = DEFAULT_HASHLIFE_MEMORY_LIMIT;
+    sim->stepLog2 = 0;
+    sim->sparse = NULL;
+    sim->gpu = NULL;
+    sim->gpuBehind = false;
+    sim->boardBehind = false;
+    sim->topology = TOPOLOGY_BOUNDED;
+    sim->viewRow = 0;
+    sim->viewCol = 0;
+    sim->rule = LIFE_RULE;
+    sim->census = NULL;
+    sim->decay = NULL;
+    sim->collectStats = false;
+    sim->lastTick = (TickStats) {0, 0, 0, 0, 0};
+    sim->cyclePeriod = 0;
+    initCycleDetector(&sim->cycles, 0);
+    sim->stateHash = 0;
+    sim->stateHashValid = false;
+    initRuleTable(&sim->ruleTable, sim->rule);
+    size_t capacity = (size_t) board.nrows * board.ncols / INITIAL_CHANGE_FRACTION;
+    if (capacity < MIN_CHANGE_CAPACITY) {
+        capacity = MIN_CHANGE_CAPACITY;
+    }
+    bool ok = initTileChangeBuffer(&sim->pendingChanges, capacity);
+    if (!initBoard(&sim->nextBoard, board.nrows, board.ncols)) {
+        ok = false;
+    }
+    if (!initActiveRegions(&sim->activeRegions, &board)) {
+        ok = false;
+    }
+    return ok;
+}
+
+static void destroyTemporal(Simulation * const sim) {
+    if (sim->temporal != NULL) {
+        destroyTemporalBlocking(sim->temporal);
+        free(sim->temporal);
+        sim->temporal = NULL;
+    }
+}
+
+static void destroyDecay(Simulation * const sim) {
+    if (sim->decay != NULL) {
+        destroyDecayPlanes(sim->decay);
+        free(sim->decay);
+        sim->decay = NULL;
+    }
+}
+
+void destroySimulation(Simulation * const sim) {
+    setSimulationThreads(sim, 1);
+    destroyTemporal(sim);
+    destroyDecay(sim);
+    setSimulationCensus(sim, false);
+    destroyHashlife(sim->hashlife);
+    sim->hashlife = NULL;
+    destroySparseUniverse(sim->sparse);
+    sim->sparse = NULL;
+    destroyGpuBoard(sim->gpu);
+    sim->gpu = NULL;
+    free(sim->pendingChanges.changes);
+    sim->pendingChanges.changes = NULL;
+    sim->pendingChanges.count = 0;
+    sim->pendingChanges.capacity = 0;
+    destroyBoard(&sim->logicalBoard);
+    destroyBoard(&sim->nextBoard);
+    destroyActiveRegions(&sim->activeRegions);
+    destroyCycleDetector(&sim->cycles);
+}
+
+// Marks the whole census to be recounted, if there is one.
+static void boardCensusChanged(Simulation * const sim) {
+    if (sim->census != NULL) {
+        censusBoardChanged(sim->census);
+    }
+}
+
+void restartSimulation(Simulation * const sim) {
+    sim->tick = 0;
+    sim->pendingChanges.count = 0;
+    destroyHashlife(sim->hashlife);
+    sim->hashlife = NULL;
+    destroySparseUniverse(sim->sparse);
+    sim->sparse = NULL;
+    sim->gpuBehind = true;
+    sim->boardBehind = false;
+    markAllChunksChanged(&sim->activeRegions);
+    boardCensusChanged(sim);
+    if (sim->decay != NULL) {
+        clearDecayPlanes(sim->decay);
+    }
+    sim->lastTick = (TickStats) {0, 0, 0, 0, 0};
+    sim->cyclePeriod = 0;
+    sim->stateHashValid = false;
+}
+
+// Whether ticks keep the hash of logicalBoard up to date, which is the state
+// of every engine looking for cycles but the unbounded ones.
+static inline bool hashingBoard(const Simulation * const sim) {
+    return sim->cycles.maxPeriod != 0 && !simulationIsUnbounded(sim);
+}
+
+// Ends the compute phase of the tick's stats, if it hasn't been ended already.
+static void endComputePhase(Simulation * const sim) {
+    if (sim->collectStats && !sim->computePhaseEnded) {
+        sim->lastTick.computeNanos = monotonicNanos() - sim->tickStartNanos;
+        sim->computePhaseEnded = true;
+    }
+}
+
+// Counts the births and deaths of a tick from its net effect.
+static void countFlips(Simulation * const sim, const long long aliveDelta, const unsigned long long flips) {
+    if (sim->collectStats) {
+        sim->lastTick.births = (uint64_t) (((long long) flips + aliveDelta) / 2);
+        sim->lastTick.deaths = (uint64_t) (((long long) flips - aliveDelta) / 2);
+    }
+}
+
+// Determines whether a tile should flip under the simulation's rule, and if it
+// should, pushes to the pendingChanges field of the sim parameter.
+static void handleTile(Simulation * const sim, const unsigned int row, const unsigned int col) {
+    TileState currentState = getTileState(&sim->logicalBoard, row, col);
+    unsigned int numAliveNeighbors = 0;
+    const int offsets[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+    // Neighbours beyond the edges come from the halo, so need no checks.
+    for (unsigned int i = 0; i < 8; ++i) {
+        int r = (int) row + offsets[i][0];
+        int c = (int) col + offsets[i][1];
+        numAliveNeighbors += getHaloTileState(&sim->logicalBoard, r, c) == ALIVE;
+    }
+
+    TileChange change;
+    change.point.row = row;
+    change.point.col = col;
+
+    if (currentState == ALIVE && !((sim->rule.survive >> numAliveNeighbors) & 1)) {
+        change.newState = DEAD;
+        pushTileChange(&sim->pendingChanges, change);
+    } else if (currentState == DEAD && ((sim->rule.birth >> numAliveNeighbors) & 1)) {
+        change.newState = ALIVE;
+        pushTileChange(&sim->pendingChanges, change);
+    }
+}
+
+// Performs the changes in the pendingChanges buffer.  The buffer is left
+// intact so the changes can be read back until the next tick.  If the board
+// is being hashed, the hash follows each change of a word.
+static void doChanges(Simulation * const sim) {
+    const TileChangeBuffer * const buffer = &sim->pendingChanges;
+    Board * const board = &sim->logicalBoard;
+    const bool hashing = hashingBoard(sim);
+    for (size_t i = 0; i < buffer->count; ++i) {
+        const TileChange change = buffer->changes[i];
+        const unsigned int w = change.point.col / BOARD_WORD_BITS;
+        const BoardWord * const word = &getBoardRow(board, change.point.row)[w];
+        const BoardWord before = *word;
+        setTileState(board, change.newState, change.point.row, change.point.col);
+        if (hashing) {
+            const uint64_t position = boardWordPosition(board, change.point.row, w);
+            sim->stateHash ^= hashBoardWord(position, before) ^ hashBoardWord(position, *word);
+        }
+    }
+}
+
+// First scan each tile for needed changes, and then go back and perform
+// the necessary changes.
+static bool stepReference(Simulation * const sim) {
+    for (unsigned int row = 0; row < sim->logicalBoard.nrows; ++row) {
+        for (unsigned int col = 0; col < sim->logicalBoard.ncols; ++col) {
+            handleTile(sim, row, col);
+        }
+    }
+    endComputePhase(sim);
+    bool anyChanged = sim->pendingChanges.count != 0;
+    clearBoardPadding(&sim->logicalBoard);
+    const unsigned int nalive = sim->logicalBoard.nalive;
+    if (anyChanged) {
+        doChanges(sim);
+    }
+    countFlips(sim, (long long) sim->logicalBoard.nalive - nalive, sim->pendingChanges.count);
+    // The board was changed in place, so nextBoard is out of date everywhere.
+    markAllChunksChanged(&sim->activeRegions);
+    return anyChanged;
+}
+
+// Net effect on the board of a range of rows, found by diffing them.
+typedef struct RowsDiff {
+    long long aliveDelta;
+    // Tiles that changed state.
+    unsigned long long flips;
+    // The change in the hash of the board, if it was asked for.
+    uint64_t hashDelta;
+    bool anyChanged;
+} RowsDiff;
+
+static void addRowsDiff(RowsDiff * const total, const RowsDiff diff) {
+    total->aliveDelta += diff.aliveDelta;
+    total->flips += diff.flips;
+    total->hashDelta ^= diff.hashDelta;
+    total->anyChanged |= diff.anyChanged;
+}
+
+// Compares words [wordBegin, wordEnd) of rows [rowBegin, rowEnd) of the
+// current and next generations.  If changes is non-NULL every differing tile
+// is pushed to it.  If changedWords is non-NULL, changedWords[w - wordBegin]
+// is set for every word column w with a difference in any of the rows.  With
+// hashWords set, the change to the board's hash is found too.
+// current's padding may still hold the halo of a torus, so is ignored.
+static RowsDiff diffRect(const Board * const current, const Board * const next,
+                         const unsigned int rowBegin, const unsigned int rowEnd,
+                         const unsigned int wordBegin, const unsigned int wordEnd,
+                         TileChangeBuffer * const changes, uint8_t * const changedWords, const bool hashWords) {
+    RowsDiff result = {0, 0, 0, false};
+    const unsigned int lastWord = current->wordsPerRow - 1;
+    const BoardWord mask = lastWordMask(current);
+    for (unsigned int row = rowBegin; row < rowEnd; ++row) {
+        const BoardWord * const before = getBoardRow(current, row);
+        const BoardWord * const after = getBoardRow(next, row);
+        for (unsigned int w = wordBegin; w < wordEnd; ++w) {
+            const BoardWord previous = w == lastWord ? before[w] & mask : before[w];
+            BoardWord diff = previous ^ after[w];
+            if (diff == 0) {
+                continue;
+            }
+            result.anyChanged = true;
+            result.aliveDelta += (long long) popcountWord(after[w]) - popcountWord(previous);
+            result.flips += popcountWord(diff);
+            if (hashWords) {
+                const uint64_t position = boardWordPosition(current, row, w);
+                result.hashDelta ^= hashBoardWord(position, previous) ^ hashBoardWord(position, after[w]);
+            }
+            if (changedWords != NULL) {
+                changedWords[w - wordBegin] = 1;
+            }
+            while (changes != NULL && diff != 0) {
+                const unsigned int bit = lowestBitIndex(diff);
+                TileChange change;
+                change.point.row = row;
+                change.point.col = w * BOARD_WORD_BITS + bit;
+                change.newState = (TileState) ((after[w] >> bit) & 1);
+                pushTileChange(changes, change);
+                diff &= diff - 1;
+            }
+        }
+    }
+    return result;
+}
+
+static RowsDiff diffRows(const Board * const current, const Board * const next,
+                         const unsigned int rowBegin, const unsigned int rowEnd,
+                         TileChangeBuffer * const changes, const bool hashWords) {
+    return diffRect(current, next, rowBegin, rowEnd, 0, current->wordsPerRow, changes, NULL, hashWords);
+}
+
+// Makes nextBoard the logical board.  The outgoing board's padding is cleaned
+// up after the halo, so that whatever nextBoard doesn't rewrite next tick is
+// left clean too.
+static bool commitNextBoard(Simulation * const sim, const RowsDiff diff) {
+    endComputePhase(sim);
+    countFlips(sim, diff.aliveDelta, diff.flips);
+    sim->stateHash ^= diff.hashDelta;
+    Board * const current = &sim->logicalBoard;
+    Board * const next = &sim->nextBoard;
+    if (sim->topology == TOPOLOGY_TORUS) {
+        clearBoardPadding(current);
+    }
+    next->nalive = (unsigned int) (current->nalive + diff.aliveDelta);
+    Board swap = *current;
+    *current = *next;
+    *next = swap;
+    return diff.anyChanged;
+}
+
+static TileChangeBuffer *changesToRecord(Simulation * const sim) {
+    return sim->recordChanges ? &sim->pendingChanges : NULL;
+}
+
+// Under a Generations rule the board is still changing while any tile is
+// dying, whether or not any live tile changed.
+static bool stepPacked(Simulation * const sim) {
+    const unsigned int nrows = sim->logicalBoard.nrows;
+    stepPackedRows(&sim->rule, &sim->logicalBoard, &sim->nextBoard, 0, nrows);
+    const bool decaying = sim->decay != NULL
+            && stepDecayRows(sim->decay, &sim->logicalBoard, &sim->nextBoard, 0, nrows);
+    markAllChunksChanged(&sim->activeRegions);
+    endComputePhase(sim);
+    return commitNextBoard(sim, diffRows(&sim->logicalBoard, &sim->nextBoard, 0, nrows, changesToRecord(sim),
+                                         hashingBoard(sim))) || decaying;
+}
+
+// First row of a worker's horizontal band of a board of nrows.
+static inline unsigned int bandBegin(const unsigned int nrows, const unsigned int worker,
+                                     const unsigned int nworkers) {
+    return (unsigned int) ((unsigned long long) nrows * worker / nworkers);
+}
+
+// Steps one horizontal band of the board.  Bands only read their neighbours'
+// rows of the current generation, so they need no synchronisation until the
+// whole generation is done.  Unless changes are being recorded, which has to
+// happen in row order into the one buffer, the band is diffed here too so
+// that nothing is left to do serially.  So are the band's dying tiles, which
+// count as changes.
+static void stepBand(void *context, const unsigned int worker, const unsigned int nworkers) {
+    Simulation * const sim = (Simulation *) context;
+    const unsigned int rowBegin = bandBegin(sim->logicalBoard.nrows, worker, nworkers);
+    const unsigned int rowEnd = bandBegin(sim->logicalBoard.nrows, worker + 1, nworkers);
+    stepPackedRows(&sim->rule, &sim->logicalBoard, &sim->nextBoard, rowBegin, rowEnd);
+    const bool decaying = sim->decay != NULL
+            && stepDecayRows(sim->decay, &sim->logicalBoard, &sim->nextBoard, rowBegin, rowEnd);
+    if (!sim->recordChanges) {
+        sim->bandDiffs[worker] = diffRows(&sim->logicalBoard, &sim->nextBoard, rowBegin, rowEnd, NULL,
+                                          hashingBoard(sim));
+    } else {
+        sim->bandDiffs[worker] = (RowsDiff) {0, 0, 0, false};
+    }
+    sim->bandDiffs[worker].anyChanged |= decaying;
+}
+
+static bool stepLut(Simulation * const sim) {
+    const unsigned int nrows = sim->logicalBoard.nrows;
+    stepLutRows(&sim->ruleTable, &sim->logicalBoard, &sim->nextBoard, 0, nrows);
+    markAllChunksChanged(&sim->activeRegions);
+    endComputePhase(sim);
+    return commitNextBoard(sim, diffRows(&sim->logicalBoard, &sim->nextBoard, 0, nrows, changesToRecord(sim),
+                                         hashingBoard(sim)));
+}
+
+// Without active region tracking the whole of nextBoard is rewritten each
+// tick, so the tracking state is simply kept saturated.
+static bool stepPackedThreaded(Simulation * const sim) {
+    runOnThreadPool(sim->threadPool, stepBand, sim);
+    markAllChunksChanged(&sim->activeRegions);
+    endComputePhase(sim);
+    RowsDiff total = {0, 0, 0, false};
+    for (unsigned int i = 0; i < threadPoolSize(sim->threadPool); ++i) {
+        addRowsDiff(&total, sim->bandDiffs[i]);
+    }
+    if (sim->recordChanges) {
+        // The bands only found whether any of them is decaying.
+        const bool decaying = total.anyChanged;
+        return commitNextBoard(sim, diffRows(&sim->logicalBoard, &sim->nextBoard, 0, sim->logicalBoard.nrows,
+                                             &sim->pendingChanges, hashingBoard(sim))) || decaying;
+    }
+    return commitNextBoard(sim, total);
+}
+
+// Sizes the scratch boards of temporal blocking for the current depth and
+// threads, if they have changed since the last blocked tick.
+static void ensureTemporalBlocking(Simulation * const sim) {
+    const unsigned int nworkers = simulationThreads(sim);
+    if (sim->temporal != NULL && sim->temporal->depth == sim->temporalDepth
+            && sim->temporal->nworkers == nworkers) {
+        return;
+    }
+    destroyTemporal(sim);
+    sim->temporal = (TemporalBlocking *) malloc(sizeof(TemporalBlocking));
+    if (sim->temporal == NULL
+            || !initTemporalBlocking(sim->temporal, &sim->logicalBoard, sim->temporalDepth, nworkers)) {
+        exit(1);
+    }
+}
+
+// Sizes the age planes for the rule's states, on the first tick under a
+// Generations rule.
+static void ensureDecayPlanes(Simulation * const sim) {
+    if (sim->decay != NULL) {
+        return;
+    }
+    sim->decay = (DecayPlanes *) malloc(sizeof(DecayPlanes));
+    if (sim->decay == NULL || !initDecayPlanes(sim->decay, &sim->logicalBoard, sim->rule.states)) {
+        exit(1);
+    }
+}
+
+static RowsDiff temporalRowsDiff(const TemporalDiff diff) {
+    return (RowsDiff) {diff.aliveDelta, diff.flips, 0, diff.anyChanged};
+}
+
+// A blocked tick, handed to the workers of the thread pool.
+typedef struct TemporalTask {
+    Simulation *sim;
+    unsigned int generations;
+} TemporalTask;
+
+static void stepTemporalShare(void *context, const unsigned int worker, const unsigned int nworkers) {
+    const TemporalTask * const task = (const TemporalTask *) context;
+    Simulation * const sim = task->sim;
+    const TemporalDiff diff = stepTemporalTiles(sim->temporal, &sim->rule, &sim->logicalBoard, &sim->nextBoard,
+                                                sim->topology, task->generations, worker, nworkers);
+    sim->bandDiffs[worker] = temporalRowsDiff(diff);
+}
+
+// Steps generations at once with temporal blocking.  The diff of the tiles is
+// only of the tick's net effect, which is all the commit needs unless changes
+// are recorded, when they are found by diffing like a threaded sweep's.
+// Whether the board settled is only known from the tiles.
+static bool stepPackedTemporal(Simulation * const sim, const unsigned int generations) {
+    ensureTemporalBlocking(sim);
+    RowsDiff total = {0, 0, 0, false};
+    if (sim->threadPool != NULL) {
+        TemporalTask task = {sim, generations};
+        runOnThreadPool(sim->threadPool, stepTemporalShare, &task);
+        for (unsigned int i = 0; i < threadPoolSize(sim->threadPool); ++i) {
+            addRowsDiff(&total, sim->bandDiffs[i]);
+        }
+    } else {
+        total = temporalRowsDiff(stepTemporalTiles(sim->temporal, &sim->rule, &sim->logicalBoard,
+                                                   &sim->nextBoard, sim->topology, generations, 0, 1));
+    }
+    markAllChunksChanged(&sim->activeRegions);
+    // The hash isn't followed across a blocked tick.
+    sim->stateHashValid = false;
+    endComputePhase(sim);
+    if (sim->recordChanges) {
+        const bool anyChanged = total.anyChanged;
+        total = diffRows(&sim->logicalBoard, &sim->nextBoard, 0, sim->logicalBoard.nrows, &sim->pendingChanges,
+                         false);
+        total.anyChanged = anyChanged;
+    }
+    return commitNextBoard(sim, total);
+}
+
+// Steps one run of active chunks and records which of them changed.
+static RowsDiff stepChunkRun(Simulation * const sim, const ChunkRun * const run,
+                             TileChangeBuffer * const changes) {
+    ActiveRegions * const regions = &sim->activeRegions;
+    const unsigned int rowBegin = run->chunkRow * ACTIVE_CHUNK_ROWS;
+    const unsigned int rowEnd = rowBegin + ACTIVE_CHUNK_ROWS < sim->logicalBoard.nrows
+            ? rowBegin + ACTIVE_CHUNK_ROWS : sim->logicalBoard.nrows;
+    uint8_t * const changed = regions->changed + (size_t) run->chunkRow * regions->nchunkCols
+            + run->chunkColBegin;
+    memset(changed, 0, run->chunkColEnd - run->chunkColBegin);
+
+    stepPackedRect(&sim->rule, &sim->logicalBoard, &sim->nextBoard, rowBegin, rowEnd, run->chunkColBegin,
+                   run->chunkColEnd);
+    return diffRect(&sim->logicalBoard, &sim->nextBoard, rowBegin, rowEnd, run->chunkColBegin, run->chunkColEnd,
+                    changes, changed, hashingBoard(sim));
+}
+
+// Steps a worker's share of the chunk runs.  Every run is stepped and diffed
+// by exactly one worker, so the changed flags need no synchronisation either.
+static void stepChunkRuns(void *context, const unsigned int worker, const unsigned int nworkers) {
+    Simulation * const sim = (Simulation *) context;
+    const size_t nruns = sim->activeRegions.nruns;
+    const size_t runBegin = nruns * worker / nworkers;
+    const size_t runEnd = nruns * (worker + 1) / nworkers;
+    RowsDiff total = {0, 0, 0, false};
+    for (size_t i = runBegin; i < runEnd; ++i) {
+        addRowsDiff(&total, stepChunkRun(sim, &sim->activeRegions.runs[i], NULL));
+    }
+    sim->bandDiffs[worker] = total;
+}
+
+// Steps only the chunks that changed last tick and their neighbours.
+static bool stepPackedActive(Simulation * const sim) {
+    buildChunkRuns(&sim->activeRegions, sim->topology == TOPOLOGY_TORUS);
+    const size_t nruns = sim->activeRegions.nruns;
+    RowsDiff total = {0, 0, 0, false};
+
+    if (sim->threadPool != NULL && !sim->recordChanges) {
+        runOnThreadPool(sim->threadPool, stepChunkRuns, sim);
+        for (unsigned int i = 0; i < threadPoolSize(sim->threadPool); ++i) {
+            addRowsDiff(&total, sim->bandDiffs[i]);
+        }
+        return commitNextBoard(sim, total);
+    }
+
+    for (size_t i = 0; i < nruns; ++i) {
+        addRowsDiff(&total, stepChunkRun(sim, &sim->activeRegions.runs[i], changesToRecord(sim)));
+    }
+    return commitNextBoard(sim, total);
+}
+
+// Builds the universe of an unbounded engine from the board, its window, if
+// it doesn't exist yet.  Until then the board is the whole universe.
+static void ensureUniverse(Simulation * const sim) {
+    if (sim->engine == ENGINE_HASHLIFE && sim->hashlife == NULL) {
+        sim->hashlife = createHashlife(sim->hashlifeMemoryLimit, sim->rule);
+        if (sim->hashlife == NULL) {
+            exit(1);
+        }
+        hashlifeLoadBoard(sim->hashlife, &sim->logicalBoard, sim->viewRow, sim->viewCol);
+    } else if (sim->engine == ENGINE_SPARSE && sim->sparse == NULL) {
+        sim->sparse = createSparseUniverse(sim->rule);
+        if (sim->sparse == NULL) {
+            exit(1);
+        }
+        sparseLoadBoard(sim->sparse, &sim->logicalBoard, sim->viewRow, sim->viewCol);
+    }
+}
+
+// Copies the window of the universe at the view into board.
+static void exportUniverse(const Simulation * const sim, Board * const board) {
+    if (sim->engine == ENGINE_HASHLIFE) {
+        hashlifeExportBoard(sim->hashlife, board, sim->viewRow, sim->viewCol);
+    } else {
+        sparseExportBoard(sim->sparse, board, sim->viewRow, sim->viewCol);
+    }
+}
+
+// Brings the board up to date with the universe after it has been stepped.
+static void commitUniverse(Simulation * const sim) {
+    endComputePhase(sim);
+    exportUniverse(sim, &sim->nextBoard);
+    markAllChunksChanged(&sim->activeRegions);
+    RowsDiff diff = diffRows(&sim->logicalBoard, &sim->nextBoard, 0, sim->logicalBoard.nrows,
+                             changesToRecord(sim), false);
+    // The exported board's population is already right, so only swap.
+    diff.aliveDelta = (long long) sim->nextBoard.nalive - sim->logicalBoard.nalive;
+    commitNextBoard(sim, diff);
+}
+
+// Advances the Hashlife universe by 2^log2Generations.  Like the sparse
+// universe's, the tick has changed something if anything in the universe
+// changed, so a pattern that has left the window still counts as running.
+static bool stepHashlife(Simulation * const sim, const unsigned int log2Generations) {
+    ensureUniverse(sim);
+    const bool anyChanged = hashlifeStep(sim->hashlife, log2Generations);
+    commitUniverse(sim);
+    return anyChanged;
+}
+
+// The sparse universe knows whether anything changed even outside the window,
+// so a pattern that has left the window still counts as running.
+static bool stepSparse(Simulation * const sim) {
+    ensureUniverse(sim);
+    const bool anyChanged = sparseStep(sim->sparse);
+    commitUniverse(sim);
+    return anyChanged;
+}
+
+// Steps the device's copy of the board.  Only the tick's totals come back,
+// unless changes are being recorded, when the new generation is exported and
+// diffed like an unbounded universe's window.  The device can't follow edits
+// a tile at a time, so after any it is reloaded from logicalBoard whole.
+static bool stepGpu(Simulation * const sim, const bool hashing) {
+    if (sim->gpu == NULL) {
+        sim->gpu = createGpuBoard(&sim->logicalBoard);
+        if (sim->gpu == NULL) {
+            exit(1);
+        }
+    } else if (sim->gpuBehind && !gpuLoadBoard(sim->gpu, &sim->logicalBoard)) {
+        exit(1);
+    }
+    sim->gpuBehind = false;
+    GpuTick tick;
+    if (!gpuStep(sim->gpu, sim->rule, sim->topology, hashing, &tick)) {
+        exit(1);
+    }
+    if (hashing) {
+        sim->stateHash = tick.hash;
+    }
+
+    const long long aliveDelta = (long long) tick.population - sim->logicalBoard.nalive;
+    if (!sim->recordChanges) {
+        endComputePhase(sim);
+        countFlips(sim, aliveDelta, tick.flips);
+        sim->logicalBoard.nalive = tick.population;
+        sim->boardBehind = true;
+        return tick.flips != 0;
+    }
+    endComputePhase(sim);
+    syncSimulationBoard(sim);
+    if (!gpuExportBoard(sim->gpu, &sim->nextBoard)) {
+        exit(1);
+    }
+    RowsDiff diff = diffRows(&sim->logicalBoard, &sim->nextBoard, 0, sim->logicalBoard.nrows,
+                             &sim->pendingChanges, false);
+    diff.aliveDelta = aliveDelta;
+    return commitNextBoard(sim, diff);
+}
+
+void syncSimulationBoard(Simulation * const sim) {
+    if (sim->boardBehind && !gpuExportBoard(sim->gpu, &sim->logicalBoard)) {
+        exit(1);
+    }
+    sim->boardBehind = false;
+}
+
+void simulationTileEdited(Simulation * const sim, const unsigned int row, const unsigned int col) {
+    markTileChanged(&sim->activeRegions, row, col);
+    if (sim->census != NULL) {
+        censusTileChanged(sim->census, row, col);
+    }
+    sim->stateHashValid = false;
+    sim->gpuBehind = true;
+    if (sim->decay != NULL) {
+        clearTileDecay(sim->decay, row, col);
+    }
+    const TileState state = getTileState(&sim->logicalBoard, row, col);
+    if (sim->hashlife != NULL) {
+        hashlifeSetTile(sim->hashlife, sim->viewRow + row, sim->viewCol + col, state);
+    }
+    if (sim->sparse != NULL) {
+        sparseSetTile(sim->sparse, sim->viewRow + row, sim->viewCol + col, state);
+    }
+}
+
+// The bounded engines' bookkeeping is by chunk, so a chunk of the rectangle
+// is marked once rather than for each of its tiles.  An unbounded universe's
+// tiles are still set one at a time.
+void simulationRectEdited(Simulation * const sim, const unsigned int rowBegin, const unsigned int rowEnd,
+                          const unsigned int colBegin, const unsigned int colEnd) {
+    if (rowBegin >= rowEnd || colBegin >= colEnd) {
+        return;
+    }
+    sim->stateHashValid = false;
+    sim->gpuBehind = true;
+    if (sim->decay != NULL) {
+        clearDecayRect(sim->decay, rowBegin, rowEnd, colBegin, colEnd);
+    }
+    for (unsigned int row = rowBegin; row < rowEnd; row = (row / ACTIVE_CHUNK_ROWS + 1) * ACTIVE_CHUNK_ROWS) {
+        for (unsigned int col = colBegin; col < colEnd; col = (col / BOARD_WORD_BITS + 1) * BOARD_WORD_BITS) {
+            markTileChanged(&sim->activeRegions, row, col);
+            if (sim->census != NULL) {
+                censusTileChanged(sim->census, row, col);
+            }
+        }
+    }
+    if (sim->hashlife == NULL && sim->sparse == NULL) {
+        return;
+    }
+    for (unsigned int row = rowBegin; row < rowEnd; ++row) {
+        for (unsigned int col = colBegin; col < colEnd; ++col) {
+            simulationTileEdited(sim, row, col);
+        }
+    }
+}
+
+// An unbounded universe only has its window replaced, a tile at a time.
+void simulationBoardEdited(Simulation * const sim) {
+    markAllChunksChanged(&sim->activeRegions);
+    boardCensusChanged(sim);
+    sim->stateHashValid = false;
+    sim->gpuBehind = true;
+    if (sim->decay != NULL) {
+        clearDecayPlanes(sim->decay);
+    }
+    if (sim->hashlife == NULL && sim->sparse == NULL) {
+        return;
+    }
+    for (unsigned int row = 0; row < sim->logicalBoard.nrows; ++row) {
+        for (unsigned int col = 0; col < sim->logicalBoard.ncols; ++col) {
+            simulationTileEdited(sim, row, col);
+        }
+    }
+}
+
+bool simulationIsUnbounded(const Simulation * const sim) {
+    return sim->engine == ENGINE_HASHLIFE || sim->engine == ENGINE_SPARSE;
+}
+
+void setSimulationView(Simulation * const sim, const int64_t row, const int64_t col) {
+    if (!simulationIsUnbounded(sim)) {
+        return;
+    }
+    ensureUniverse(sim);
+    sim->viewRow = row;
+    sim->viewCol = col;
+    exportUniverse(sim, &sim->logicalBoard);
+    markAllChunksChanged(&sim->activeRegions);
+    boardCensusChanged(sim);
+    sim->pendingChanges.count = 0;
+}
+
+unsigned int simulationTileState(const Simulation * const sim, const unsigned int row, const unsigned int col) {
+    if (sim->decay != NULL) {
+        return decayTileState(sim->decay, &sim->logicalBoard, row, col);
+    }
+    return getTileState(&sim->logicalBoard, row, col) == ALIVE ? 1 : 0;
+}
+
+bool setSimulationRule(Simulation * const sim, const LifeRule rule) {
+    if ((simulationIsUnbounded(sim) && ruleBirthsFromNothing(rule))
+            || (ruleHasDecay(rule) && sim->engine != ENGINE_PACKED)) {
+        return false;
+    }
+    // Dying tiles keep their ages under a rule with as many states, and
+    // otherwise die.
+    if (rule.states != sim->rule.states) {
+        destroyDecay(sim);
+    }
+    sim->rule = rule;
+    initRuleTable(&sim->ruleTable, rule);
+    // Every tile's next state may now differ, and earlier states may no
+    // longer lead to the same ones.
+    markAllChunksChanged(&sim->activeRegions);
+    sim->stateHashValid = false;
+    if (sim->hashlife != NULL) {
+        hashlifeSetRule(sim->hashlife, rule);
+    }
+    if (sim->sparse != NULL) {
+        sparseSetRule(sim->sparse, rule);
+    }
+    return true;
+}
+
+bool setSimulationCensus(Simulation * const sim, const bool enabled) {
+    if (!enabled || sim->census != NULL) {
+        if (!enabled && sim->census != NULL) {
+            destroyBoardCensus(sim->census);
+            free(sim->census);
+            sim->census = NULL;
+        }
+        return true;
+    }
+    sim->census = (BoardCensus *) malloc(sizeof(BoardCensus));
+    syncSimulationBoard(sim);
+    if (sim->census == NULL || !initBoardCensus(sim->census, &sim->logicalBoard)) {
+        free(sim->census);
+        sim->census = NULL;
+        return false;
+    }
+    return true;
+}
+
+const BoardCensus *simulationCensus(Simulation * const sim) {
+    if (sim->census == NULL) {
+        return NULL;
+    }
+    syncSimulationBoard(sim);
+    updateBoardCensus(sim->census, &sim->logicalBoard);
+    return sim->census;
+}
+
+// Marks the chunks an active tick found changed for the census.  Only chunks
+// in the tick's runs were stepped, and so could have changed.
+static void noteChangedChunks(Simulation * const sim) {
+    const ActiveRegions * const regions = &sim->activeRegions;
+    for (size_t i = 0; i < regions->nruns; ++i) {
+        const ChunkRun * const run = &regions->runs[i];
+        const size_t rowStart = (size_t) run->chunkRow * regions->nchunkCols;
+        for (unsigned int chunkCol = run->chunkColBegin; chunkCol < run->chunkColEnd; ++chunkCol) {
+            if (regions->changed[rowStart + chunkCol]) {
+                censusChunkChanged(sim->census, rowStart + chunkCol);
+            }
+        }
+    }
+}
+
+void setSimulationTopology(Simulation * const sim, const Topology topology) {
+    sim->topology = topology;
+    markAllChunksChanged(&sim->activeRegions);
+    sim->stateHashValid = false;
+}
+
+// A board being moved into a fresh one by the workers of the thread pool.
+typedef struct PlacementTask {
+    const Board *from;
+    Board *to;
+} PlacementTask;
+
+static void placeBand(void *context, const unsigned int worker, const unsigned int nworkers) {
+    const PlacementTask * const task = (const PlacementTask *) context;
+    const unsigned int nrows = task->from->nrows;
+    copyBoardRows(task->to, task->from, bandBegin(nrows, worker, nworkers),
+                  bandBegin(nrows, worker + 1, nworkers));
+}
+
+// Moves a mapped board into a fresh mapping by bands, so that each band's
+// pages are first touched by, and so placed on the NUMA node of, the worker
+// that steps that band.  Whatever the main thread wrote while loading the
+// board has already placed its pages.  Keeps the board where it is if the
+// new one can't be allocated.
+static void placeBoardBands(Simulation * const sim, Board * const board) {
+    if (board->mappedBytes == 0) {
+        return;
+    }
+    Board placed;
+    if (!initBoard(&placed, board->nrows, board->ncols)) {
+        return;
+    }
+    PlacementTask task = {board, &placed};
+    runOnThreadPool(sim->threadPool, placeBand, &task);
+    placed.nalive = board->nalive;
+    destroyBoard(board);
+    *board = placed;
+}
+
+bool setSimulationThreads(Simulation * const sim, const unsigned int nthreads) {
+    destroyThreadPool(sim->threadPool);
+    sim->threadPool = NULL;
+    free(sim->bandDiffs);
+    sim->bandDiffs = NULL;
+    if (nthreads <= 1) {
+        return true;
+    }
+
+    sim->threadPool = createThreadPool(nthreads);
+    sim->bandDiffs = (RowsDiff *) calloc(nthreads, sizeof(RowsDiff));
+    if (sim->threadPool == NULL || sim->bandDiffs == NULL) {
+        setSimulationThreads(sim, 1);
+        return false;
+    }
+    placeBoardBands(sim, &sim->logicalBoard);
+    placeBoardBands(sim, &sim->nextBoard);
+    return true;
+}
+
+unsigned int simulationThreads(const Simulation * const sim) {
+    return sim->threadPool != NULL ? threadPoolSize(sim->threadPool) : 1;
+}
+
+bool setSimulationCycleLimit(Simulation * const sim, const unsigned int maxPeriod) {
+    destroyCycleDetector(&sim->cycles);
+    sim->stateHashValid = false;
+    sim->cyclePeriod = 0;
+    return initCycleDetector(&sim->cycles, maxPeriod);
+}
+
+// Hashes the state from scratch and starts a new history from it, after
+// detection was turned on or the state was edited.
+static void restartCycleDetection(Simulation * const sim) {
+    if (sim->engine == ENGINE_SPARSE) {
+        ensureUniverse(sim);
+        sim->stateHash = sparseHash(sim->sparse);
+    } else {
+        syncSimulationBoard(sim);
+        sim->stateHash = hashBoard(&sim->logicalBoard);
+    }
+    resetCycleDetector(&sim->cycles);
+    recordBoardHash(&sim->cycles, sim->stateHash);
+    sim->stateHashValid = true;
+}
+
+// Whether ticks are temporally blocked, several generations at a time.
+// Generations rules are always stepped a generation at a time.
+static inline bool blockingTime(const Simulation * const sim) {
+    return sim->engine == ENGINE_PACKED && sim->temporalDepth > 1 && !ruleHasDecay(sim->rule);
+}
+
+bool stepSimulationUpTo(Simulation * const sim, const uint64_t maxGenerations) {
+    sim->pendingChanges.count = 0;
+    if (sim->collectStats) {
+        sim->lastTick = (TickStats) {1, 0, 0, 0, 0};
+        sim->computePhaseEnded = false;
+        sim->tickStartNanos = monotonicNanos();
+    }
+    // The board hash leaves out the ages of dying tiles, so can't tell when a
+    // Generations rule cycles.
+    const bool detectCycles = sim->cycles.maxPeriod != 0 && sim->engine != ENGINE_HASHLIFE && !blockingTime(sim)
+            && !ruleHasDecay(sim->rule);
+    if (detectCycles && !sim->stateHashValid) {
+        restartCycleDetection(sim);
+    }
+    if (!simulationIsUnbounded(sim) && sim->engine != ENGINE_GPU) {
+        fillBoardHalo(&sim->logicalBoard, sim->topology);
+    }
+    uint64_t generations = 1;
+    bool anyChanged;
+    bool steppedActive = false;
+    switch (sim->engine) {
+    case ENGINE_REFERENCE:
+        anyChanged = stepReference(sim);
+        break;
+    case ENGINE_SCALAR:
+        anyChanged = stepLut(sim);
+        break;
+    case ENGINE_PACKED:
+        if (ruleHasDecay(sim->rule)) {
+            // Active regions can't skip dying tiles, which age without
+            // neighbours changing.
+            ensureDecayPlanes(sim);
+            anyChanged = sim->threadPool != NULL ? stepPackedThreaded(sim) : stepPacked(sim);
+        } else if (blockingTime(sim) && maxGenerations > 1) {
+            generations = sim->temporalDepth < maxGenerations ? sim->temporalDepth : maxGenerations;
+            anyChanged = stepPackedTemporal(sim, (unsigned int) generations);
+        } else if (sim->trackActiveRegions) {
+            anyChanged = stepPackedActive(sim);
+            steppedActive = true;
+        } else if (sim->threadPool != NULL) {
+            anyChanged = stepPackedThreaded(sim);
+        } else {
+            anyChanged = stepPacked(sim);
+        }
+        break;
+    case ENGINE_HASHLIFE: {
+        unsigned int log2Generations = sim->stepLog2;
+        while (log2Generations > 0 && ((uint64_t) 1 << log2Generations) > maxGenerations) {
+            --log2Generations;
+        }
+        generations = (uint64_t) 1 << log2Generations;
+        anyChanged = stepHashlife(sim, log2Generations);
+        break;
+    }
+    case ENGINE_SPARSE:
+        anyChanged = stepSparse(sim);
+        break;
+    case ENGINE_GPU:
+        anyChanged = stepGpu(sim, detectCycles);
+        break;
+    default:
+        exit(1);
+    }
+    sim->tick += generations;
+    if (sim->census != NULL && steppedActive) {
+        noteChangedChunks(sim);
+    } else {
+        boardCensusChanged(sim);
+    }
+    if (detectCycles) {
+        if (sim->engine == ENGINE_SPARSE) {
+            sim->stateHash = sparseHash(sim->sparse);
+        }
+        sim->cyclePeriod = recordBoardHash(&sim->cycles, sim->stateHash);
+    } else {
+        sim->cyclePeriod = 0;
+    }
+    if (sim->collectStats) {
+        sim->lastTick.commitNanos = monotonicNanos() - sim->tickStartNanos - sim->lastTick.computeNanos;
+    }
+    return anyChanged;
+}
+
+bool stepSimulation(Simulation * const sim) {
+    return stepSimulationUpTo(sim, UINT64_MAX);
+}
+
+static const char * const engineNames[] = {
+    [ENGINE_REFERENCE] = "reference",
+    [ENGINE_SCALAR] = "scalar",
+    [ENGINE_PACKED] = "packed",
+    [ENGINE_HASHLIFE] = "hashlife",
+    [ENGINE_SPARSE] = "sparse",
+    [ENGINE_GPU] = "gpu",
+};
+
+bool parseStepEngine(const char * const name, StepEngine * const engine) {
+    for (size_t i = 0; i < sizeof(engineNames) / sizeof(engineNames[0]); ++i) {
+        if (strcmp(name, engineNames[i]) == 0) {
+            *engine = (StepEngine) i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *stepEngineName(const StepEngine engine) {
+    return engineNames[engine];
+}
@@ -0,0 +1,244 @@
+#ifndef CONWAY_SIMULATION_H
+#define CONWAY_SIMULATION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "active.h"
+#include "board.h"
+#include "cycle.h"
+#include "lut.h"
+#include "rule.h"
+#include "stats.h"
+
+// TileChanges are stored in the simulation pass of each tick.
+// This allows for only the single linear pass, and then only the changes
+// made where necessary.
+typedef struct TileChange {
+    Point point;
+    TileState newState;
+} TileChange;
+
+// Contiguous storage for the TileChanges of a tick.  It is allocated once,
+// reused by every tick and only ever grows, so a steady state simulation makes
+// no heap allocations.
+typedef struct TileChangeBuffer {
+    TileChange *changes;
+    size_t count;
+    size_t capacity;
+} TileChangeBuffer;
+
+// The available implementations of a tick.  All of them produce identical
+// generations, except that the sparse and Hashlife universes don't stop at the
+// edges of the board.
+typedef enum StepEngine {
+    // Per-tile evaluation with handleTile(), the reference implementation.
+    ENGINE_REFERENCE,
+    // Per-tile evaluation with a precomputed table of every 3x3
+    // neighbourhood, one lookup per tile.
+    ENGINE_SCALAR,
+    // Word-parallel evaluation of the bit-packed board, 64 tiles at a time.
+    // Split into horizontal bands over a thread pool if setSimulationThreads()
+    // asked for more than one thread.  Unless trackActiveRegions is cleared,
+    // only the parts of the board near last tick's changes are recomputed.
+    ENGINE_PACKED,
+    // Gosper's Hashlife over an unbounded universe, of which logicalBoard is
+    // a window.  Each tick advances 2^stepLog2 generations.
+    ENGINE_HASHLIFE,
+    // An unbounded universe of tiles allocated around the live population,
+    // of which logicalBoard is a window.
+    ENGINE_SPARSE,
+    // Word-parallel evaluation on an OpenCL device, which keeps the board
+    // between ticks.  Unless recordChanges is set only the population comes
+    // back each tick, and logicalBoard's tiles are left behind until
+    // syncSimulationBoard().  See gpu.h.
+    ENGINE_GPU
+} StepEngine;
+
+// Model half of the game: the logical board and everything needed to advance
+// it, with no knowledge of how (or whether) it is being displayed.
+typedef struct Simulation {
+    Board logicalBoard;
+    // Generations run so far.
+    uint64_t tick;
+    // After a tick, holds exactly the changes that tick applied, until the
+    // next tick.  Views read this to update themselves.
+    TileChangeBuffer pendingChanges;
+    // Engines that don't produce changes as a by-product of stepping only
+    // fill pendingChanges when this is set.  Defaults to true.
+    bool recordChanges;
+    StepEngine engine;
+    // Defaults to LIFE_RULE.  Changed with setSimulationRule().
+    LifeRule rule;
+    // rule, for ENGINE_SCALAR.
+    RuleTable ruleTable;
+    // Scratch board that engines write the next generation into before it is
+    // swapped with logicalBoard.
+    Board nextBoard;
+    // How the edges of the board connect, for the engines without an unbounded
+    // universe.  Defaults to TOPOLOGY_BOUNDED.  Changed with
+    // setSimulationTopology().
+    Topology topology;
+    // Defaults to true.
+    bool trackActiveRegions;
+    ActiveRegions activeRegions;
+    // Generations each ENGINE_PACKED tick advances, stepped a cache sized
+    // tile at a time with temporal blocking; see temporal.h.  0 or 1, the
+    // default, steps a generation at a time.  At most MAX_TEMPORAL_DEPTH.
+    // Blocked ticks sweep the whole board, whatever trackActiveRegions.
+    unsigned int temporalDepth;
+    // The scratch boards of temporalDepth's tiles, created on its first tick.
+    struct TemporalBlocking *temporal;
+    // Only present when stepping with more than one thread.
+    struct ThreadPool *threadPool;
+    struct RowsDiff *bandDiffs;
+    // The universe of ENGINE_HASHLIFE, created on its first tick.
+    struct Hashlife *hashlife;
+    // Bytes the Hashlife node cache may use before being collected.
+    size_t hashlifeMemoryLimit;
+    // log2 of the generations per ENGINE_HASHLIFE tick.  Defaults to 0.
+    unsigned int stepLog2;
+    // The universe of ENGINE_SPARSE, created on its first tick.
+    struct SparseUniverse *sparse;
+    // The device's copy of the board for ENGINE_GPU, created on its first
+    // tick.
+    struct GpuBoard *gpu;
+    // Set when logicalBoard has been edited since it was last copied to the
+    // device, and when the device has stepped past logicalBoard's tiles.
+    bool gpuBehind;
+    bool boardBehind;
+    // Universe coordinates of logicalBoard's top left tile, for the engines
+    // with an unbounded universe.  Changed with setSimulationView().
+    int64_t viewRow;
+    int64_t viewCol;
+    // Population statistics of logicalBoard, present once turned on with
+    // setSimulationCensus(), and read through simulationCensus().
+    struct BoardCensus *census;
+    // The ages of the dying tiles under a Generations rule, created on its
+    // first ENGINE_PACKED tick; see decay.h.
+    struct DecayPlanes *decay;
+    // When set, each tick fills lastTick.  Off by default, when it costs
+    // nothing but a few branches per tick.
+    bool collectStats;
+    TickStats lastTick;
+    // Stats bookkeeping, private to simulation.c.
+    uint64_t tickStartNanos;
+    bool computePhaseEnded;
+    // Set by each tick to the period of the cycle the board has entered, or 0
+    // if it hasn't returned to any of the states remembered since
+    // setSimulationCycleLimit().  Equal states are found by their hashes, so
+    // a false match is possible, though with 64 bit hashes vanishingly
+    // unlikely.
+    unsigned int cyclePeriod;
+    // Cycle detection, private to simulation.c.  The hash is of the
+    // universe for ENGINE_SPARSE, and of logicalBoard otherwise.
+    CycleDetector cycles;
+    uint64_t stateHash;
+    bool stateHashValid;
+} Simulation;
+
+// Takes ownership of board, even on failure.  Returns false if the change
+// buffer or scratch board can't be allocated.  The engine defaults to
+// ENGINE_PACKED.
+bool initSimulation(Simulation * const sim, Board board);
+
+void destroySimulation(Simulation * const sim);
+
+// Starts over at generation 0 from whatever logicalBoard now holds, keeping
+// the engine, rule, topology, threads and every buffer, so that many runs
+// can share one simulation without allocating.  An unbounded universe is
+// rebuilt from the board, with the board at the view.
+void restartSimulation(Simulation * const sim);
+
+// Advances the board by one tick, which is one generation for every engine
+// but ENGINE_HASHLIFE and ENGINE_PACKED with a temporalDepth.  Returns false
+// if no tile changed, i.e. the board has reached a still life; for a tick of
+// several generations, if none changed in the last of them.
+bool stepSimulation(Simulation * const sim);
+
+// As stepSimulation(), but a Hashlife tick is shortened to the largest power
+// of two generations not exceeding maxGenerations, which must be non-zero,
+// and a temporally blocked one to maxGenerations.
+bool stepSimulationUpTo(Simulation * const sim, const uint64_t maxGenerations);
+
+// Brings logicalBoard's tiles up to date with an engine that keeps the board
+// elsewhere between ticks, before they are read or edited.  Its population is
+// always up to date.  Does nothing for the other engines.
+void syncSimulationBoard(Simulation * const sim);
+
+// Must be called after a tile of logicalBoard is modified other than by
+// stepping, so that the modification isn't skipped over by active region
+// tracking.  An edited tile is no longer dying.
+void simulationTileEdited(Simulation * const sim, const unsigned int row, const unsigned int col);
+
+// As simulationTileEdited(), for every tile of rows [rowBegin, rowEnd) and
+// columns [colBegin, colEnd), after a bulk edit of the rectangle.
+void simulationRectEdited(Simulation * const sim, const unsigned int rowBegin, const unsigned int rowEnd,
+                          const unsigned int colBegin, const unsigned int colEnd);
+
+// As simulationTileEdited(), for when any part of the board may have changed.
+void simulationBoardEdited(Simulation * const sim);
+
+// The state of logicalBoard's tile at (row, col): 0 if dead, 1 if alive, or
+// from 2 up to rule.states - 1 while dying under a Generations rule.
+unsigned int simulationTileState(const Simulation * const sim, const unsigned int row, const unsigned int col);
+
+// Whether the engine's universe extends beyond logicalBoard.
+bool simulationIsUnbounded(const Simulation * const sim);
+
+// Moves the window logicalBoard shows so that its top left tile is at
+// universe (row, col), and fills it from the universe.  Only engines with an
+// unbounded universe can move the window; for the rest this does nothing.
+// pendingChanges does not describe the move, so views must redraw.
+void setSimulationView(Simulation * const sim, const int64_t row, const int64_t col);
+
+// Switches to rule from the next tick on.  Returns false, leaving the rule
+// unchanged, if the engine has an unbounded universe and rule has B0, which
+// would fill it, or if rule has dying states and the engine isn't
+// ENGINE_PACKED, the only one that ages tiles.  Dying tiles keep their ages
+// only under a rule with the same number of states.
+bool setSimulationRule(Simulation * const sim, const LifeRule rule);
+
+// Makes each tick look for the board repeating one of the last maxPeriod
+// generations, and report the period in cyclePeriod.  0, the default, turns
+// detection off, when it costs nothing.  Hashes are kept up to date from each
+// tick's changes rather than recomputed.  ENGINE_HASHLIFE, and ENGINE_PACKED
+// with a temporalDepth, whose ticks may skip whole periods, never find a
+// cycle.  Returns false, turning detection off, if the history can't be
+// allocated.
+bool setSimulationCycleLimit(Simulation * const sim, const unsigned int maxPeriod);
+
+// Turns on a census of logicalBoard's population, bounding box, centroid and
+// regional populations (see census.h), or off again.  Each tick then marks the
+// chunks that changed for recounting, which costs nothing beyond the tick's
+// own diff when only the active chunks are stepped; after the other ticks
+// the whole board is recounted when the census is next read.  Returns false,
+// leaving the census off, if it can't be allocated.
+bool setSimulationCensus(Simulation * const sim, const bool enabled);
+
+// Brings the census up to date with logicalBoard and returns it, or NULL if
+// it is off.  Only valid until the next tick or edit.
+const struct BoardCensus *simulationCensus(Simulation * const sim);
+
+// Takes effect from the next tick.  Engines with an unbounded universe have no
+// edges and ignore the topology.
+void setSimulationTopology(Simulation * const sim, const Topology topology);
+
+// Sets how many threads, including the caller, step the board.  The threads
+// are created here and live until the next call or destroySimulation().  A
+// board big enough to be mapped (see initBoard()) is copied into a fresh
+// mapping by the threads, each band by the thread that steps it, so that on a
+// NUMA machine each band lives on its stepping thread's node.  Returns false,
+// leaving the simulation single threaded, if they can't be created.
+bool setSimulationThreads(Simulation * const sim, const unsigned int nthreads);
+
+unsigned int simulationThreads(const Simulation * const sim);
+
+// Looks up an engine by its command line name.  Returns false if there is no
+// such engine.
+bool parseStepEngine(const char * const name, StepEngine * const engine);
+
+const char *stepEngineName(const StepEngine engine);
+
+#endif
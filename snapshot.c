@@ -0,0 +1,392 @@
+#include "snapshot.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SNAPSHOT_MAGIC "CONWAYSS"
+#define SNAPSHOT_VERSION 1
+// Reads back byte swapped on a host of the other endianness.
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+
+// Rows of a tile.  Each row of a tile is one board word.
+#define TILE_ROWS BOARD_WORD_BITS
+
+// The file starts with this header, followed by a directory of one entry per
+// tile, row of tiles by row of tiles, and then the tiles' data.  Every part
+// is a whole number of words, so a mapped file can be read a word at a time.
+typedef struct SnapshotHeader {
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t version;
+    uint32_t nrows;
+    uint32_t ncols;
+    uint64_t tick;
+    uint16_t birth;
+    uint16_t survive;
+    uint32_t topology;
+    uint64_t population;
+} SnapshotHeader;
+
+// How a tile's data is stored.  A directory entry is the file offset of the
+// data, which is word aligned, with the encoding in its low bits.
+typedef enum TileEncoding {
+    // No data: every tile is dead.
+    TILE_EMPTY = 0,
+    // A word with a bit set for every non-empty row, followed by those rows.
+    TILE_SPARSE = 1,
+    // Every row.
+    TILE_RAW = 2
+} TileEncoding;
+
+#define TILE_ENCODING_MASK ((uint64_t) 7)
+
+typedef struct TileGrid {
+    unsigned int tileRows;
+    unsigned int tileCols;
+} TileGrid;
+
+static TileGrid tileGrid(const unsigned int nrows, const unsigned int wordsPerRow) {
+    return (TileGrid) {(unsigned int) (((uint64_t) nrows + TILE_ROWS - 1) / TILE_ROWS), wordsPerRow};
+}
+
+static unsigned int rowsInTile(const unsigned int nrows, const unsigned int tileRow) {
+    const unsigned int first = tileRow * TILE_ROWS;
+    return nrows - first < TILE_ROWS ? nrows - first : TILE_ROWS;
+}
+
+// Gathers the rows of a tile into tile and returns the mask of non-empty ones.
+static uint64_t readTile(const Board * const board, const unsigned int tileRow, const unsigned int tileCol,
+                         BoardWord tile[TILE_ROWS]) {
+    const unsigned int n = rowsInTile(board->nrows, tileRow);
+    uint64_t mask = 0;
+    for (unsigned int r = 0; r < n; ++r) {
+        tile[r] = getBoardRow(board, tileRow * TILE_ROWS + r)[tileCol];
+        mask |= (uint64_t) (tile[r] != 0) << r;
+    }
+    return mask;
+}
+
+// The encoding of a tile with the given non-empty rows, and its size in words.
+static TileEncoding chooseEncoding(const uint64_t mask, const unsigned int nrows, size_t * const nwords) {
+    const unsigned int used = popcountWord(mask);
+    if (used == 0) {
+        *nwords = 0;
+        return TILE_EMPTY;
+    }
+    if (used + 1 < nrows) {
+        *nwords = used + 1;
+        return TILE_SPARSE;
+    }
+    *nwords = nrows;
+    return TILE_RAW;
+}
+
+// Two passes over the board: the first sizes every tile to fill in the
+// directory, the second writes the data behind it.
+static bool writeSnapshotFile(FILE * const file, const Board * const board, const SnapshotInfo * const info) {
+    SnapshotHeader header = {0};
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.version = SNAPSHOT_VERSION;
+    header.nrows = board->nrows;
+    header.ncols = board->ncols;
+    header.tick = info->tick;
+    header.birth = info->rule.birth;
+    header.survive = info->rule.survive;
+    header.topology = (uint32_t) info->topology;
+    header.population = board->nalive;
+
+    const TileGrid grid = tileGrid(board->nrows, board->wordsPerRow);
+    const size_t ntiles = (size_t) grid.tileRows * grid.tileCols;
+    uint64_t * const directory = (uint64_t *) malloc((ntiles > 0 ? ntiles : 1) * sizeof(uint64_t));
+    if (directory == NULL) {
+        return false;
+    }
+    BoardWord tile[TILE_ROWS];
+    uint64_t offset = sizeof(header) + ntiles * sizeof(uint64_t);
+    for (unsigned int tr = 0; tr < grid.tileRows; ++tr) {
+        for (unsigned int tc = 0; tc < grid.tileCols; ++tc) {
+            size_t nwords;
+            const uint64_t mask = readTile(board, tr, tc, tile);
+            const TileEncoding encoding = chooseEncoding(mask, rowsInTile(board->nrows, tr), &nwords);
+            directory[(size_t) tr * grid.tileCols + tc] = encoding == TILE_EMPTY ? 0 : offset | encoding;
+            offset += nwords * sizeof(BoardWord);
+        }
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+            && fwrite(directory, sizeof(uint64_t), ntiles, file) == ntiles;
+    free(directory);
+    for (unsigned int tr = 0; ok && tr < grid.tileRows; ++tr) {
+        const unsigned int nrows = rowsInTile(board->nrows, tr);
+        for (unsigned int tc = 0; ok && tc < grid.tileCols; ++tc) {
+            size_t nwords;
+            const uint64_t mask = readTile(board, tr, tc, tile);
+            const TileEncoding encoding = chooseEncoding(mask, nrows, &nwords);
+            if (encoding == TILE_SPARSE) {
+                ok = fwrite(&mask, sizeof(mask), 1, file) == 1;
+                for (uint64_t rest = mask; ok && rest != 0; rest &= rest - 1) {
+                    ok = fwrite(&tile[lowestBitIndex(rest)], sizeof(BoardWord), 1, file) == 1;
+                }
+            } else if (encoding == TILE_RAW) {
+                ok = fwrite(tile, sizeof(BoardWord), nrows, file) == nrows;
+            }
+        }
+    }
+    return ok;
+}
+
+bool writeSnapshot(const char * const path, const Board * const board, const SnapshotInfo * const info) {
+    // Written beside the old snapshot and renamed over it, so that a crash
+    // mid-write leaves the old one intact.
+    const size_t len = strlen(path);
+    char * const tmpPath = (char *) malloc(len + sizeof(".tmp"));
+    if (tmpPath == NULL) {
+        return false;
+    }
+    memcpy(tmpPath, path, len);
+    memcpy(tmpPath + len, ".tmp", sizeof(".tmp"));
+
+    FILE *file = fopen(tmpPath, "wb");
+    bool ok = file != NULL;
+    if (ok) {
+        setvbuf(file, NULL, _IOFBF, 1 << 20);
+        ok = writeSnapshotFile(file, board, info) && fflush(file) == 0 && fsync(fileno(file)) == 0;
+        ok = fclose(file) == 0 && ok;
+        ok = ok && rename(tmpPath, path) == 0;
+        if (!ok) {
+            remove(tmpPath);
+        }
+    }
+    free(tmpPath);
+    return ok;
+}
+
+// Checks every field of a mapped snapshot before the board is allocated.
+static bool validHeader(const SnapshotHeader * const header, const size_t size) {
+    const unsigned int ruleBits = (1u << NEIGHBOUR_COUNTS) - 1;
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0
+            || header->byteOrder != SNAPSHOT_BYTE_ORDER || header->version != SNAPSHOT_VERSION
+            || header->topology > TOPOLOGY_TORUS || (header->birth & ~ruleBits) != 0
+            || (header->survive & ~ruleBits) != 0) {
+        return false;
+    }
+    // The dimensions are worked in 64 bits, so that none of them can wrap
+    // round to a small board.
+    size_t nwords;
+    if (!boardStorageWords(header->nrows, header->ncols, &nwords)) {
+        return false;
+    }
+    const unsigned int wordsPerRow = (unsigned int) (((uint64_t) header->ncols + BOARD_WORD_BITS - 1)
+                                                     / BOARD_WORD_BITS);
+    const TileGrid grid = tileGrid(header->nrows, wordsPerRow);
+    const uint64_t ntiles = (uint64_t) grid.tileRows * grid.tileCols;
+    return ntiles <= (size - sizeof(SnapshotHeader)) / sizeof(uint64_t);
+}
+
+// Decodes the tiles of a mapped snapshot into board, which has the snapshot's
+// dimensions.  Returns false if any tile's data lies outside the file.
+static bool decodeTiles(const unsigned char * const data, const size_t size, Board * const board) {
+    const TileGrid grid = tileGrid(board->nrows, board->wordsPerRow);
+    const uint64_t * const directory = (const uint64_t *) (data + sizeof(SnapshotHeader));
+    for (unsigned int tr = 0; tr < grid.tileRows; ++tr) {
+        const unsigned int nrows = rowsInTile(board->nrows, tr);
+        for (unsigned int tc = 0; tc < grid.tileCols; ++tc) {
+            const uint64_t entry = directory[(size_t) tr * grid.tileCols + tc];
+            const uint64_t offset = entry & ~TILE_ENCODING_MASK;
+            const TileEncoding encoding = (TileEncoding) (entry & TILE_ENCODING_MASK);
+            if (encoding == TILE_EMPTY) {
+                continue;
+            }
+            if (offset > size || (encoding != TILE_SPARSE && encoding != TILE_RAW)) {
+                return false;
+            }
+            const BoardWord * const words = (const BoardWord *) (data + offset);
+            const size_t available = (size - offset) / sizeof(BoardWord);
+            BoardWord * const column = getBoardRow(board, tr * TILE_ROWS) + tc;
+            if (encoding == TILE_RAW) {
+                if (available < nrows) {
+                    return false;
+                }
+                for (unsigned int r = 0; r < nrows; ++r) {
+                    column[(size_t) r * board->rowStride] = words[r];
+                }
+                continue;
+            }
+            if (available < 1) {
+                return false;
+            }
+            const uint64_t mask = words[0];
+            if ((nrows < TILE_ROWS && (mask >> nrows) != 0) || available < 1 + (size_t) popcountWord(mask)) {
+                return false;
+            }
+            size_t next = 1;
+            for (uint64_t rest = mask; rest != 0; rest &= rest - 1) {
+                column[(size_t) lowestBitIndex(rest) * board->rowStride] = words[next++];
+            }
+        }
+    }
+    return true;
+}
+
+bool loadSnapshot(const char * const path, Board * const board, SnapshotInfo * const info) {
+    *board = (Board) {0};
+    const int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(SnapshotHeader)) {
+        close(fd);
+        return false;
+    }
+    const size_t size = (size_t) st.st_size;
+    void * const mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    madvise(mapped, size, MADV_SEQUENTIAL);
+
+    const unsigned char * const data = (const unsigned char *) mapped;
+    const SnapshotHeader * const header = (const SnapshotHeader *) data;
+    bool ok = validHeader(header, size) && initBoard(board, header->nrows, header->ncols)
+            && decodeTiles(data, size, board);
+    if (ok) {
+        // Only the tiles count towards the population, so that stray padding
+        // bits in a damaged file can't survive into the board.
+        clearBoardPadding(board);
+        uint64_t population = 0;
+        for (unsigned int row = 0; row < board->nrows; ++row) {
+            const BoardWord * const words = getBoardRow(board, row);
+            for (unsigned int w = 0; w < board->wordsPerRow; ++w) {
+                population += popcountWord(words[w]);
+            }
+        }
+        ok = population == header->population;
+        board->nalive = (unsigned int) population;
+        info->tick = header->tick;
+        info->rule = (LifeRule) {header->birth, header->survive, 2};
+        info->topology = (Topology) header->topology;
+    }
+    munmap(mapped, size);
+    if (!ok) {
+        destroyBoard(board);
+    }
+    return ok;
+}
+
+struct SnapshotWriter {
+    pthread_t thread;
+    const char *path;
+
+    pthread_mutex_t mutex;
+    // Signalled when a snapshot is submitted, or on shutdown.
+    pthread_cond_t submitted;
+    // Signalled when the thread finishes writing a snapshot.
+    pthread_cond_t written;
+    // Set from submission until the snapshot is written.  board and info
+    // belong to the writer thread while it is set.
+    bool pending;
+    bool failed;
+    bool shuttingDown;
+
+    Board board;
+    SnapshotInfo info;
+};
+
+static void *writerMain(void *arg) {
+    SnapshotWriter * const writer = (SnapshotWriter *) arg;
+    pthread_mutex_lock(&writer->mutex);
+    while (true) {
+        while (!writer->pending && !writer->shuttingDown) {
+            pthread_cond_wait(&writer->submitted, &writer->mutex);
+        }
+        if (!writer->pending) {
+            break;
+        }
+        pthread_mutex_unlock(&writer->mutex);
+
+        const bool ok = writeSnapshot(writer->path, &writer->board, &writer->info);
+
+        pthread_mutex_lock(&writer->mutex);
+        writer->failed |= !ok;
+        writer->pending = false;
+        pthread_cond_broadcast(&writer->written);
+    }
+    pthread_mutex_unlock(&writer->mutex);
+    return NULL;
+}
+
+SnapshotWriter *createSnapshotWriter(const char * const path) {
+    SnapshotWriter *writer = (SnapshotWriter *) calloc(1, sizeof(SnapshotWriter));
+    if (writer == NULL) {
+        return NULL;
+    }
+    writer->path = path;
+    pthread_mutex_init(&writer->mutex, NULL);
+    pthread_cond_init(&writer->submitted, NULL);
+    pthread_cond_init(&writer->written, NULL);
+    if (pthread_create(&writer->thread, NULL, writerMain, writer) != 0) {
+        pthread_cond_destroy(&writer->written);
+        pthread_cond_destroy(&writer->submitted);
+        pthread_mutex_destroy(&writer->mutex);
+        free(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+void destroySnapshotWriter(SnapshotWriter * const writer) {
+    if (writer == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&writer->mutex);
+    writer->shuttingDown = true;
+    pthread_cond_signal(&writer->submitted);
+    pthread_mutex_unlock(&writer->mutex);
+    pthread_join(writer->thread, NULL);
+    pthread_cond_destroy(&writer->written);
+    pthread_cond_destroy(&writer->submitted);
+    pthread_mutex_destroy(&writer->mutex);
+    destroyBoard(&writer->board);
+    free(writer);
+}
+
+bool submitSnapshot(SnapshotWriter * const writer, const Board * const board, const SnapshotInfo * const info) {
+    pthread_mutex_lock(&writer->mutex);
+    const bool busy = writer->pending;
+    pthread_mutex_unlock(&writer->mutex);
+    if (busy) {
+        return false;
+    }
+
+    // The thread is idle, so the buffer can be filled without the lock.
+    const bool copied = copyBoard(&writer->board, board);
+    pthread_mutex_lock(&writer->mutex);
+    if (copied) {
+        writer->info = *info;
+        writer->pending = true;
+        pthread_cond_signal(&writer->submitted);
+    } else {
+        writer->failed = true;
+    }
+    pthread_mutex_unlock(&writer->mutex);
+    return copied;
+}
+
+bool waitForSnapshots(SnapshotWriter * const writer) {
+    pthread_mutex_lock(&writer->mutex);
+    while (writer->pending) {
+        pthread_cond_wait(&writer->written, &writer->mutex);
+    }
+    const bool ok = !writer->failed;
+    pthread_mutex_unlock(&writer->mutex);
+    return ok;
+}
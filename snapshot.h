@@ -0,0 +1,53 @@
+#ifndef CONWAY_SNAPSHOT_H
+#define CONWAY_SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "board.h"
+#include "rule.h"
+
+// Binary checkpoints of a board, laid out so that they can be memory mapped
+// and decoded in place.  The board is cut into tiles of BOARD_WORD_BITS rows
+// by one word, and each tile is stored as nothing at all if it is empty, as
+// a mask of its non-empty rows followed by those rows if that is smaller, or
+// else as its raw words.  Everything is in host byte order; snapshots from a
+// host of the other endianness are rejected.
+
+// What a snapshot records besides the tiles.
+typedef struct SnapshotInfo {
+    uint64_t tick;
+    LifeRule rule;
+    Topology topology;
+} SnapshotInfo;
+
+// Writes board to path, replacing any existing file only once the new one is
+// complete.  Returns false on failure.
+bool writeSnapshot(const char * const path, const Board * const board, const SnapshotInfo * const info);
+
+// Maps the snapshot at path and decodes it into a freshly allocated board.
+// Returns false and leaves the board empty if the file can't be read or isn't
+// a valid snapshot.
+bool loadSnapshot(const char * const path, Board * const board, SnapshotInfo * const info);
+
+// Writes snapshots to one path on a thread of its own, so that checkpointing
+// never waits on the disk.  The internals are private to snapshot.c.
+typedef struct SnapshotWriter SnapshotWriter;
+
+// Starts the writer thread.  path is not copied.  Returns NULL on failure.
+SnapshotWriter *createSnapshotWriter(const char * const path);
+
+// Waits for any write in progress, then stops the thread.
+void destroySnapshotWriter(SnapshotWriter * const writer);
+
+// Copies board into the writer's own buffer and returns straight away,
+// leaving the thread to encode and write it.  If the previous snapshot is
+// still being written nothing is copied and false is returned, so that the
+// caller can try again later rather than wait.
+bool submitSnapshot(SnapshotWriter * const writer, const Board * const board, const SnapshotInfo * const info);
+
+// Waits for any write in progress.  Returns false if any write since the
+// writer was created failed.
+bool waitForSnapshots(SnapshotWriter * const writer);
+
+#endif
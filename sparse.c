@@ -0,0 +1,417 @@
+#include "sparse.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cycle.h"
+#include "packed_kernel.h"
+
+#define INITIAL_BUCKETS 1024
+#define INITIAL_TILE_CAPACITY 256
+
+typedef struct Tile {
+    // Tile coordinates: the tile covers universe rows
+    // [row * SPARSE_TILE_SIZE, (row + 1) * SPARSE_TILE_SIZE), and likewise
+    // for columns.
+    int64_t row;
+    int64_t col;
+    struct Tile *hashNext;
+    // Position in SparseUniverse.tiles.
+    size_t index;
+    uint64_t population;
+    // Row r of the tile, column c in bit c.
+    BoardWord rows[SPARSE_TILE_SIZE];
+    BoardWord nextRows[SPARSE_TILE_SIZE];
+} Tile;
+
+struct SparseUniverse {
+    // Every tile, chained through hashNext.
+    Tile **buckets;
+    size_t nbuckets;
+    // Every tile again, densely, for iteration.
+    Tile **tiles;
+    size_t ntiles;
+    size_t tileCapacity;
+    uint64_t population;
+    // The XOR of a hashBoardWord() of every tile row, kept up to date as rows
+    // change.
+    uint64_t hash;
+    LifeRule rule;
+    // Whether rule is Life, which has a faster step than the generic one.
+    bool isLife;
+};
+
+DEFINE_STEP_WORDS(stepTileWord, BoardWord, )
+
+// The tile coordinate of universe coordinate x, rounding towards negative
+// infinity.
+static inline int64_t tileCoordinate(const int64_t x) {
+    return x >= 0 ? x / SPARSE_TILE_SIZE : -((-(x + 1)) / SPARSE_TILE_SIZE) - 1;
+}
+
+static inline size_t hashTile(const int64_t row, const int64_t col) {
+    uint64_t h = (uint64_t) row * 0x9E3779B97F4A7C15ULL;
+    h ^= (uint64_t) col * 0xC2B2AE3D27D4EB4FULL;
+    return (size_t) (h ^ (h >> 31));
+}
+
+// Position of row r of tile (row, col), for hashBoardWord().
+static inline uint64_t tileRowPosition(const int64_t row, const int64_t col, const unsigned int r) {
+    return ((uint64_t) row * SPARSE_TILE_SIZE + r) * 0x9E3779B97F4A7C15ULL ^ (uint64_t) col * 0xC2B2AE3D27D4EB4FULL;
+}
+
+static Tile *findTile(const SparseUniverse * const u, const int64_t row, const int64_t col) {
+    for (Tile *tile = u->buckets[hashTile(row, col) & (u->nbuckets - 1)]; tile != NULL; tile = tile->hashNext) {
+        if (tile->row == row && tile->col == col) {
+            return tile;
+        }
+    }
+    return NULL;
+}
+
+static void growBuckets(SparseUniverse * const u) {
+    const size_t nbuckets = u->nbuckets * 2;
+    Tile **buckets = (Tile **) calloc(nbuckets, sizeof(Tile *));
+    if (buckets == NULL) {
+        exit(1);
+    }
+    for (size_t i = 0; i < u->ntiles; ++i) {
+        Tile * const tile = u->tiles[i];
+        const size_t bucket = hashTile(tile->row, tile->col) & (nbuckets - 1);
+        tile->hashNext = buckets[bucket];
+        buckets[bucket] = tile;
+    }
+    free(u->buckets);
+    u->buckets = buckets;
+    u->nbuckets = nbuckets;
+}
+
+// Returns the tile at (row, col), creating it empty if there is none.
+static Tile *getTile(SparseUniverse * const u, const int64_t row, const int64_t col) {
+    Tile *tile = findTile(u, row, col);
+    if (tile != NULL) {
+        return tile;
+    }
+
+    if (u->ntiles == u->tileCapacity) {
+        const size_t capacity = u->tileCapacity * 2;
+        Tile **tiles = (Tile **) realloc(u->tiles, capacity * sizeof(Tile *));
+        if (tiles == NULL) {
+            exit(1);
+        }
+        u->tiles = tiles;
+        u->tileCapacity = capacity;
+    }
+    tile = (Tile *) calloc(1, sizeof(Tile));
+    if (tile == NULL) {
+        exit(1);
+    }
+    tile->row = row;
+    tile->col = col;
+    tile->index = u->ntiles;
+    u->tiles[u->ntiles++] = tile;
+    if (u->ntiles > u->nbuckets) {
+        growBuckets(u);
+    } else {
+        const size_t bucket = hashTile(row, col) & (u->nbuckets - 1);
+        tile->hashNext = u->buckets[bucket];
+        u->buckets[bucket] = tile;
+    }
+    return tile;
+}
+
+static void freeTile(SparseUniverse * const u, Tile * const tile) {
+    Tile **link = &u->buckets[hashTile(tile->row, tile->col) & (u->nbuckets - 1)];
+    while (*link != tile) {
+        link = &(*link)->hashNext;
+    }
+    *link = tile->hashNext;
+
+    Tile * const last = u->tiles[--u->ntiles];
+    u->tiles[tile->index] = last;
+    last->index = tile->index;
+    free(tile);
+}
+
+static void clearUniverse(SparseUniverse * const u) {
+    for (size_t i = 0; i < u->ntiles; ++i) {
+        free(u->tiles[i]);
+    }
+    u->ntiles = 0;
+    memset(u->buckets, 0, u->nbuckets * sizeof(Tile *));
+    u->population = 0;
+    u->hash = 0;
+}
+
+// Stepping
+
+// Creates the neighbours of tile that something may be born in next
+// generation, which without B0 are those next to one of its live edge tiles.
+static void createBirthNeighbours(SparseUniverse * const u, const Tile * const tile) {
+    const BoardWord top = tile->rows[0];
+    const BoardWord bottom = tile->rows[SPARSE_TILE_SIZE - 1];
+    BoardWord columns = 0;
+    for (unsigned int r = 0; r < SPARSE_TILE_SIZE; ++r) {
+        columns |= tile->rows[r];
+    }
+    const BoardWord westBit = 1;
+    const BoardWord eastBit = (BoardWord) 1 << (SPARSE_TILE_SIZE - 1);
+    const int64_t row = tile->row;
+    const int64_t col = tile->col;
+
+    if (top != 0) {
+        getTile(u, row - 1, col);
+    }
+    if (bottom != 0) {
+        getTile(u, row + 1, col);
+    }
+    if (columns & westBit) {
+        getTile(u, row, col - 1);
+    }
+    if (columns & eastBit) {
+        getTile(u, row, col + 1);
+    }
+    if (top & westBit) {
+        getTile(u, row - 1, col - 1);
+    }
+    if (top & eastBit) {
+        getTile(u, row - 1, col + 1);
+    }
+    if (bottom & westBit) {
+        getTile(u, row + 1, col - 1);
+    }
+    if (bottom & eastBit) {
+        getTile(u, row + 1, col + 1);
+    }
+}
+
+// Fills column[0, SPARSE_TILE_SIZE + 2) with the rows of tile from the last row
+// of the tile above to the first row of the tile below.  Missing tiles are
+// dead.
+static void gatherColumn(const Tile * const above, const Tile * const tile, const Tile * const below,
+                         BoardWord * const column) {
+    column[0] = above != NULL ? above->rows[SPARSE_TILE_SIZE - 1] : 0;
+    if (tile != NULL) {
+        memcpy(column + 1, tile->rows, sizeof(tile->rows));
+    } else {
+        memset(column + 1, 0, sizeof(tile->rows));
+    }
+    column[SPARSE_TILE_SIZE + 1] = below != NULL ? below->rows[0] : 0;
+}
+
+// Computes the next generation of tile into its nextRows.
+static void stepTile(const SparseUniverse * const u, Tile * const tile) {
+    const int64_t row = tile->row;
+    const int64_t col = tile->col;
+    BoardWord west[SPARSE_TILE_SIZE + 2];
+    BoardWord centre[SPARSE_TILE_SIZE + 2];
+    BoardWord east[SPARSE_TILE_SIZE + 2];
+    gatherColumn(findTile(u, row - 1, col - 1), findTile(u, row, col - 1), findTile(u, row + 1, col - 1), west);
+    gatherColumn(findTile(u, row - 1, col), tile, findTile(u, row + 1, col), centre);
+    gatherColumn(findTile(u, row - 1, col + 1), findTile(u, row, col + 1), findTile(u, row + 1, col + 1), east);
+
+    for (unsigned int r = 1; r <= SPARSE_TILE_SIZE; ++r) {
+        tile->nextRows[r - 1] = u->isLife
+                ? stepTileWordLife(west[r - 1], centre[r - 1], east[r - 1], west[r], centre[r], east[r],
+                                   west[r + 1], centre[r + 1], east[r + 1], &u->rule)
+                : stepTileWordGeneric(west[r - 1], centre[r - 1], east[r - 1], west[r], centre[r], east[r],
+                                      west[r + 1], centre[r + 1], east[r + 1], &u->rule);
+    }
+}
+
+bool sparseStep(SparseUniverse * const u) {
+    const size_t nlive = u->ntiles;
+    for (size_t i = 0; i < nlive; ++i) {
+        createBirthNeighbours(u, u->tiles[i]);
+    }
+    // Every tile is computed from the current generation before any of them
+    // is overwritten.
+    for (size_t i = 0; i < u->ntiles; ++i) {
+        stepTile(u, u->tiles[i]);
+    }
+
+    bool anyChanged = false;
+    u->population = 0;
+    for (size_t i = 0; i < u->ntiles; ++i) {
+        Tile * const tile = u->tiles[i];
+        if (memcmp(tile->rows, tile->nextRows, sizeof(tile->rows)) != 0) {
+            anyChanged = true;
+            for (unsigned int r = 0; r < SPARSE_TILE_SIZE; ++r) {
+                if (tile->rows[r] != tile->nextRows[r]) {
+                    const uint64_t position = tileRowPosition(tile->row, tile->col, r);
+                    u->hash ^= hashBoardWord(position, tile->rows[r]) ^ hashBoardWord(position, tile->nextRows[r]);
+                }
+            }
+            memcpy(tile->rows, tile->nextRows, sizeof(tile->rows));
+        }
+        tile->population = 0;
+        for (unsigned int r = 0; r < SPARSE_TILE_SIZE; ++r) {
+            tile->population += popcountWord(tile->rows[r]);
+        }
+        u->population += tile->population;
+    }
+    // Backwards, since freeing a tile moves the last one into its place.
+    for (size_t i = u->ntiles; i-- > 0;) {
+        if (u->tiles[i]->population == 0) {
+            freeTile(u, u->tiles[i]);
+        }
+    }
+    return anyChanged;
+}
+
+// Loading and exporting
+
+void sparseLoadBoard(SparseUniverse * const u, const Board * const board,
+                     const int64_t originRow, const int64_t originCol) {
+    clearUniverse(u);
+    for (unsigned int row = 0; row < board->nrows; ++row) {
+        const BoardWord * const words = getBoardRow(board, row);
+        const int64_t tileRow = tileCoordinate(originRow + row);
+        const unsigned int r = (unsigned int) (originRow + row - tileRow * SPARSE_TILE_SIZE);
+        for (unsigned int w = 0; w < board->wordsPerRow; ++w) {
+            if (words[w] == 0) {
+                continue;
+            }
+            // A board word straddles at most two tiles.
+            const int64_t col = originCol + (int64_t) w * BOARD_WORD_BITS;
+            const int64_t tileCol = tileCoordinate(col);
+            const unsigned int shift = (unsigned int) (col - tileCol * SPARSE_TILE_SIZE);
+            getTile(u, tileRow, tileCol)->rows[r] |= words[w] << shift;
+            if (shift != 0 && (words[w] >> (BOARD_WORD_BITS - shift)) != 0) {
+                getTile(u, tileRow, tileCol + 1)->rows[r] |= words[w] >> (BOARD_WORD_BITS - shift);
+            }
+        }
+    }
+    for (size_t i = 0; i < u->ntiles; ++i) {
+        Tile * const tile = u->tiles[i];
+        for (unsigned int r = 0; r < SPARSE_TILE_SIZE; ++r) {
+            tile->population += popcountWord(tile->rows[r]);
+            u->hash ^= hashBoardWord(tileRowPosition(tile->row, tile->col, r), tile->rows[r]);
+        }
+        u->population += tile->population;
+    }
+}
+
+void sparseSetTile(SparseUniverse * const u, const int64_t row, const int64_t col, const TileState state) {
+    const int64_t tileRow = tileCoordinate(row);
+    const int64_t tileCol = tileCoordinate(col);
+    const BoardWord bit = (BoardWord) 1 << (col - tileCol * SPARSE_TILE_SIZE);
+    const unsigned int r = (unsigned int) (row - tileRow * SPARSE_TILE_SIZE);
+    Tile * const tile = state == ALIVE ? getTile(u, tileRow, tileCol) : findTile(u, tileRow, tileCol);
+    if (tile == NULL || ((tile->rows[r] & bit) != 0) == (state == ALIVE)) {
+        return;
+    }
+
+    const uint64_t position = tileRowPosition(tileRow, tileCol, r);
+    u->hash ^= hashBoardWord(position, tile->rows[r]) ^ hashBoardWord(position, tile->rows[r] ^ bit);
+    tile->rows[r] ^= bit;
+    if (state == ALIVE) {
+        ++tile->population;
+        ++u->population;
+    } else {
+        --tile->population;
+        --u->population;
+        if (tile->population == 0) {
+            freeTile(u, tile);
+        }
+    }
+}
+
+TileState sparseGetTile(const SparseUniverse * const u, const int64_t row, const int64_t col) {
+    const int64_t tileRow = tileCoordinate(row);
+    const int64_t tileCol = tileCoordinate(col);
+    const Tile * const tile = findTile(u, tileRow, tileCol);
+    if (tile == NULL) {
+        return DEAD;
+    }
+    const BoardWord word = tile->rows[row - tileRow * SPARSE_TILE_SIZE];
+    return (word >> (col - tileCol * SPARSE_TILE_SIZE)) & 1 ? ALIVE : DEAD;
+}
+
+void sparseExportBoard(const SparseUniverse * const u, Board * const board,
+                       const int64_t originRow, const int64_t originCol) {
+    clearBoard(board);
+    for (size_t i = 0; i < u->ntiles; ++i) {
+        const Tile * const tile = u->tiles[i];
+        const int64_t top = tile->row * SPARSE_TILE_SIZE - originRow;
+        const int64_t left = tile->col * SPARSE_TILE_SIZE - originCol;
+        if (top >= board->nrows || left >= board->ncols || top + SPARSE_TILE_SIZE <= 0
+                || left + SPARSE_TILE_SIZE <= 0) {
+            continue;
+        }
+        // A tile row straddles at most two board words, which are as wide as
+        // tiles.
+        const int64_t word = tileCoordinate(left);
+        const unsigned int shift = (unsigned int) (left - word * BOARD_WORD_BITS);
+        for (unsigned int r = 0; r < SPARSE_TILE_SIZE; ++r) {
+            if (top + r < 0 || top + r >= board->nrows) {
+                continue;
+            }
+            BoardWord * const words = getBoardRow(board, (unsigned int) (top + r));
+            if (word >= 0) {
+                words[word] |= tile->rows[r] << shift;
+            }
+            if (shift != 0 && word + 1 < board->wordsPerRow) {
+                words[word + 1] |= tile->rows[r] >> (BOARD_WORD_BITS - shift);
+            }
+        }
+    }
+
+    const BoardWord mask = lastWordMask(board);
+    board->nalive = 0;
+    for (unsigned int row = 0; row < board->nrows && board->wordsPerRow > 0; ++row) {
+        BoardWord * const words = getBoardRow(board, row);
+        words[board->wordsPerRow - 1] &= mask;
+        for (unsigned int w = 0; w < board->wordsPerRow; ++w) {
+            board->nalive += popcountWord(words[w]);
+        }
+    }
+}
+
+// Lifetime and queries
+
+SparseUniverse *createSparseUniverse(const LifeRule rule) {
+    SparseUniverse *u = (SparseUniverse *) calloc(1, sizeof(SparseUniverse));
+    if (u == NULL) {
+        return NULL;
+    }
+    u->nbuckets = INITIAL_BUCKETS;
+    u->buckets = (Tile **) calloc(u->nbuckets, sizeof(Tile *));
+    u->tileCapacity = INITIAL_TILE_CAPACITY;
+    u->tiles = (Tile **) malloc(u->tileCapacity * sizeof(Tile *));
+    if (u->buckets == NULL || u->tiles == NULL) {
+        destroySparseUniverse(u);
+        return NULL;
+    }
+    sparseSetRule(u, rule);
+    return u;
+}
+
+void destroySparseUniverse(SparseUniverse * const u) {
+    if (u == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < u->ntiles; ++i) {
+        free(u->tiles[i]);
+    }
+    free(u->buckets);
+    free(u->tiles);
+    free(u);
+}
+
+void sparseSetRule(SparseUniverse * const u, const LifeRule rule) {
+    u->rule = rule;
+    u->isLife = lifeRulesEqual(rule, LIFE_RULE);
+}
+
+uint64_t sparsePopulation(const SparseUniverse * const u) {
+    return u->population;
+}
+
+uint64_t sparseHash(const SparseUniverse * const u) {
+    return u->hash;
+}
+
+size_t sparseMemoryUsed(const SparseUniverse * const u) {
+    return u->ntiles * sizeof(Tile) + u->nbuckets * sizeof(Tile *) + u->tileCapacity * sizeof(Tile *);
+}
@@ -0,0 +1,59 @@
+#ifndef CONWAY_SPARSE_H
+#define CONWAY_SPARSE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board.h"
+#include "rule.h"
+
+// An unbounded universe stored as a hash map of fixed-size square tiles,
+// allocated when something may be born in them and freed once they are empty,
+// so that memory follows the live population rather than its bounding box.
+// The internals are private to sparse.c.
+//
+// Universe coordinates are signed.  Boards are loaded from and exported to
+// windows of the universe given by the universe coordinates of their top left
+// tile.
+typedef struct SparseUniverse SparseUniverse;
+
+// Tiles are SPARSE_TILE_SIZE tiles square, one BoardWord per row.
+#define SPARSE_TILE_SIZE BOARD_WORD_BITS
+
+// Creates an empty universe that evolves under rule, which must not have B0.
+// Returns NULL on failure.
+SparseUniverse *createSparseUniverse(const LifeRule rule);
+
+void destroySparseUniverse(SparseUniverse * const universe);
+
+// Takes effect from the next step.  rule must not have B0.
+void sparseSetRule(SparseUniverse * const universe, const LifeRule rule);
+
+// Replaces the whole universe with the live tiles of board, with its top left
+// tile at universe (originRow, originCol).
+void sparseLoadBoard(SparseUniverse * const universe, const Board * const board,
+                     const int64_t originRow, const int64_t originCol);
+
+void sparseSetTile(SparseUniverse * const universe, const int64_t row, const int64_t col, const TileState state);
+
+TileState sparseGetTile(const SparseUniverse * const universe, const int64_t row, const int64_t col);
+
+// Overwrites board with the window of the universe whose top left tile is at
+// universe (originRow, originCol).
+void sparseExportBoard(const SparseUniverse * const universe, Board * const board,
+                       const int64_t originRow, const int64_t originCol);
+
+// Advances the universe by one generation.  Returns false if no tile changed.
+bool sparseStep(SparseUniverse * const universe);
+
+uint64_t sparsePopulation(const SparseUniverse * const universe);
+
+// A hash of the whole universe, kept up to date as it changes, so that equal
+// universes have equal hashes whatever tiles they happen to have allocated.
+uint64_t sparseHash(const SparseUniverse * const universe);
+
+// Bytes held by the tiles and their hash table.
+size_t sparseMemoryUsed(const SparseUniverse * const universe);
+
+#endif
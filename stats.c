@@ -0,0 +1,59 @@
+#include "stats.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+bool parseStatsFormat(const char * const name, StatsFormat * const format) {
+    if (strcmp(name, "csv") == 0) {
+        *format = STATS_CSV;
+    } else if (strcmp(name, "json") == 0) {
+        *format = STATS_JSON;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void writeStatsHeader(FILE * const out, const StatsFormat format, const bool census) {
+    if (format == STATS_CSV) {
+        fprintf(out, "generation,population,ticks,births,deaths,compute_ns,commit_ns%s\n",
+                census ? ",top,left,bottom,right,centroid_row,centroid_col" : "");
+    }
+}
+
+static void writeCensusFields(FILE * const out, const StatsFormat format, const CensusSummary * const census) {
+    if (format == STATS_CSV && census->population == 0) {
+        fprintf(out, ",,,,,,");
+    } else if (format == STATS_CSV) {
+        fprintf(out, ",%u,%u,%u,%u,%.3f,%.3f", census->top, census->left, census->bottom, census->right,
+                census->centroidRow, census->centroidCol);
+    } else if (census->population == 0) {
+        fprintf(out, ", \"top\": null, \"left\": null, \"bottom\": null, \"right\": null"
+                ", \"centroid_row\": null, \"centroid_col\": null");
+    } else {
+        fprintf(out, ", \"top\": %u, \"left\": %u, \"bottom\": %u, \"right\": %u"
+                ", \"centroid_row\": %.3f, \"centroid_col\": %.3f",
+                census->top, census->left, census->bottom, census->right, census->centroidRow,
+                census->centroidCol);
+    }
+}
+
+void writeStatsRecord(FILE * const out, const StatsFormat format, const uint64_t generation,
+                      const uint64_t population, const TickStats * const stats,
+                      const CensusSummary * const census) {
+    if (format == STATS_CSV) {
+        fprintf(out, "%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64,
+                generation, population, stats->ticks, stats->births, stats->deaths, stats->computeNanos,
+                stats->commitNanos);
+    } else {
+        fprintf(out, "{\"generation\": %" PRIu64 ", \"population\": %" PRIu64 ", \"ticks\": %" PRIu64
+                ", \"births\": %" PRIu64 ", \"deaths\": %" PRIu64 ", \"compute_ns\": %" PRIu64
+                ", \"commit_ns\": %" PRIu64,
+                generation, population, stats->ticks, stats->births, stats->deaths, stats->computeNanos,
+                stats->commitNanos);
+    }
+    if (census != NULL) {
+        writeCensusFields(out, format, census);
+    }
+    fprintf(out, format == STATS_CSV ? "\n" : "}\n");
+}
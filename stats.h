@@ -0,0 +1,56 @@
+#ifndef CONWAY_STATS_H
+#define CONWAY_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "census.h"
+
+// Where the time of ticks went and what they did to the board, for one tick
+// or summed over several.
+typedef struct TickStats {
+    uint64_t ticks;
+    // Working out the next generation: counting neighbours and applying the
+    // rule.  Engines that diff each part of the board as soon as it is
+    // stepped count the diff here too.
+    uint64_t computeNanos;
+    // Making the next generation current: diffing, recording changes, and
+    // copying unbounded universes into their window.
+    uint64_t commitNanos;
+    // Tiles of the board that came alive and died.  For a Hashlife tick of
+    // many generations these are the net changes over all of them.
+    uint64_t births;
+    uint64_t deaths;
+} TickStats;
+
+static inline void addTickStats(TickStats * const total, const TickStats * const stats) {
+    total->ticks += stats->ticks;
+    total->computeNanos += stats->computeNanos;
+    total->commitNanos += stats->commitNanos;
+    total->births += stats->births;
+    total->deaths += stats->deaths;
+}
+
+typedef enum StatsFormat {
+    STATS_CSV,
+    // One JSON object per line.
+    STATS_JSON
+} StatsFormat;
+
+// Looks up a format by its command line name, "csv" or "json".  Returns false
+// if there is no such format.
+bool parseStatsFormat(const char * const name, StatsFormat * const format);
+
+// Writes whatever has to precede the records, i.e. the CSV column names,
+// with the census columns if they are to be written.
+void writeStatsHeader(FILE * const out, const StatsFormat format, const bool census);
+
+// Writes the stats of the ticks up to generation, which left population live
+// tiles, as one record.  If census isn't NULL the board's bounding box and
+// centroid follow, empty or null for an empty board.
+void writeStatsRecord(FILE * const out, const StatsFormat format, const uint64_t generation,
+                      const uint64_t population, const TickStats * const stats,
+                      const CensusSummary * const census);
+
+#endif
@@ -0,0 +1,366 @@
+#include "stream.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Frames may wait to be written until their copies of the board fill this
+// many bytes, or there are MAX_STREAM_SLOTS of them, though there are always
+// room for at least MIN_STREAM_SLOTS.
+#define STREAM_BUFFER_BYTES ((size_t) 64 * 1024 * 1024)
+#define MIN_STREAM_SLOTS 2
+#define MAX_STREAM_SLOTS 1024
+
+// Most buffers handed to one writev().
+#ifdef IOV_MAX
+#define STREAM_IOVECS IOV_MAX
+#else
+#define STREAM_IOVECS 16
+#endif
+
+#define UNIX_PREFIX "unix:"
+
+bool parseStreamFormat(const char * const name, StreamFormat * const format) {
+    if (strcmp(name, "full") == 0) {
+        *format = STREAM_FULL;
+    } else if (strcmp(name, "delta") == 0) {
+        *format = STREAM_DELTA;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+struct FrameStream {
+    pthread_t thread;
+    int fd;
+    bool closeFd;
+    StreamFormat format;
+
+    pthread_mutex_t mutex;
+    // Signalled when a frame is submitted, or on shutdown.
+    pthread_cond_t submitted;
+    // Signalled when the thread finishes writing a frame.
+    pthread_cond_t drained;
+    // Frames waiting are the nqueued slots from first on, around the ring,
+    // and belong to the writer thread from submission until written.  The
+    // rest belong to submitStreamFrame().
+    Board *slots;
+    uint64_t *ticks;
+    unsigned int nslots;
+    unsigned int first;
+    unsigned int nqueued;
+    bool failed;
+    bool shuttingDown;
+    uint64_t written;
+    uint64_t dropped;
+
+    // Of the writer thread: the last frame it wrote, for deltas against it,
+    // and the changes of the delta being written.
+    Board previous;
+    StreamChange *changes;
+    size_t changesCapacity;
+    struct iovec iov[STREAM_IOVECS];
+};
+
+// Writes all of iov[0, n), carrying on after short writes, which pipes and
+// sockets make whenever the reader falls behind.  Clobbers iov.
+static bool writeVectors(const int fd, struct iovec *iov, int n) {
+    while (n > 0) {
+        ssize_t done = writev(fd, iov, n);
+        if (done < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        while (n > 0 && (size_t) done >= iov->iov_len) {
+            done -= (ssize_t) iov->iov_len;
+            ++iov;
+            --n;
+        }
+        if (n > 0) {
+            iov->iov_base = (char *) iov->iov_base + done;
+            iov->iov_len -= (size_t) done;
+        }
+    }
+    return true;
+}
+
+static StreamFrameHeader frameHeader(const Board * const board, const StreamFormat format, const uint64_t tick,
+                                     const uint64_t count) {
+    return (StreamFrameHeader) {STREAM_MAGIC, format, tick, board->nrows, board->ncols, board->nalive, count};
+}
+
+// The rows go out straight from the board, a batch of them per writev().
+static bool writeFullFrame(FrameStream * const stream, Board * const board, const uint64_t tick) {
+    clearBoardPadding(board);
+    StreamFrameHeader header = frameHeader(board, STREAM_FULL, tick, board->wordsPerRow);
+    const size_t rowBytes = board->wordsPerRow * sizeof(BoardWord);
+    stream->iov[0] = (struct iovec) {&header, sizeof(header)};
+    int n = 1;
+    for (unsigned int row = 0; row < board->nrows && rowBytes != 0; ++row) {
+        stream->iov[n++] = (struct iovec) {getBoardRow(board, row), rowBytes};
+        if (n == STREAM_IOVECS) {
+            if (!writeVectors(stream->fd, stream->iov, n)) {
+                return false;
+            }
+            n = 0;
+        }
+    }
+    return writeVectors(stream->fd, stream->iov, n);
+}
+
+static void pushChange(FrameStream * const stream, const size_t count, const StreamChange change) {
+    if (count == stream->changesCapacity) {
+        const size_t capacity = stream->changesCapacity == 0 ? 1024 : 2 * stream->changesCapacity;
+        StreamChange * const changes = (StreamChange *) realloc(stream->changes, capacity * sizeof(StreamChange));
+        if (changes == NULL) {
+            fprintf(stderr, "conway: out of memory\n");
+            exit(1);
+        }
+        stream->changes = changes;
+        stream->changesCapacity = capacity;
+    }
+    stream->changes[count] = change;
+}
+
+static bool writeDeltaFrame(FrameStream * const stream, const Board * const board, const uint64_t tick) {
+    const Board * const previous = &stream->previous;
+    const BoardWord mask = lastWordMask(board);
+    size_t count = 0;
+    for (unsigned int row = 0; row < board->nrows; ++row) {
+        const BoardWord * const now = getBoardRow(board, row);
+        const BoardWord * const before = getBoardRow(previous, row);
+        for (unsigned int w = 0; w < board->wordsPerRow; ++w) {
+            BoardWord flipped = now[w] ^ before[w];
+            if (w == board->wordsPerRow - 1) {
+                flipped &= mask;
+            }
+            while (flipped != 0) {
+                const unsigned int bit = lowestBitIndex(flipped);
+                const StreamChange change = {row, w * BOARD_WORD_BITS + bit, (uint32_t) (now[w] >> bit) & 1};
+                pushChange(stream, count++, change);
+                flipped &= flipped - 1;
+            }
+        }
+    }
+    StreamFrameHeader header = frameHeader(board, STREAM_DELTA, tick, count);
+    stream->iov[0] = (struct iovec) {&header, sizeof(header)};
+    stream->iov[1] = (struct iovec) {stream->changes, count * sizeof(StreamChange)};
+    return writeVectors(stream->fd, stream->iov, 2);
+}
+
+// A delta stream keeps each frame it writes to diff the next against, by
+// trading buffers with the slot it came from.
+static bool writeFrame(FrameStream * const stream, Board * const board, const uint64_t tick) {
+    Board * const previous = &stream->previous;
+    const bool delta = stream->format == STREAM_DELTA && previous->storage != NULL
+            && previous->nrows == board->nrows && previous->ncols == board->ncols;
+    const bool ok = delta ? writeDeltaFrame(stream, board, tick) : writeFullFrame(stream, board, tick);
+    if (stream->format == STREAM_DELTA) {
+        const Board swapped = *previous;
+        *previous = *board;
+        *board = swapped;
+    }
+    return ok;
+}
+
+static void *streamMain(void *arg) {
+    FrameStream * const stream = (FrameStream *) arg;
+    // A reader that goes away should fail the write, not kill the process.
+    sigset_t pipeSignal;
+    sigemptyset(&pipeSignal);
+    sigaddset(&pipeSignal, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSignal, NULL);
+
+    pthread_mutex_lock(&stream->mutex);
+    while (true) {
+        while (stream->nqueued == 0 && !stream->shuttingDown) {
+            pthread_cond_wait(&stream->submitted, &stream->mutex);
+        }
+        if (stream->nqueued == 0) {
+            break;
+        }
+        const unsigned int slot = stream->first;
+        pthread_mutex_unlock(&stream->mutex);
+
+        const bool ok = writeFrame(stream, &stream->slots[slot], stream->ticks[slot]);
+
+        pthread_mutex_lock(&stream->mutex);
+        if (ok) {
+            ++stream->written;
+        } else {
+            stream->failed = true;
+            ++stream->dropped;
+        }
+        stream->first = (stream->first + 1) % stream->nslots;
+        --stream->nqueued;
+        pthread_cond_broadcast(&stream->drained);
+    }
+    pthread_mutex_unlock(&stream->mutex);
+    return NULL;
+}
+
+static int openDestination(const char * const destination) {
+    if (strncmp(destination, UNIX_PREFIX, strlen(UNIX_PREFIX)) != 0) {
+        const int fd = open(destination, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        if (fd < 0) {
+            fprintf(stderr, "conway: could not open stream file '%s'\n", destination);
+        }
+        return fd;
+    }
+    const char * const path = destination + strlen(UNIX_PREFIX);
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "conway: socket path '%s' is too long\n", path);
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (const struct sockaddr *) &address, sizeof(address)) != 0) {
+        fprintf(stderr, "conway: could not connect to socket '%s'\n", path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+// Slots are only given a board when first filled, so a reader that keeps up
+// costs a few boards whatever the budget.
+FrameStream *createFrameStream(const char * const destination, const StreamFormat format,
+                               const Board * const board) {
+    const size_t boardBytes = (size_t) (board->nrows + 2) * board->rowStride * sizeof(BoardWord);
+    const size_t budget = STREAM_BUFFER_BYTES / (boardBytes != 0 ? boardBytes : 1);
+    FrameStream *stream = (FrameStream *) calloc(1, sizeof(FrameStream));
+    if (stream != NULL) {
+        stream->nslots = budget < MIN_STREAM_SLOTS ? MIN_STREAM_SLOTS
+                : budget > MAX_STREAM_SLOTS ? MAX_STREAM_SLOTS : (unsigned int) budget;
+        stream->slots = (Board *) calloc(stream->nslots, sizeof(Board));
+        stream->ticks = (uint64_t *) calloc(stream->nslots, sizeof(uint64_t));
+    }
+    if (stream == NULL || stream->slots == NULL || stream->ticks == NULL) {
+        fprintf(stderr, "conway: out of memory\n");
+        if (stream != NULL) {
+            free(stream->slots);
+            free(stream->ticks);
+            free(stream);
+        }
+        return NULL;
+    }
+    stream->format = format;
+    stream->closeFd = strcmp(destination, "-") != 0;
+    if (stream->closeFd) {
+        stream->fd = openDestination(destination);
+    } else {
+        // Frames bypass stdio, so anything it holds must go out first.
+        fflush(stdout);
+        stream->fd = STDOUT_FILENO;
+    }
+    if (stream->fd < 0) {
+        free(stream->slots);
+        free(stream->ticks);
+        free(stream);
+        return NULL;
+    }
+    pthread_mutex_init(&stream->mutex, NULL);
+    pthread_cond_init(&stream->submitted, NULL);
+    pthread_cond_init(&stream->drained, NULL);
+    if (pthread_create(&stream->thread, NULL, streamMain, stream) != 0) {
+        fprintf(stderr, "conway: could not start the stream writer\n");
+        pthread_cond_destroy(&stream->drained);
+        pthread_cond_destroy(&stream->submitted);
+        pthread_mutex_destroy(&stream->mutex);
+        if (stream->closeFd) {
+            close(stream->fd);
+        }
+        free(stream->slots);
+        free(stream->ticks);
+        free(stream);
+        return NULL;
+    }
+    return stream;
+}
+
+bool flushFrameStream(FrameStream * const stream) {
+    pthread_mutex_lock(&stream->mutex);
+    while (stream->nqueued != 0) {
+        pthread_cond_wait(&stream->drained, &stream->mutex);
+    }
+    const bool ok = !stream->failed;
+    pthread_mutex_unlock(&stream->mutex);
+    return ok;
+}
+
+bool destroyFrameStream(FrameStream * const stream) {
+    if (stream == NULL) {
+        return true;
+    }
+    pthread_mutex_lock(&stream->mutex);
+    stream->shuttingDown = true;
+    pthread_cond_signal(&stream->submitted);
+    pthread_mutex_unlock(&stream->mutex);
+    pthread_join(stream->thread, NULL);
+    bool ok = !stream->failed;
+    if (stream->closeFd && close(stream->fd) != 0) {
+        ok = false;
+    }
+    pthread_cond_destroy(&stream->drained);
+    pthread_cond_destroy(&stream->submitted);
+    pthread_mutex_destroy(&stream->mutex);
+    for (unsigned int i = 0; i < stream->nslots; ++i) {
+        destroyBoard(&stream->slots[i]);
+    }
+    free(stream->slots);
+    free(stream->ticks);
+    destroyBoard(&stream->previous);
+    free(stream->changes);
+    free(stream);
+    return ok;
+}
+
+bool submitStreamFrame(FrameStream * const stream, const Board * const board, const uint64_t tick) {
+    pthread_mutex_lock(&stream->mutex);
+    const bool full = stream->failed || stream->nqueued == stream->nslots;
+    const unsigned int slot = (stream->first + stream->nqueued) % stream->nslots;
+    if (full) {
+        ++stream->dropped;
+    }
+    pthread_mutex_unlock(&stream->mutex);
+    if (full) {
+        return false;
+    }
+
+    // The slot isn't queued, so it can be filled without the lock.
+    const bool copied = copyBoard(&stream->slots[slot], board);
+    pthread_mutex_lock(&stream->mutex);
+    if (copied) {
+        stream->ticks[slot] = tick;
+        ++stream->nqueued;
+        pthread_cond_signal(&stream->submitted);
+    } else {
+        ++stream->dropped;
+    }
+    pthread_mutex_unlock(&stream->mutex);
+    return copied;
+}
+
+void frameStreamCounts(FrameStream * const stream, uint64_t * const written, uint64_t * const dropped) {
+    pthread_mutex_lock(&stream->mutex);
+    *written = stream->written;
+    *dropped = stream->dropped;
+    pthread_mutex_unlock(&stream->mutex);
+}
@@ -0,0 +1,85 @@
+#ifndef CONWAY_STREAM_H
+#define CONWAY_STREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "board.h"
+
+// A stream of generations for other programs to read, written to a file,
+// standard output or a Unix socket by a thread of its own.  Each frame is a
+// StreamFrameHeader followed by its payload:
+//
+//  - STREAM_FULL: the board's rows in order, each as its words, so that bit
+//    i of word w of a row is the tile in column w * 64 + i.  count is the
+//    number of words in a row, and bits past ncols are zero.
+//  - STREAM_DELTA: count StreamChanges, one for every tile that differs from
+//    the previous frame of the stream, row by row and then column by column.
+//    The first frame of a delta stream is always full.
+//
+// Everything is in host byte order.  Frames queue up while the reader is
+// slower than the simulation, and one that arrives while the queue is full is
+// dropped rather than waited for, so that a slow reader never holds up the
+// simulation; the ticks of the frames show where.  Deltas are always against
+// the previous frame actually written, so a dropped frame loses nothing but
+// its generation.
+#define STREAM_MAGIC 0x31464743u
+
+typedef enum StreamFormat {
+    STREAM_FULL = 0,
+    STREAM_DELTA = 1
+} StreamFormat;
+
+typedef struct StreamFrameHeader {
+    // STREAM_MAGIC, also telling the reader the byte order.
+    uint32_t magic;
+    // A StreamFormat.
+    uint32_t format;
+    uint64_t tick;
+    uint32_t nrows;
+    uint32_t ncols;
+    uint64_t population;
+    uint64_t count;
+} StreamFrameHeader;
+
+typedef struct StreamChange {
+    uint32_t row;
+    uint32_t col;
+    // 1 if the tile is now alive, 0 if it is now dead.
+    uint32_t alive;
+} StreamChange;
+
+// Looks up a format by its command line name, "full" or "delta".  Returns
+// false if there is no such format.
+bool parseStreamFormat(const char * const name, StreamFormat * const format);
+
+// The writer thread and its buffers.  The internals are private to stream.c.
+typedef struct FrameStream FrameStream;
+
+// Opens destination, which is "-" for standard output, "unix:PATH" to
+// connect to the Unix socket at PATH, or else the path of a file to create,
+// and starts the writer thread, with room to queue as many frames of board's
+// size as fit in a fixed budget.  Returns NULL, having said why on stderr, on
+// failure.
+FrameStream *createFrameStream(const char * const destination, const StreamFormat format,
+                               const Board * const board);
+
+// Waits for every frame still waiting to be written.  Returns false if any
+// write failed.
+bool flushFrameStream(FrameStream * const stream);
+
+// Writes every frame still waiting, stops the thread and closes the
+// destination, unless it is standard output.  Returns false if any write
+// failed.
+bool destroyFrameStream(FrameStream * const stream);
+
+// Copies board's tiles into a free buffer and returns straight away, leaving
+// the thread to write them out from there.  If no buffer is free the frame is
+// dropped and false is returned.  Once a write fails, every frame after it is
+// dropped too.
+bool submitStreamFrame(FrameStream * const stream, const Board * const board, const uint64_t tick);
+
+// Frames written and frames dropped so far.
+void frameStreamCounts(FrameStream * const stream, uint64_t * const written, uint64_t * const dropped);
+
+#endif
@@ -0,0 +1,211 @@
+#include "temporal.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "packed.h"
+
+// Assumed when the size of the L2 cache can't be found.
+#define DEFAULT_CACHE_BYTES (256 * 1024)
+// Tiles are this many words wide, or the board's width if it is narrower, so
+// that the east and west halos add a sixteenth to the work.
+#define TILE_WORDS 32
+// However deep the halo, tiles are at least this tall, even if they then
+// overflow the cache, so that the tile isn't dwarfed by its halo.
+#define MIN_TILE_ROWS 16
+
+static size_t cacheBytes(void) {
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    const long size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (size > 0) {
+        return (size_t) size;
+    }
+#endif
+    return DEFAULT_CACHE_BYTES;
+}
+
+// Both scratch boards take half of the cache, leaving the rest for the rows of
+// the board being read and written.
+bool initTemporalBlocking(TemporalBlocking * const blocking, const Board * const board, const unsigned int depth,
+                          const unsigned int nworkers) {
+    blocking->depth = depth;
+    blocking->tileWords = board->wordsPerRow < TILE_WORDS ? board->wordsPerRow : TILE_WORDS;
+    const size_t rowBytes = (size_t) (blocking->tileWords + 4) * sizeof(BoardWord);
+    const size_t scratchRows = cacheBytes() / 4 / rowBytes;
+    unsigned int tileRows = MIN_TILE_ROWS;
+    if (scratchRows > 2 * (size_t) depth + MIN_TILE_ROWS) {
+        tileRows = (unsigned int) (scratchRows - 2 * (size_t) depth);
+    }
+    blocking->tileRows = tileRows < board->nrows ? tileRows : board->nrows;
+    blocking->nworkers = nworkers;
+    blocking->scratch = (Board *) calloc(2 * (size_t) nworkers, sizeof(Board));
+    if (blocking->scratch == NULL) {
+        blocking->nworkers = 0;
+        return false;
+    }
+    for (unsigned int i = 0; i < 2 * nworkers; ++i) {
+        if (!initBoard(&blocking->scratch[i], blocking->tileRows + 2 * depth,
+                       (blocking->tileWords + 2) * BOARD_WORD_BITS)) {
+            destroyTemporalBlocking(blocking);
+            return false;
+        }
+    }
+    return true;
+}
+
+void destroyTemporalBlocking(TemporalBlocking * const blocking) {
+    for (unsigned int i = 0; i < 2 * blocking->nworkers; ++i) {
+        destroyBoard(&blocking->scratch[i]);
+    }
+    free(blocking->scratch);
+    blocking->scratch = NULL;
+    blocking->nworkers = 0;
+}
+
+static unsigned int wrapIndex(const long long index, const unsigned int n) {
+    const long long wrapped = index % n;
+    return (unsigned int) (wrapped < 0 ? wrapped + n : wrapped);
+}
+
+// The BOARD_WORD_BITS tiles of a torus row from col east, carrying on from the
+// west edge past the east edge.  Ignores the padding past ncols.
+static BoardWord torusRowBits(const BoardWord * const row, const unsigned int ncols, unsigned int col) {
+    if (col % BOARD_WORD_BITS == 0 && col + BOARD_WORD_BITS <= ncols) {
+        return row[col / BOARD_WORD_BITS];
+    }
+    BoardWord bits = 0;
+    unsigned int have = 0;
+    while (have < BOARD_WORD_BITS) {
+        // As many tiles as col's word, the row and bits all have room for.
+        const unsigned int offset = col % BOARD_WORD_BITS;
+        unsigned int n = BOARD_WORD_BITS - offset;
+        if (n > ncols - col) {
+            n = ncols - col;
+        }
+        if (n > BOARD_WORD_BITS - have) {
+            n = BOARD_WORD_BITS - have;
+        }
+        BoardWord chunk = row[col / BOARD_WORD_BITS] >> offset;
+        if (n < BOARD_WORD_BITS) {
+            chunk &= ((BoardWord) 1 << n) - 1;
+        }
+        bits |= chunk << have;
+        have += n;
+        col += n;
+        if (col == ncols) {
+            col = 0;
+        }
+    }
+    return bits;
+}
+
+// One of a worker's scratch boards, cut down to a tile and its halo, with the
+// halo of the cut down board dead.
+static Board scratchView(const Board * const scratch, const unsigned int nrows, const unsigned int ncols) {
+    Board view = *scratch;
+    view.nrows = nrows;
+    view.ncols = ncols;
+    view.wordsPerRow = (ncols + BOARD_WORD_BITS - 1) / BOARD_WORD_BITS;
+    fillBoardHalo(&view, TOPOLOGY_BOUNDED);
+    return view;
+}
+
+// Steps the tile of rows [rowBegin, rowEnd) and words [wordBegin, wordEnd) of
+// src into dst.  On a bounded board, a side of the tile within generations of
+// the board's edge takes its halo only as far as the edge, where the scratch
+// board's dead halo is exactly what lies beyond; those sides stay exact
+// without shrinking, and a scratch board reaching the board's partial last
+// word ends where the board does.  On a torus the halo wraps around, and the
+// scratch columns past the east edge are the board's first columns again, so
+// the scratch board is always whole words wide.
+static TemporalDiff stepTile(const LifeRule * const rule, const Board * const src, Board * const dst,
+                             const Topology topology, const unsigned int generations, const Board * const scratch,
+                             const unsigned int rowBegin, const unsigned int rowEnd,
+                             const unsigned int wordBegin, const unsigned int wordEnd) {
+    const bool torus = topology == TOPOLOGY_TORUS;
+    const bool edgeNorth = !torus && rowBegin <= generations;
+    const bool edgeSouth = !torus && src->nrows - rowEnd <= generations;
+    const unsigned int haloNorth = edgeNorth ? rowBegin : generations;
+    const unsigned int haloSouth = edgeSouth ? src->nrows - rowEnd : generations;
+    const unsigned int haloWest = torus || wordBegin > 0 ? 1 : 0;
+    const unsigned int haloEast = torus || wordEnd < src->wordsPerRow ? 1 : 0;
+    const unsigned int nrows = haloNorth + (rowEnd - rowBegin) + haloSouth;
+    const unsigned int nwords = haloWest + (wordEnd - wordBegin) + haloEast;
+    const unsigned int firstCol = (wordBegin - haloWest) * BOARD_WORD_BITS;
+    const unsigned int ncols = torus || firstCol + nwords * BOARD_WORD_BITS <= src->ncols
+            ? nwords * BOARD_WORD_BITS : src->ncols - firstCol;
+    Board boards[2] = {scratchView(&scratch[0], nrows, ncols), scratchView(&scratch[1], nrows, ncols)};
+
+    for (unsigned int row = 0; row < nrows; ++row) {
+        BoardWord * const out = getBoardRow(&boards[0], row);
+        if (!torus) {
+            const BoardWord * const in = getBoardRow(src, rowBegin - haloNorth + row);
+            memcpy(out, in + (wordBegin - haloWest), nwords * sizeof(BoardWord));
+            continue;
+        }
+        const BoardWord * const in = getBoardRow(src, wrapIndex((long long) rowBegin - haloNorth + row, src->nrows));
+        for (unsigned int w = 0; w < nwords; ++w) {
+            const long long col = ((long long) wordBegin - 1 + w) * BOARD_WORD_BITS;
+            out[w] = torusRowBits(in, src->ncols, wrapIndex(col, src->ncols));
+        }
+    }
+
+    for (unsigned int generation = 1; generation <= generations; ++generation) {
+        const unsigned int first = edgeNorth ? 0 : generation;
+        const unsigned int last = edgeSouth ? nrows : nrows - generation;
+        stepPackedRect(rule, &boards[(generation - 1) & 1], &boards[generation & 1], first, last, 0, nwords);
+    }
+
+    const Board * const final = &boards[generations & 1];
+    const Board * const previous = &boards[(generations - 1) & 1];
+    const unsigned int lastWord = src->wordsPerRow - 1;
+    const BoardWord mask = lastWordMask(src);
+    TemporalDiff diff = {0, 0, false};
+    for (unsigned int row = rowBegin; row < rowEnd; ++row) {
+        const BoardWord * const after = getBoardRow(final, haloNorth + (row - rowBegin)) + haloWest;
+        const BoardWord * const latest = getBoardRow(previous, haloNorth + (row - rowBegin)) + haloWest;
+        const BoardWord * const before = getBoardRow(src, row);
+        BoardWord * const out = getBoardRow(dst, row);
+        for (unsigned int w = wordBegin; w < wordEnd; ++w) {
+            const BoardWord keep = w == lastWord ? mask : ~(BoardWord) 0;
+            const BoardWord word = after[w - wordBegin] & keep;
+            const BoardWord start = before[w] & keep;
+            diff.anyChanged |= (word ^ (latest[w - wordBegin] & keep)) != 0;
+            diff.aliveDelta += (long long) popcountWord(word) - popcountWord(start);
+            diff.flips += popcountWord(word ^ start);
+            out[w] = word;
+        }
+    }
+    return diff;
+}
+
+// Workers take runs of tiles in row major order, so that consecutive tiles
+// share their halo rows in cache.
+TemporalDiff stepTemporalTiles(const TemporalBlocking * const blocking, const LifeRule * const rule,
+                               const Board * const src, Board * const dst, const Topology topology,
+                               const unsigned int generations, const unsigned int worker,
+                               const unsigned int nworkers) {
+    TemporalDiff total = {0, 0, false};
+    if (src->nrows == 0 || src->wordsPerRow == 0) {
+        return total;
+    }
+    const unsigned int tilesDown = (src->nrows + blocking->tileRows - 1) / blocking->tileRows;
+    const unsigned int tilesAcross = (src->wordsPerRow + blocking->tileWords - 1) / blocking->tileWords;
+    const size_t ntiles = (size_t) tilesDown * tilesAcross;
+    const Board * const scratch = blocking->scratch + 2 * (size_t) worker;
+    for (size_t i = ntiles * worker / nworkers; i < ntiles * (worker + 1) / nworkers; ++i) {
+        const unsigned int rowBegin = (unsigned int) (i / tilesAcross) * blocking->tileRows;
+        const unsigned int wordBegin = (unsigned int) (i % tilesAcross) * blocking->tileWords;
+        const unsigned int rowEnd = rowBegin + blocking->tileRows < src->nrows
+                ? rowBegin + blocking->tileRows : src->nrows;
+        const unsigned int wordEnd = wordBegin + blocking->tileWords < src->wordsPerRow
+                ? wordBegin + blocking->tileWords : src->wordsPerRow;
+        const TemporalDiff diff = stepTile(rule, src, dst, topology, generations, scratch,
+                                           rowBegin, rowEnd, wordBegin, wordEnd);
+        total.aliveDelta += diff.aliveDelta;
+        total.flips += diff.flips;
+        total.anyChanged |= diff.anyChanged;
+    }
+    return total;
+}
@@ -0,0 +1,64 @@
+#ifndef CONWAY_TEMPORAL_H
+#define CONWAY_TEMPORAL_H
+
+#include <stdbool.h>
+
+#include "board.h"
+#include "rule.h"
+
+// Temporal blocking for the packed engine.  Once a board outgrows the caches,
+// sweeping it a generation at a time streams all of it through memory every
+// generation, and the kernel waits on memory rather than computing.  Instead
+// the board is cut into tiles small enough that a tile, padded with a halo of
+// its neighbours' tiles as deep as the generations to step, fits in cache
+// twice over.  Each tile is copied with its halo into a pair of scratch
+// boards and stepped there generation after generation, the exact region
+// shrinking by a tile from each side with a halo every generation like a
+// trapezoid in time, and only the tile itself is written back.  Every word of
+// the board is then read and written once per depth generations, at the cost
+// of recomputing the halos, which neighbouring tiles also compute.
+//
+// As in distributed.h, halos are a whole word wide to the east and west, so
+// the depth can't exceed a word's width.  Sides on the edge of a bounded board
+// need no halo, the scratch board's own halo being dead.
+#define MAX_TEMPORAL_DEPTH BOARD_WORD_BITS
+
+typedef struct TemporalBlocking {
+    // Most generations stepped at once.
+    unsigned int depth;
+    // Size of a tile, fixed for the board.
+    unsigned int tileRows;
+    unsigned int tileWords;
+    unsigned int nworkers;
+    // Two scratch boards per worker, big enough for a tile and its halo.
+    Board *scratch;
+} TemporalBlocking;
+
+// Net effect on the board of stepping some tiles.
+typedef struct TemporalDiff {
+    long long aliveDelta;
+    // Tiles whose state differs from generations ago.
+    unsigned long long flips;
+    // Whether any tile changed in the last of the generations.
+    bool anyChanged;
+} TemporalDiff;
+
+// Sizes tiles for board and the caches of this machine, and allocates the
+// scratch boards of nworkers workers stepping up to depth generations at
+// once.  Returns false, leaving blocking empty, if the allocation fails.
+bool initTemporalBlocking(TemporalBlocking * const blocking, const Board * const board, const unsigned int depth,
+                          const unsigned int nworkers);
+
+void destroyTemporalBlocking(TemporalBlocking * const blocking);
+
+// Steps worker's share of the tiles of src, out of nworkers, generations on
+// under rule into dst, which must be the same size as src and the board the
+// blocking was sized for.  generations must be between 1 and the depth.
+// Neither src's halo nor dst's nalive is used.  Workers only write their own
+// scratch boards and tiles of dst, so they can run concurrently.
+TemporalDiff stepTemporalTiles(const TemporalBlocking * const blocking, const LifeRule * const rule,
+                               const Board * const src, Board * const dst, const Topology topology,
+                               const unsigned int generations, const unsigned int worker,
+                               const unsigned int nworkers);
+
+#endif
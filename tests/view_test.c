@@ -0,0 +1,67 @@
+// Checks that the Hashlife and sparse engines show the same window of the
+// same universe wherever the window is moved, the columns of the window's
+// corner included whatever their alignment with words and leaves.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "board.h"
+#include "pattern.h"
+#include "simulation.h"
+
+#define VIEW_ROWS 40
+#define VIEW_COLS 150
+#define GENERATIONS 300
+
+static void startSimulation(Simulation * const sim, const Board * const pattern, const StepEngine engine) {
+    Board board;
+    if (!initBoard(&board, VIEW_ROWS, VIEW_COLS)) {
+        exit(1);
+    }
+    blitBoard(&board, pattern, VIEW_ROWS / 2, VIEW_COLS / 2);
+    if (!initSimulation(sim, board)) {
+        exit(1);
+    }
+    sim->engine = engine;
+    sim->recordChanges = false;
+    for (unsigned int i = 0; i < GENERATIONS; ++i) {
+        stepSimulation(sim);
+    }
+}
+
+int main(const int argc, char * const argv[]) {
+    Board pattern;
+    if (argc != 2 || !loadPattern(argv[1], &pattern, NULL)) {
+        fprintf(stderr, "usage: view_test PATTERN\n");
+        return 2;
+    }
+    Simulation hashlife;
+    Simulation sparse;
+    startSimulation(&hashlife, &pattern, ENGINE_HASHLIFE);
+    startSimulation(&sparse, &pattern, ENGINE_SPARSE);
+
+    unsigned int failures = 0;
+    for (int64_t row = -9; row <= 9; row += 3) {
+        for (int64_t col = -70; col <= 70; ++col) {
+            setSimulationView(&hashlife, row, col);
+            setSimulationView(&sparse, row, col);
+            const Board * const a = &hashlife.logicalBoard;
+            const Board * const b = &sparse.logicalBoard;
+            bool same = a->nalive == b->nalive;
+            for (unsigned int r = 0; r < VIEW_ROWS && same; ++r) {
+                for (unsigned int c = 0; c < VIEW_COLS && same; ++c) {
+                    same = getTileState(a, r, c) == getTileState(b, r, c);
+                }
+            }
+            if (!same) {
+                printf("view (%lld, %lld): hashlife shows %u tiles, sparse %u\n", (long long) row, (long long) col,
+                       a->nalive, b->nalive);
+                ++failures;
+            }
+        }
+    }
+    destroySimulation(&hashlife);
+    destroySimulation(&sparse);
+    destroyBoard(&pattern);
+    return failures == 0 ? 0 : 1;
+}
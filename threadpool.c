@@ -0,0 +1,141 @@
+#include "threadpool.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+struct ThreadPool {
+    pthread_t *threads;
+    unsigned int nworkers;
+
+    pthread_mutex_t mutex;
+    // Signalled when a new round of work is posted, or on shutdown.
+    pthread_cond_t workPosted;
+    // Signalled when the last worker of a round finishes.
+    pthread_cond_t workDone;
+    // Incremented for every round, so workers can tell a new round from a
+    // spurious wakeup.
+    unsigned long round;
+    unsigned int remaining;
+    bool shuttingDown;
+
+    ThreadPoolTask task;
+    void *context;
+};
+
+typedef struct WorkerArgs {
+    ThreadPool *pool;
+    unsigned int worker;
+} WorkerArgs;
+
+static void *workerMain(void *arg) {
+    WorkerArgs args = *(WorkerArgs *) arg;
+    free(arg);
+    ThreadPool * const pool = args.pool;
+
+    unsigned long seenRound = 0;
+    pthread_mutex_lock(&pool->mutex);
+    while (true) {
+        while (pool->round == seenRound && !pool->shuttingDown) {
+            pthread_cond_wait(&pool->workPosted, &pool->mutex);
+        }
+        if (pool->shuttingDown) {
+            break;
+        }
+        seenRound = pool->round;
+        ThreadPoolTask task = pool->task;
+        void *context = pool->context;
+        pthread_mutex_unlock(&pool->mutex);
+
+        task(context, args.worker, pool->nworkers);
+
+        pthread_mutex_lock(&pool->mutex);
+        if (--pool->remaining == 0) {
+            pthread_cond_signal(&pool->workDone);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+ThreadPool *createThreadPool(const unsigned int nworkers) {
+    if (nworkers == 0) {
+        return NULL;
+    }
+    ThreadPool *pool = (ThreadPool *) calloc(1, sizeof(ThreadPool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->threads = (pthread_t *) calloc(nworkers, sizeof(pthread_t));
+    if (pool->threads == NULL) {
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->workPosted, NULL);
+    pthread_cond_init(&pool->workDone, NULL);
+
+    // Worker 0 is the calling thread, so it has no pthread of its own.
+    pool->nworkers = 1;
+    for (unsigned int i = 1; i < nworkers; ++i) {
+        WorkerArgs *args = (WorkerArgs *) malloc(sizeof(WorkerArgs));
+        if (args == NULL) {
+            destroyThreadPool(pool);
+            return NULL;
+        }
+        args->pool = pool;
+        args->worker = i;
+        if (pthread_create(&pool->threads[i], NULL, workerMain, args) != 0) {
+            free(args);
+            destroyThreadPool(pool);
+            return NULL;
+        }
+        pool->nworkers++;
+    }
+    return pool;
+}
+
+void destroyThreadPool(ThreadPool * const pool) {
+    if (pool == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool->mutex);
+    pool->shuttingDown = true;
+    pthread_cond_broadcast(&pool->workPosted);
+    pthread_mutex_unlock(&pool->mutex);
+    for (unsigned int i = 1; i < pool->nworkers; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_cond_destroy(&pool->workDone);
+    pthread_cond_destroy(&pool->workPosted);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool->threads);
+    free(pool);
+}
+
+unsigned int threadPoolSize(const ThreadPool * const pool) {
+    return pool->nworkers;
+}
+
+void runOnThreadPool(ThreadPool * const pool, ThreadPoolTask task, void *context) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->task = task;
+    pool->context = context;
+    pool->remaining = pool->nworkers - 1;
+    pool->round++;
+    pthread_cond_broadcast(&pool->workPosted);
+    pthread_mutex_unlock(&pool->mutex);
+
+    task(context, 0, pool->nworkers);
+
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->remaining != 0) {
+        pthread_cond_wait(&pool->workDone, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+unsigned int availableProcessors(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (unsigned int) n : 1;
+}
@@ -0,0 +1,31 @@
+#ifndef CONWAY_THREADPOOL_H
+#define CONWAY_THREADPOOL_H
+
+#include <stdbool.h>
+
+// A fixed set of worker threads, created once and reused for every tick, that
+// all run the same task together.  The pool's internals are private to
+// threadpool.c.
+typedef struct ThreadPool ThreadPool;
+
+// Run once on every worker for each runOnThreadPool() call.  worker is in
+// [0, nworkers) and identifies which share of the work to do.
+typedef void (*ThreadPoolTask)(void *context, const unsigned int worker, const unsigned int nworkers);
+
+// Creates a pool of nworkers workers, one of which is the thread that calls
+// runOnThreadPool(), so nworkers - 1 threads are started.  Returns NULL on
+// failure.
+ThreadPool *createThreadPool(const unsigned int nworkers);
+
+void destroyThreadPool(ThreadPool * const pool);
+
+unsigned int threadPoolSize(const ThreadPool * const pool);
+
+// Runs task on every worker and returns once all of them have finished, so
+// successive calls are separated by a barrier.
+void runOnThreadPool(ThreadPool * const pool, ThreadPoolTask task, void *context);
+
+// Number of processors available, for sizing pools.
+unsigned int availableProcessors(void);
+
+#endif
@@ -0,0 +1,143 @@
+#include "zoom.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Density glyphs, from empty to full.
+static const char densityRamp[] = " .:-=+*#%@";
+#define DENSITY_LEVELS (sizeof(densityRamp) - 1)
+
+bool parseZoom(const char * const text, Zoom * const zoom) {
+    if (strcmp(text, "half") == 0) {
+        *zoom = (Zoom) {ZOOM_HALF_BLOCK, 2, 1};
+        return true;
+    }
+    if (strcmp(text, "braille") == 0) {
+        *zoom = (Zoom) {ZOOM_BRAILLE, 4, 2};
+        return true;
+    }
+    char *end;
+    const unsigned long n = strtoul(text, &end, 10);
+    if (end == text || *end != '\0' || n == 0 || n > 0xffff) {
+        return false;
+    }
+    *zoom = n == 1 ? TILE_ZOOM : (Zoom) {ZOOM_DENSITY, (unsigned int) n, (unsigned int) n};
+    return true;
+}
+
+// For blocks at most two tiles wide, which never straddle a word.  The code
+// of a character holds its block row by row, blockCols bits per row, with the
+// west tile lowest.
+static void downsampleNarrow(const Board * const board, const Zoom zoom, const unsigned int charRow,
+                             uint8_t * const codes, const unsigned int ncodes) {
+    const BoardWord *rows[4];
+    unsigned int nrows = 0;
+    for (unsigned int r = 0; r < zoom.blockRows; ++r) {
+        const unsigned int row = charRow * zoom.blockRows + r;
+        if (row < board->nrows) {
+            rows[nrows++] = getBoardRow(board, row);
+        }
+    }
+    const unsigned int charsPerWord = BOARD_WORD_BITS / zoom.blockCols;
+    const BoardWord colMask = ((BoardWord) 1 << zoom.blockCols) - 1;
+    for (unsigned int c = 0, w = 0; c < ncodes; c += charsPerWord, ++w) {
+        const unsigned int n = ncodes - c < charsPerWord ? ncodes - c : charsPerWord;
+        BoardWord words[4];
+        BoardWord any = 0;
+        for (unsigned int r = 0; r < nrows; ++r) {
+            words[r] = w < board->wordsPerRow ? rows[r][w] : 0;
+            any |= words[r];
+        }
+        if (any == 0) {
+            memset(codes + c, 0, n);
+            continue;
+        }
+        for (unsigned int k = 0; k < n; ++k) {
+            unsigned int code = 0;
+            for (unsigned int r = 0; r < nrows; ++r) {
+                code |= (unsigned int) ((words[r] >> (k * zoom.blockCols)) & colMask) << (r * zoom.blockCols);
+            }
+            codes[c + k] = (uint8_t) code;
+        }
+    }
+}
+
+// Live tiles in columns [begin, end) of a row, a word at a time.
+static unsigned int countRowTiles(const BoardWord * const words, const unsigned int begin, const unsigned int end) {
+    if (begin >= end) {
+        return 0;
+    }
+    const unsigned int first = begin / BOARD_WORD_BITS;
+    const unsigned int last = (end - 1) / BOARD_WORD_BITS;
+    const BoardWord firstMask = ~(BoardWord) 0 << (begin % BOARD_WORD_BITS);
+    const unsigned int endBit = end % BOARD_WORD_BITS;
+    const BoardWord lastMask = endBit == 0 ? ~(BoardWord) 0 : ((BoardWord) 1 << endBit) - 1;
+    if (first == last) {
+        return popcountWord(words[first] & firstMask & lastMask);
+    }
+    unsigned int count = popcountWord(words[first] & firstMask) + popcountWord(words[last] & lastMask);
+    for (unsigned int w = first + 1; w < last; ++w) {
+        count += popcountWord(words[w]);
+    }
+    return count;
+}
+
+// The code of a character is its density level, 0 only if its block is empty.
+static void downsampleDensity(const Board * const board, const Zoom zoom, const unsigned int charRow,
+                              uint8_t * const codes, const unsigned int ncodes) {
+    memset(codes, 0, ncodes);
+    const unsigned int rowBegin = charRow * zoom.blockRows;
+    if (rowBegin >= board->nrows) {
+        return;
+    }
+    const unsigned int rowEnd = board->nrows - rowBegin < zoom.blockRows ? board->nrows : rowBegin + zoom.blockRows;
+    const uint64_t blockTiles = (uint64_t) zoom.blockRows * zoom.blockCols;
+    for (unsigned int c = 0; c < ncodes; ++c) {
+        const uint64_t colBegin = (uint64_t) c * zoom.blockCols;
+        if (colBegin >= board->ncols) {
+            break;
+        }
+        const unsigned int colEnd = board->ncols - colBegin < zoom.blockCols
+                ? board->ncols : (unsigned int) colBegin + zoom.blockCols;
+        uint64_t count = 0;
+        for (unsigned int row = rowBegin; row < rowEnd; ++row) {
+            count += countRowTiles(getBoardRow(board, row), (unsigned int) colBegin, colEnd);
+        }
+        if (count != 0) {
+            codes[c] = (uint8_t) (1 + (count - 1) * (DENSITY_LEVELS - 1) / blockTiles);
+        }
+    }
+}
+
+void downsampleRow(const Board * const board, const Zoom zoom, const unsigned int charRow, uint8_t * const codes,
+                   const unsigned int ncodes) {
+    if (zoom.glyphs == ZOOM_DENSITY) {
+        downsampleDensity(board, zoom, charRow, codes, ncodes);
+    } else {
+        downsampleNarrow(board, zoom, charRow, codes, ncodes);
+    }
+}
+
+// Braille dot bit of each tile of a 2x4 block, in the order of the tiles in a
+// narrow code.
+static const uint8_t brailleDots[8] = {0x01, 0x08, 0x02, 0x10, 0x04, 0x20, 0x40, 0x80};
+
+unsigned int zoomGlyph(const Zoom zoom, const uint8_t code) {
+    switch (zoom.glyphs) {
+    case ZOOM_HALF_BLOCK: {
+        static const unsigned int halfBlocks[4] = {' ', 0x2580, 0x2584, 0x2588};
+        return halfBlocks[code & 3];
+    }
+    case ZOOM_BRAILLE: {
+        unsigned int dots = 0;
+        for (unsigned int i = 0; i < 8; ++i) {
+            dots |= ((code >> i) & 1u) * brailleDots[i];
+        }
+        return dots == 0 ? ' ' : 0x2800 + dots;
+    }
+    case ZOOM_DENSITY:
+        return (unsigned char) densityRamp[code];
+    default:
+        return code != 0 ? 'X' : ' ';
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef CONWAY_ZOOM_H
+#define CONWAY_ZOOM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "board.h"
+
+// How a block of tiles is drawn as a single character.
+typedef enum ZoomGlyphs {
+    // One tile per character, 'X' if alive.
+    ZOOM_TILES,
+    // Two tiles above each other per character, as Unicode half blocks.
+    ZOOM_HALF_BLOCK,
+    // Two by four tiles per character, as Unicode Braille dots.
+    ZOOM_BRAILLE,
+    // An N by N block per character, as an ASCII glyph of its density.
+    ZOOM_DENSITY
+} ZoomGlyphs;
+
+typedef struct Zoom {
+    ZoomGlyphs glyphs;
+    // Tiles per character.
+    unsigned int blockRows;
+    unsigned int blockCols;
+} Zoom;
+
+#define TILE_ZOOM ((Zoom) {ZOOM_TILES, 1, 1})
+
+// Parses "1", "half", "braille" or a density block size of 2 or more.
+// Returns false if text is none of these.
+bool parseZoom(const char * const text, Zoom * const zoom);
+
+// Whether the glyphs are outside ASCII, so that they need a wide character
+// curses.
+static inline bool zoomNeedsUnicode(const Zoom zoom) {
+    return zoom.glyphs == ZOOM_HALF_BLOCK || zoom.glyphs == ZOOM_BRAILLE;
+}
+
+// Computes the glyph codes of characters [0, ncodes) of character row charRow
+// of board: the block of tiles under each is summarised a word of tiles at a
+// time, and whole words of dead tiles are skipped.  Blocks may run off the
+// board's edges, where tiles count as dead.
+void downsampleRow(const Board * const board, const Zoom zoom, const unsigned int charRow, uint8_t * const codes,
+                   const unsigned int ncodes);
+
+// The Unicode code point drawn for a glyph code of zoom.
+unsigned int zoomGlyph(const Zoom zoom, const uint8_t code);
+
+#endif